@@ -0,0 +1,55 @@
+﻿// # Copyright © Stuart Millman <stu.millman15@gmail.com>
+
+using System.Runtime.InteropServices;
+
+namespace Rune
+{
+    /// <summary>
+    /// Counters and timings of a rendered frame. Layout must match Rune::RenderStats.
+    /// </summary>
+    [StructLayout(LayoutKind.Sequential)]
+    public struct RenderStats
+    {
+        public uint drawCalls;
+        public uint instances;
+        public ulong triangles;
+
+        public uint programBinds;
+        public uint vaoBinds;
+        public uint textureBinds;
+        public uint uniformBufferBinds;
+        public uint storageBufferBinds;
+        public uint redundantCallsSkipped;
+
+        public ulong bytesUploaded;
+
+        public uint programCacheHits;
+        public uint programBinaryLoads;
+        public uint programCacheMisses;
+
+        public uint visibleRenderables;
+        public uint culledRenderables;
+
+        public uint shadowViewsRendered;
+        public uint shadowViewsCached;
+
+        public uint textureMipsStreamed;
+        public uint textureMipsEvicted;
+        public uint textureMipsReloaded;
+        public uint texturesStreaming;
+        public ulong textureResidentBytes;
+
+        public float cullTime;
+        public float sortTime;
+        public float submitTime;
+    }
+
+    public static class Graphics
+    {
+        public static RenderStats GetLastFrameStats()
+        {
+            InternalCalls.Graphics_GetLastFrameStats(out RenderStats stats);
+            return stats;
+        }
+    }
+}
\ No newline at end of file
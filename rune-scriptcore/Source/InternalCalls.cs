@@ -23,5 +23,8 @@ namespace Rune
 
         [MethodImpl(MethodImplOptions.InternalCall)]
         internal static extern bool Input_IsKeyHeld(int key);
+
+        [MethodImpl(MethodImplOptions.InternalCall)]
+        internal static extern void Graphics_GetLastFrameStats(out RenderStats outStats);
     }
 }
\ No newline at end of file
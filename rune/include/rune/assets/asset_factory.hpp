@@ -4,6 +4,8 @@
 
 #include "asset.hpp"
 #include "rune/macros.hpp"
+#include "rune/graphics/vertex.hpp"
+#include "rune/graphics/mesh.hpp"
 
 #include <string>
 #include <vector>
@@ -30,6 +32,12 @@ namespace Rune
         auto createFromFile(const std::string& filename) -> Owned<Asset> override;
 
     private:
+        /**
+         * Append simplified versions of every submesh to the indices, each level about half the triangles of the last,
+         * and record their ranges in the mesh's submeshes.
+         * @return Index range of each whole-mesh level, to be set on the mesh after its indices. Empty if nothing simplified.
+         */
+        static auto generateLods(Mesh& mesh, const std::vector<Vertex>& vertices, std::vector<u32>& indices) -> std::vector<Mesh::Lod>;
     };
 
     class ShaderFactory : public AssetFactory
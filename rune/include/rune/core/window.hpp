@@ -67,6 +67,6 @@ namespace Rune
             CursorMode cursorMode;
         };
         WindowData m_data;
-        void* m_windowPtr;
+        void* m_windowPtr = nullptr;
     };
 }
@@ -0,0 +1,61 @@
+// # Copyright  Stuart Millman <stu.millman15@gmail.com>
+
+#pragma once
+
+#include "rune/defines.hpp"
+
+namespace Rune
+{
+    enum class RenderPass : u8
+    {
+        eShadow = 0,
+        eDepthPrePass,
+        eGeometry,
+    };
+
+    /**
+     * Decoded fields of a draw key.
+     */
+    struct DrawKeyFields
+    {
+        RenderPass pass;
+        bool isTranslucent;
+        u32 program;
+        u32 materialInst;
+        u32 mesh;
+        u32 submesh;
+        u32 lod;
+        u16 depth;
+    };
+
+    /**
+     * 64bit keys used to sort draws so that submission minimises state changes.
+     *
+     * Opaque layout (MSB -> LSB):
+     *   pass (4) | translucent=0 (1) | program (11) | material instance (13) | mesh (12) | submesh (4) | lod (3) | depth (16)
+     *
+     * Translucent layout (MSB -> LSB):
+     *   pass (4) | translucent=1 (1) | inverted depth (16) | program (11) | material instance (13) | mesh (12) | submesh (4) | lod (3)
+     *
+     * Opaque draws are grouped by state and then sorted front-to-back, translucent draws are sorted back-to-front.
+     * Ids wider than their field are truncated, which only affects grouping, never correctness.
+     */
+    namespace DrawKey
+    {
+        constexpr u32 PassBits = 4;
+        constexpr u32 ProgramBits = 11;
+        constexpr u32 MaterialInstBits = 13;
+        constexpr u32 MeshBits = 12;
+        constexpr u32 SubmeshBits = 4;
+        constexpr u32 LodBits = 3;
+        constexpr u32 DepthBits = 16;
+
+        auto encode(RenderPass pass, bool isTranslucent, u32 program, u32 materialInst, u32 mesh, u32 submesh, u32 lod, u16 depth) -> u64;
+        auto decode(u64 key) -> DrawKeyFields;
+
+        /**
+         * @return View-space depth quantized to 16bits. Monotonic for all depths >= 0 (negative depths map to 0).
+         */
+        auto quantizeDepth(f32 viewDepth) -> u16;
+    }
+}
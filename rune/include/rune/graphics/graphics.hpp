@@ -4,9 +4,18 @@
 
 #include "graphics.hpp"
 #include "rune/defines.hpp"
+#include "draw_key.hpp"
 #include "mesh.hpp"
 #include "texture.hpp"
+#include "texture_streamer.hpp"
 #include "material.hpp"
+#include "render_stats.hpp"
+#include "light.hpp"
+#include "light_clusters.hpp"
+#include "shadow_pass.hpp"
+#include "rune/maths/bounds.hpp"
+#include "rune/maths/culling.hpp"
+#include "rune/utility/thread_pool.hpp"
 
 #include <array>
 
@@ -19,40 +28,116 @@ namespace Rune
         eNone = 0,
         eOpenGL,
         eDirectX,
-        eVulkan
+        eVulkan,
+        eNull  // Records commands without a GPU, eg. for headless runs
     };
 
     class RendererBase;
 
-    struct Light
+    /**
+     * Binding points reserved by the engine in shaders
+     */
+    namespace ShaderBindings
     {
-        glm::vec3 position;
-        int isDirectional;
-        glm::vec4 direction;
+        constexpr u32 SceneUniformBuffer = 0;
+        constexpr u32 LightingUniformBuffer = 1;
+        constexpr u32 InstanceStorageBuffer = 4;
+        constexpr u32 LightStorageBuffer = 5;
+        constexpr u32 LightClusterStorageBuffer = 6;
+        constexpr u32 LightIndexStorageBuffer = 7;
+        constexpr u32 ShadowUniformBuffer = 8;
+
+        /* Texture units */
+        constexpr u32 CascadeShadowMapTexture = 8;
+        constexpr u32 PointShadowMapTexture = 9;
+
+        /**
+         * @return True if the graphics system binds this uniform buffer itself, so materials must not own a buffer for it.
+         */
+        constexpr bool isEngineUniformBuffer(const u32 binding)
+        {
+            return binding == SceneUniformBuffer || binding == LightingUniformBuffer || binding == ShadowUniformBuffer;
+        }
+
+        /**
+         * @return True if the graphics system binds this texture unit itself, so materials must not have a slot for it.
+         */
+        constexpr bool isEngineTexture(const u32 binding)
+        {
+            return binding == CascadeShadowMapTexture || binding == PointShadowMapTexture;
+        }
+    }
 
-        float constant;
-        float linear;
-        float quadratic;
+    struct Renderable
+    {
+        Mesh* mesh;
+        MaterialInst* materialInst;
 
-        glm::vec4 diffuseColor;
-        glm::vec4 specularColor;
+        glm::mat4 worldMatrix;
     };
 
-    struct Lighting
+    /**
+     * Number of state changes and draw calls issued while submitting a frame
+     */
+    struct DrawBindCounts
     {
-        glm::vec4 viewPos = {};
-        glm::vec3 ambient = { 0.2, 0.2f, 0.2f };
+        u32 programBinds = 0;
+        u32 materialBinds = 0;
+        u32 meshBinds = 0;
+        u32 drawCalls = 0;
+    };
 
-        i32 lightCount = 0;
-        std::array<Light, 32> lights{};
+    /**
+     * Number of renderables that passed/failed frustum culling in a frame
+     */
+    struct DrawCullCounts
+    {
+        u32 visible = 0;
+        u32 culled = 0;
     };
 
-    struct Renderable
+    /**
+     * How mesh LODs are picked from the screen size of each renderable
+     */
+    struct LodSettings
     {
-        Mesh* mesh;
-        MaterialInst* materialInst;
+        bool enabled = true;
+        f32 maxPixelError = 1.0f;  // Coarsest LOD whose simplification error covers at most this many pixels is used
+        f32 hysteresis = 0.1f;     // Fraction the screen size must move past a switch point before changing back
+    };
 
-        glm::mat4 worldMatrix;
+    /**
+     * Range of the renderer's per-frame buffer, returned by RendererBase::uploadFrameData().
+     * Only valid until the end of the frame it was uploaded in.
+     */
+    struct FrameDataRange
+    {
+        size byteOffset = 0;
+        size byteSize = 0;
+        u32 buffer = 0;  // Renderer specific, the per-frame buffer may be replaced part way through a frame
+    };
+
+    /**
+     * Range of a buffer updated by RendererBase::updateBufferRanges()
+     */
+    struct BufferRangeUpdate
+    {
+        u32 bufferId;
+        u32 byteOffset;  // Within the buffer
+        u32 byteSize;
+        u32 dataOffset;  // Within the data of the whole update
+    };
+
+    /**
+     * One mesh drawn as part of a RendererBase::drawIndirect() call
+     */
+    struct DrawCommand
+    {
+        Mesh* mesh;
+        u32 instanceCount;
+        u32 firstInstance;
+        u32 lod = 0;
+        u32 submesh = Mesh::AllSubmeshes;
     };
 
     class GraphicsSystem
@@ -72,24 +157,147 @@ namespace Rune
         void setRenderingApi(RenderingApi renderingApi);
 
         auto getRenderer() const -> RendererBase*;
+        /**
+         * @return Workers shared by frame building and asset imports, which both run on the main thread.
+         */
+        auto getThreadPool() -> ThreadPool&;
 
         auto getWindow() const -> WindowSystem*;
         void setWindow(WindowSystem* window);
 
         void beginScene(const glm::mat4 proj, const glm::mat4& view, const Lighting& lighting);
 
-        void addRenderable(const glm::mat4& transform, Mesh* mesh, MaterialInst* material);
+        /**
+         * @param isStatic Static renderables are expected to rarely move, so their shadows are cached between frames.
+         * @param lodState Where the renderable's LOD is kept between frames, for hysteresis. Without it the LOD is picked fresh
+         * every frame.
+         */
+        void addRenderable(const glm::mat4& transform, Mesh* mesh, MaterialInst* material, bool isStatic = false, u8* lodState = nullptr);
+        /**
+         * Draw each submesh with its own material instance, all from the mesh's one set of buffers.
+         * @param submeshMaterials Material of each submesh. Submeshes past the end or without one use the first.
+         */
+        void addRenderable(const glm::mat4& transform,
+                           Mesh* mesh,
+                           const std::vector<MaterialInst*>& submeshMaterials,
+                           bool isStatic = false,
+                           u8* lodState = nullptr);
 
         void render();
 
+        /**
+         * Sorting can be disabled to compare against submitting in insertion order.
+         */
+        bool isDrawSortingEnabled() const;
+        void setDrawSortingEnabled(bool enabled);
+
+        auto getLastFrameBindCounts() const -> const DrawBindCounts&;
+
+        /**
+         * @return Counters and timings of the last rendered frame.
+         */
+        auto getLastFrameStats() const -> const RenderStats&;
+
+        /**
+         * Write the stats of every frame to a file until stopped. The format (CSV or JSON) is chosen by the file extension.
+         */
+        bool startStatsCapture(const std::string& filename);
+        void stopStatsCapture();
+
+        /**
+         * When enabled, runs of draws sharing a mesh and material instance are merged into a single instanced draw.
+         * Only applies to materials whose shader reads instance data (see Material::supportsInstancing()), when disabled those
+         * are still drawn through the instance buffer but with one instance per draw.
+         */
+        bool isInstancingEnabled() const;
+        void setInstancingEnabled(bool enabled);
+
+        /**
+         * When enabled, consecutive instanced batches sharing a material instance are submitted as a single multi-draw indirect call.
+         */
+        bool isMultiDrawIndirectEnabled() const;
+        void setMultiDrawIndirectEnabled(bool enabled);
+
+        bool isFrustumCullingEnabled() const;
+        void setFrustumCullingEnabled(bool enabled);
+
+        auto getLastFrameCullCounts() const -> const DrawCullCounts&;
+
+        auto getShadowSettings() const -> const ShadowSettings&;
+        void setShadowSettings(const ShadowSettings& settings);
+
+        /**
+         * When enabled, visible opaque draws are first rendered front-to-back to depth only, so the main pass only shades
+         * the closest surface of each pixel. Worth it for scenes with expensive fragment shaders and lots of overdraw.
+         */
+        bool isDepthPrePassEnabled() const;
+        void setDepthPrePassEnabled(bool enabled);
+
+        auto getLodSettings() const -> const LodSettings&;
+        void setLodSettings(const LodSettings& settings);
+
+        /**
+         * @return Streams in the mips of every initialised texture, as requested by each frame's visible renderables.
+         */
+        auto getTextureStreamer() -> TextureStreamer&;
+
+        /**
+         * Upload the instance's changed uniform values with those of every other queued instance, before the next frame is drawn.
+         */
+        void queueUniformUpload(const MaterialInst* materialInst);
+        void cancelUniformUpload(const MaterialInst* materialInst);
+
     private:
         static void initRendererFactories();
 
-        void onFramebufferSize(i32 width, i32 height) const;
-
-        bool canFrustumCull() const;
-
-        static auto buildInstanceKey() -> u32;
+        void onFramebufferSize(i32 width, i32 height);
+
+        /**
+         * Bin the scene's lights into clusters and upload and bind everything the shaders read lighting from.
+         * Also gathers the lights that cast shadows into m_shadowedLights.
+         */
+        void uploadLighting();
+
+        /**
+         * Gather the changed uniform values of every queued material instance and upload them in one batch.
+         */
+        void uploadMaterialUniforms();
+
+        /**
+         * Render the shadow maps from the (mesh sorted) shadow bucket.
+         */
+        void renderShadows();
+
+        /**
+         * Test the world bounds of every renderable against the view frustum, in batches.
+         * Fills m_drawVisibility with a flag per draw data.
+         */
+        void frustumCull();
+
+        /**
+         * Pick the LOD of every renderable from the size of its bounding sphere on screen, and keep that size in its draw data.
+         */
+        void selectLods();
+
+        /**
+         * Request the mip each visible renderable's textures need at its size on screen.
+         */
+        void requestTextureMips();
+
+        struct DrawData;
+        auto buildInstanceKey(RenderPass pass, const DrawData& drawData) const -> u64;
+
+        struct DrawInstance;
+        /**
+         * Collapse a sorted bucket into draw batches, packing the world matrices of instanced batches into m_instanceData.
+         */
+        void buildDrawBatches(const std::vector<DrawInstance>& bucket);
+
+        /**
+         * Collapse the sorted depth pre-pass bucket into draw commands, appending their world matrices to m_instanceData.
+         */
+        void buildDepthPrePass();
+        void renderDepthPrePass();
 
     private:
         RenderingApi m_renderingApi = RenderingApi::eNone;
@@ -104,30 +312,105 @@ namespace Rune
             glm::mat4 world = glm::mat4(1.0f);
         };
         Scene m_sceneData{};
-        u32 m_sceneUbo{};
 
-        Lighting m_lightingData{};
-        u32 m_lightingUbo{};
+        Lighting m_lighting{};
+
+        /* Layout of the lighting uniform buffer. Starts the same as before clustering, so older shaders still see the global lights. */
+        struct LightingUniforms
+        {
+            glm::vec4 viewPos;
+            glm::vec3 ambient;
+            i32 globalLightCount;
+            std::array<Light, Lighting::MaxGlobalLights> globalLights;
+
+            glm::uvec4 clusterGrid;      // Tile count x/y, slice count, clustered light count
+            glm::vec4 clusterDepth;      // Near, far, slice scale, slice bias
+            glm::vec4 clusterTileScale;  // Framebuffer pixels to tiles in xy
+        };
+        LightingUniforms m_lightingUniforms{};
+        std::vector<Light> m_clusteredLights;
+        std::vector<BoundingSphere> m_clusteredLightSpheres;
+        LightClusterGrid m_lightClusters;
+        glm::ivec2 m_framebufferSize = { 1, 1 };
+
+        ThreadPool m_threadPool;
+
+        ShadowPass m_shadowPass;
+        std::vector<u8> m_lightCastsShadows;
+        std::vector<ShadowPass::ShadowedLight> m_shadowedLights;
+        std::vector<ShadowPass::Caster> m_shadowCasters;
+
+        Frustum m_frustum{};
 
         struct DrawData
         {
             Mesh* mesh;
             MaterialInst* material;
+            MaterialInst* batchMaterial;  // Bound in place of material, so draws of instances with the same bindings merge
             glm::mat4 transform;
+            bool isStatic;
+            u32 submesh;  // Mesh::AllSubmeshes to draw the whole mesh
+            u32 lod;
+            u8* lodState;
+            f32 screenSize;  // Pixels covered by the diameter of the mesh's bounding sphere, infinite if unbounded
         };
 
         struct DrawInstance
         {
-            u32 key;
-            size drawDataIndex;
-
-            bool operator<(const DrawInstance& other) const;
+            u64 key;
+            u32 drawDataIndex;
         };
 
         std::vector<DrawData> m_drawData;
 
         std::vector<DrawInstance> m_shadowBucket;
+        std::vector<DrawInstance> m_depthPrePassBucket;
         std::vector<DrawInstance> m_geometryBucket;
+        std::vector<DrawInstance> m_sortScratch;
+
+        struct DrawBatch
+        {
+            u32 drawDataIndex;
+            u32 firstInstance;
+            u32 instanceCount;
+            bool isInstanced;
+        };
+        std::vector<DrawBatch> m_drawBatches;
+
+        std::vector<InstanceData> m_instanceData;
+        bool m_instancingEnabled = true;
+
+        std::vector<DrawCommand> m_drawCommands;
+        bool m_multiDrawIndirectEnabled = true;
+
+        /* Commands drawn with back faces culled come first, followed by those of double sided materials */
+        std::vector<DrawCommand> m_depthPrePassCommands;
+        u32 m_depthPrePassCulledCount = 0;
+        bool m_depthPrePassEnabled = false;
+
+        LodSettings m_lodSettings{};
+
+        TextureStreamer m_textureStreamer;
+
+        /* Kept between frames, so queuing and uploading uniforms does not allocate once they have grown */
+        std::vector<const MaterialInst*> m_uniformUploadQueue;
+        std::vector<BufferRangeUpdate> m_uniformUploadRanges;
+        std::vector<u8> m_uniformUploadData;
+
+        Culling::BoxBatch m_cullBoxes;
+        std::vector<u32> m_cullDrawDataIndices;
+        std::vector<u8> m_cullResults;
+        std::vector<u8> m_drawVisibility;
+
+        bool m_drawSortingEnabled = true;
+        DrawBindCounts m_lastFrameBindCounts{};
+
+        bool m_frustumCullingEnabled = true;
+        DrawCullCounts m_lastFrameCullCounts{};
+
+        RenderStats m_lastFrameStats{};
+        RenderStatsWriter m_statsWriter;
+        u64 m_frameIndex = 0;
     };
 
     class RendererBase
@@ -144,26 +427,130 @@ namespace Rune
         virtual auto createBuffer(size size, const void* data) -> u32 = 0;
         virtual void destroyBuffer(u32 id) = 0;
         virtual void updateBuffer(u32 id, size offset, size size, const void* data) = 0;
-
-        virtual auto createMesh(const std::vector<Vertex>& vertices, const std::vector<u16>& indices, MeshTopology topology) -> u32 = 0;
+        /**
+         * Update many buffer ranges with one upload, rather than one per range.
+         * @param data Bytes of every range, each starting at its data offset.
+         */
+        virtual void updateBufferRanges(const std::vector<BufferRangeUpdate>& ranges, const void* data, size dataSize) = 0;
+
+        /**
+         * Write transient data (that only lives for the current frame) without reallocating or stalling on the GPU.
+         */
+        virtual auto uploadFrameData(const void* data, size size) -> FrameDataRange = 0;
+
+        /**
+         * Vertices are quantized on upload when the encoding's format asks for it.
+         */
+        virtual auto createMesh(const std::vector<Vertex>& vertices,
+                                const std::vector<u32>& indices,
+                                IndexType indexType,
+                                const VertexEncoding& encoding,
+                                MeshTopology topology) -> u32 = 0;
         virtual void destroyMesh(u32 id) = 0;
-        virtual void updateMeshVertices(u32 id, const std::vector<Vertex>& vertices) = 0;
-        virtual void updateMeshIndices(u32 id, const std::vector<u16>& indices) = 0;
+        virtual void updateMeshVertices(u32 id, const std::vector<Vertex>& vertices, const VertexEncoding& encoding) = 0;
+        /**
+         * Indices are narrowed to 16bit on upload when the index type allows it.
+         */
+        virtual void updateMeshIndices(u32 id, const std::vector<u32>& indices, IndexType indexType) = 0;
 
         virtual auto createMaterial(const std::vector<u8>& vertexCode, const std::vector<u8>& fragmentCode) -> u32 = 0;
         virtual void destroyMaterial(u32 id) = 0;
-
-        virtual auto createTexture(u32 width, u32 height, TextureFormat format, const void* data) -> u32 = 0;
+        /**
+         * Directory that linked programs are saved to and loaded from, so later runs skip compiling them. Empty disables.
+         * Must be set before materials are created to take effect for them.
+         */
+        virtual void setProgramCacheDirectory(const std::string& directory) = 0;
+
+        /**
+         * No memory is allocated for mips until they are made resident with setTextureResidentMip().
+         */
+        virtual auto createTexture(u32 width, u32 height, TextureFormat format, u32 mipCount) -> u32 = 0;
         virtual void destroyTexture(u32 id) = 0;
+        /**
+         * @param mip A resident mip.
+         * @param data getTextureDataSize() bytes for the mip's dimensions.
+         */
+        virtual void uploadTextureMip(u32 id, u32 mip, const void* data) = 0;
+        /**
+         * Reallocate the texture to hold only the mips from this one down, and sample from them. Mips that stay resident keep
+         * their contents, newly resident ones must be uploaded before the texture is next sampled.
+         * Reallocating copies every resident mip, so it is only called once per texture per frame however many mips change.
+         */
+        virtual void setTextureResidentMip(u32 id, u32 mip) = 0;
+
+        /**
+         * 2D texture array with storage for every mip of every layer.
+         */
+        virtual auto createTextureArray(u32 width, u32 height, TextureFormat format, u32 mipCount, u32 layerCount) -> u32 = 0;
+        virtual void destroyTextureArray(u32 id) = 0;
+        /**
+         * @param data getTextureDataSize() bytes for the mip's dimensions.
+         */
+        virtual void uploadTextureArrayMip(u32 id, u32 layer, u32 mip, const void* data) = 0;
 
         virtual void beginFrame() = 0;
         virtual void endFrame() = 0;
 
         virtual void bindUniformBuffer(u32 id, u32 binding) = 0;
+        virtual void bindStorageBuffer(u32 id, u32 binding) = 0;
+        virtual void bindFrameUniformBuffer(const FrameDataRange& range, u32 binding) = 0;
+        virtual void bindFrameStorageBuffer(const FrameDataRange& range, u32 binding) = 0;
         virtual void bindMaterial(MaterialInst* material) = 0;
-        virtual void bindMesh(Mesh* mesh) = 0;
+        /**
+         * @param lod Level of detail drawn by following draws, clamped to the levels the mesh has.
+         * @param submesh Submesh drawn by following draws, or Mesh::AllSubmeshes.
+         */
+        virtual void bindMesh(Mesh* mesh, u32 lod, u32 submesh) = 0;
 
         virtual void draw() = 0;
+        virtual void drawInstanced(u32 instanceCount, u32 firstInstance) = 0;
+        /**
+         * Draw several meshes with the bound material in as few calls as possible. Commands are split into one call per run of
+         * meshes sharing a topology, index type and vertex format.
+         */
+        virtual void drawIndirect(const DrawCommand* commands, u32 count) = 0;
+
+        /**
+         * Depth-only 2D texture array that shadow views are rendered into, sampled with depth comparison.
+         */
+        virtual auto createShadowMap(u32 resolution, u32 layerCount) -> u32 = 0;
+        virtual void destroyShadowMap(u32 id) = 0;
+        /**
+         * Copy every layer of a shadow map into another of the same size.
+         */
+        virtual void copyShadowMap(u32 srcId, u32 dstId) = 0;
+        /**
+         * Draws until endShadowPass() only write depth, into one layer of the shadow map. They use the engine's depth program,
+         * which reads the scene and instance buffers, so no material needs binding.
+         */
+        virtual void beginShadowPass(u32 shadowMapId, u32 layer, bool clear) = 0;
+        virtual void endShadowPass() = 0;
+        virtual void bindShadowMap(u32 id, u32 binding) = 0;
+
+        /**
+         * Draws until endDepthPrePass() only write depth to the window's framebuffer, using the same depth program as shadow
+         * passes, so no material needs binding. Depth is offset back slightly, so material vertex shaders that transform
+         * positions the same way (with gl_Position invariant) always pass the main pass's LEQUAL test against it.
+         */
+        virtual void beginDepthPrePass(bool cullBackFaces) = 0;
+        virtual void endDepthPrePass() = 0;
+
+        /**
+         * @return Backend counters (draws, binds and uploads) of the last completed frame.
+         */
+        auto getLastFrameStats() const -> const RenderStats&;
+
+    protected:
+        /**
+         * Make the counters gathered since the last call available through getLastFrameStats() and reset them. Call at the end of a frame.
+         */
+        void finishFrameStats();
+
+    protected:
+        RenderStats m_frameStats{};
+
+    private:
+        RenderStats m_lastFrameStats{};
     };
 
 }
@@ -0,0 +1,48 @@
+// # Copyright  Stuart Millman <stu.millman15@gmail.com>
+
+#pragma once
+
+#include "rune/defines.hpp"
+
+#include <glm/ext/vector_float3.hpp>
+#include <glm/ext/vector_float4.hpp>
+
+#include <vector>
+
+namespace Rune
+{
+    struct Light
+    {
+        glm::vec3 position;
+        int isDirectional;
+        glm::vec4 direction;
+
+        float constant;
+        float linear;
+        float quadratic;
+        float range;  // Distance beyond which the light has no effect. 0 to derive it from the attenuation.
+
+        glm::vec4 diffuseColor;
+        glm::vec4 specularColor;
+    };
+
+    struct Lighting
+    {
+        /* Directional lights, and point lights with neither a range nor attenuation, light everything. Only this many are used. */
+        static constexpr u32 MaxGlobalLights = 32;
+
+        glm::vec4 viewPos = {};
+        glm::vec3 ambient = { 0.2, 0.2f, 0.2f };
+
+        /**
+         * Point lights with a range are binned into view space clusters, so there can be thousands of them.
+         */
+        std::vector<Light> lights;
+
+        /**
+         * Indices into lights of the lights that cast shadows. The first directional light gets cascades,
+         * point lights with a range get a view per cube face (up to ShadowPass::MaxPointLights).
+         */
+        std::vector<u32> shadowCastingLights;
+    };
+}
@@ -0,0 +1,96 @@
+// # Copyright  Stuart Millman <stu.millman15@gmail.com>
+
+#pragma once
+
+#include "rune/defines.hpp"
+#include "rune/maths/bounds.hpp"
+#include "rune/maths/culling.hpp"
+
+#include <glm/ext/matrix_float4x4.hpp>
+
+#include <array>
+#include <vector>
+
+namespace Rune
+{
+    class ThreadPool;
+
+    /**
+     * Range of a cluster's entries in the light index list. Layout matches the LightClusters buffer in shaders.
+     */
+    struct LightCluster
+    {
+        u32 offset;
+        u32 count;
+    };
+
+    /**
+     * Splits the view frustum into froxels (screen tiles by exponentially spaced depth slices) and lists the lights touching each,
+     * so a fragment only has to shade the lights of its own cluster.
+     * Clusters are ordered slice, then tile row, then tile column.
+     */
+    class LightClusterGrid
+    {
+    public:
+        static constexpr u32 TileCountX = 16;
+        static constexpr u32 TileCountY = 9;
+        static constexpr u32 SliceCount = 24;
+        static constexpr u32 TilesPerSlice = TileCountX * TileCountY;
+        static constexpr u32 ClusterCount = TilesPerSlice * SliceCount;
+
+        /**
+         * Rebuild the view space bounds of the clusters. Does nothing if the projection has not changed.
+         * @param proj Perspective projection. Near and far planes are taken from it.
+         */
+        void setProjection(const glm::mat4& proj);
+
+        /**
+         * Bin the lights into clusters, one depth slice per job.
+         * @param lightSpheres View space bounds of each light. The light index list refers to lights by their index in this.
+         */
+        void build(const std::vector<BoundingSphere>& lightSpheres, ThreadPool& threadPool);
+
+        auto getClusters() const -> const std::vector<LightCluster>&;
+        auto getLightIndices() const -> const std::vector<u32>&;
+
+        auto getNearPlane() const -> f32;
+        auto getFarPlane() const -> f32;
+
+        /**
+         * A view depth maps to its slice with log(depth) * scale + bias.
+         */
+        auto getSliceScale() const -> f32;
+        auto getSliceBias() const -> f32;
+
+    private:
+        auto getSlice(f32 viewDepth) const -> u32;
+        void binSlice(u32 slice, const std::vector<BoundingSphere>& lightSpheres);
+
+    private:
+        glm::mat4 m_proj = glm::mat4(0.0f);
+        f32 m_nearPlane = 0.0f;
+        f32 m_farPlane = 0.0f;
+        f32 m_sliceScale = 0.0f;
+        f32 m_sliceBias = 0.0f;
+
+        std::array<f32, SliceCount + 1> m_sliceDepths{};
+        Culling::BoxBatch m_clusterBounds;
+
+        /* Per light slice range, lights outside the depth range have min > max */
+        std::vector<u32> m_lightMinSlice;
+        std::vector<u32> m_lightMaxSlice;
+
+        struct SliceBins
+        {
+            std::vector<u32> overlaps;     // Scratch, tiles overlapped by the current light
+            std::vector<u32> pairTiles;    // Tile of each light/tile pair
+            std::vector<u32> pairLights;   // Light of each light/tile pair
+            std::array<u32, TilesPerSlice> counts{};
+            std::vector<u32> lightIndices;  // Pairs sorted by tile
+        };
+        std::array<SliceBins, SliceCount> m_sliceBins;
+
+        std::vector<LightCluster> m_clusters;
+        std::vector<u32> m_lightIndices;
+    };
+}
@@ -7,14 +7,33 @@
 
 #include <glm/mat4x4.hpp>
 
+#include <string_view>
 #include <unordered_map>
 #include <vector>
 
 namespace Rune
 {
     class Texture;
+    class TextureArray;
     class Shader;
     class MaterialInst;
+    struct BufferRangeUpdate;
+
+    /**
+     * Uniform buffer member found once with Material::findUniform(), so setting it indexes the member rather than looking up
+     * its name. Valid for the material and all of its instances until the material's shader changes.
+     */
+    struct UniformHandle
+    {
+        static constexpr u32 InvalidIndex = ~0u;
+
+        u32 index = InvalidIndex;
+
+        constexpr bool isValid() const
+        {
+            return index != InvalidIndex;
+        }
+    };
 
     /**
      * Handles the pipeline state
@@ -33,10 +52,19 @@ namespace Rune
         {
             std::string name;
             u32 binding;
+            bool isArray;  // Sampled as a layer of a texture array, see packInstanceTextures()
             Texture* texture;
         };
 
+        struct UniformBufferMember
+        {
+            u32 uniformBufferIndex;
+            u32 byteOffset;
+            u32 byteSize;
+        };
+
     public:
+        Material();
         ~Material() override;
 
         auto getShader() const -> Shader*;
@@ -45,9 +73,61 @@ namespace Rune
         auto getDefaultInstance() const -> MaterialInst*;
         auto createInstance() -> MaterialInst*;
 
+        /**
+         * Pack the textures every instance has in each texture array slot into one array, instance textures in the layer given
+         * by MaterialInst::getTextureLayer(). Instances then only differ by their layer, so those with the same uniform values
+         * are drawn together. Call again once instances are added or their array textures change.
+         * @return False if an instance's texture is missing, still being imported, or does not match the others in size, format
+         * and mip count.
+         */
+        bool packInstanceTextures();
+
+        /**
+         * Group instances again by their uniform values and textures before the next MaterialInst::getBatchInst().
+         */
+        void markBatchesDirty();
+        /**
+         * Group instances if any have changed since they were last grouped.
+         */
+        void updateBatchInstances();
+
+        bool isTranslucent() const;
+        void setTranslucent(bool translucent);
+
+        bool isDoubleSided() const;
+        void setDoubleSided(bool doubleSided);
+
+        bool isDepthTested() const;
+        void setDepthTest(bool depthTest);
+
+        /**
+         * @return True if the shader reads per-instance data from the engine instance buffer, allowing draws to be instanced.
+         */
+        bool supportsInstancing() const;
+
+        /**
+         * @param name Binding and member name, eg. "u_material.diffuse".
+         * @return Invalid handle if the shader has no such member.
+         */
+        auto findUniform(std::string_view name) const -> UniformHandle;
+        /**
+         * @param id Hash::fnv1aString() of the member name, which can be hashed at compile time.
+         */
+        auto findUniform(u64 id) const -> UniformHandle;
+
+        /**
+         * @return Nullptr for an invalid handle.
+         */
+        auto getUniformBufferMember(UniformHandle handle) const -> const UniformBufferMember*;
+
+        /* Setters taking a name look the member up every call, prefer handles for values set often */
+        auto getFloat(UniformHandle handle) const -> float;
+        void setFloat(UniformHandle handle, float value) const;
         auto getFloat(const std::string& name) const -> float;
         void setFloat(const std::string& name, float value) const;
 
+        auto getMat4(UniformHandle handle) const -> glm::mat4;
+        void setMat4(UniformHandle handle, const glm::mat4& value) const;
         auto getMat4(const std::string& name) const -> glm::mat4;
         void setMat4(const std::string& name, const glm::mat4& value) const;
 
@@ -61,31 +141,34 @@ namespace Rune
     private:
         void initUniforms();
 
-        struct UniformBufferMember
-        {
-            u32 uniformBufferIndex;
-            u32 byteOffset;
-            u32 byteSize;
-        };
-
-        auto getUniformBufferMember(const std::string& name) const -> const UniformBufferMember*;
+        /**
+         * @return Default instance followed by created instances.
+         */
+        auto getAllInstances() const -> std::vector<MaterialInst*>;
 
     private:
         u32 m_internalId{};
 
         Shader* m_shader = nullptr;
 
-        bool m_doubleSided = false;
+        bool m_doubleSided = true;
         bool m_depthTest = true;
         bool m_alphaTest = false;
+        bool m_translucent = false;
+        bool m_supportsInstancing = false;
 
         Owned<MaterialInst> m_defaultInstance = nullptr;
         std::vector<Owned<MaterialInst>> m_instances;
 
+        std::vector<Owned<TextureArray>> m_textureArrays;
+        bool m_batchesDirty = true;
+
         std::vector<UniformBuffer> m_uniformBuffers;
         std::vector<TextureSlot> m_textures;
 
-        std::unordered_map<std::string, UniformBufferMember> m_uniformMemberMap;
+        /* Shared by every instance, their buffers have the same layout */
+        std::vector<UniformBufferMember> m_uniformMembers;
+        std::unordered_map<u64, u32> m_uniformMemberIndices;  // By member id
         std::unordered_map<std::string, size> m_textureMap;
     };
 
@@ -100,38 +183,84 @@ namespace Rune
             u32 internalId;
             u32 binding;
             Buffer data;
+            /* Bytes changed since the last upload, empty when both are equal */
+            mutable u32 dirtyBegin = 0;
+            mutable u32 dirtyEnd = 0;
         };
 
         struct TextureSlot
         {
             std::string name;
             u32 binding;
+            bool isArray;
             Texture* texture;
+            TextureArray* textureArray;  // Holding texture in this instance's layer, once the material has packed it
         };
 
     public:
+        ~MaterialInst() override;
+
         void init(Material* material);
 
         auto getMaterial() const -> Material*;
 
+        /**
+         * @return Unique id of this instance. Used to group draws when sorting.
+         */
+        auto getId() const -> u32;
+
+        /**
+         * @return Layer of this instance's textures in its material's texture arrays.
+         */
+        auto getTextureLayer() const -> u32;
+
+        /**
+         * @return First instance of the material with the same uniform values and textures, or this instance. Draws of
+         * instances sharing one can be merged, as only their texture layer differs.
+         */
+        auto getBatchInst() const -> MaterialInst*;
+
+        /**
+         * @return True if both have the same uniform values, textures and texture arrays.
+         */
+        bool hasSameBindings(const MaterialInst& other) const;
+
+        /*
+         * Handles come from Material::findUniform(). Setters taking a name look the member up every call.
+         * Setters only change the CPU copy, the changed bytes of every instance are uploaded together before the next frame.
+         */
+        auto getInt(UniformHandle handle) const -> i32;
+        void setInt(UniformHandle handle, i32 value) const;
         auto getInt(const std::string& name) const -> i32;
         void setInt(const std::string& name, i32 value) const;
 
+        auto getFloat(UniformHandle handle) const -> float;
+        void setFloat(UniformHandle handle, float value) const;
         auto getFloat(const std::string& name) const -> float;
         void setFloat(const std::string& name, float value) const;
 
+        auto getFloat2(UniformHandle handle) const -> glm::vec2;
+        void setFloat2(UniformHandle handle, const glm::vec2& value) const;
         auto getFloat2(const std::string& name) const -> glm::vec2;
         void setFloat2(const std::string& name, const glm::vec2& value) const;
 
+        auto getFloat3(UniformHandle handle) const -> glm::vec3;
+        void setFloat3(UniformHandle handle, const glm::vec3& value) const;
         auto getFloat3(const std::string& name) const -> glm::vec3;
         void setFloat3(const std::string& name, const glm::vec3& value) const;
 
+        auto getFloat4(UniformHandle handle) const -> glm::vec4;
+        void setFloat4(UniformHandle handle, const glm::vec4& value) const;
         auto getFloat4(const std::string& name) const -> glm::vec4;
         void setFloat4(const std::string& name, const glm::vec4& value) const;
 
+        auto getMat4(UniformHandle handle) const -> glm::mat4;
+        void setMat4(UniformHandle handle, const glm::mat4& value) const;
         auto getMat4(const std::string& name) const -> glm::mat4;
         void setMat4(const std::string& name, const glm::mat4& value) const;
 
+        auto getData(UniformHandle handle) const -> const void*;
+        void setData(UniformHandle handle, i32 size, const void* data) const;
         auto getData(const std::string& name) const -> const void*;
         void setData(const std::string& name, i32 size, const void* data) const;
 
@@ -140,25 +269,40 @@ namespace Rune
         auto getUniformBuffers() const -> const std::vector<UniformBuffer>&;
         auto getTextureSlots() const -> const std::vector<TextureSlot>&;
 
+        /**
+         * Append the uniform ranges changed since the last call, and their bytes, then mark them as uploaded.
+         * @param ranges Data offsets of the appended ranges are into data.
+         */
+        void takeUniformUploads(std::vector<BufferRangeUpdate>& ranges, std::vector<u8>& data) const;
+
     private:
         void initUniforms();
 
-        struct UniformBufferMember
-        {
-            u32 uniformBufferIndex;
-            u32 byteOffset;
-            u32 byteSize;
-        };
+        auto getUniformBufferMember(UniformHandle handle) const -> const Material::UniformBufferMember*;
 
-        auto getUniformBufferMember(const std::string& name) const -> const UniformBufferMember*;
+        /**
+         * Write a member's value, only marking it for upload and the batches for regrouping if its bytes changed.
+         */
+        void writeUniform(const Material::UniformBufferMember& member, const void* data, u32 byteSize) const;
+
+        /**
+         * Grow the dirty range of the member's buffer to cover it, and queue this instance for upload if it was not already.
+         */
+        void markUniformDirty(const Material::UniformBufferMember& member) const;
 
     private:
+        /* Packs textures and groups instances into batches */
+        friend class Material;
+
         Material* m_material = nullptr;
+        u32 m_id{};
+        u32 m_textureLayer = 0;
+        MaterialInst* m_batchInst = nullptr;
+        mutable bool m_uniformUploadQueued = false;
 
         std::vector<UniformBuffer> m_uniformBuffers;
         std::vector<TextureSlot> m_textures;
 
-        std::unordered_map<std::string, UniformBufferMember> m_uniformMemberMap;
         std::unordered_map<std::string, size> m_textureMap;
     };
 }
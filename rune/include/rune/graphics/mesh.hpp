@@ -3,6 +3,7 @@
 #pragma once
 
 #include "rune/assets/asset.hpp"
+#include "rune/maths/bounds.hpp"
 #include "vertex.hpp"
 
 #include <vector>
@@ -16,26 +17,96 @@ namespace Rune
         eTriangles
     };
 
+    /**
+     * Width of the indices a mesh is stored with on the GPU
+     */
+    enum class IndexType : u8
+    {
+        eU16,
+        eU32
+    };
+
+    constexpr auto getIndexSize(const IndexType indexType) -> size
+    {
+        return indexType == IndexType::eU32 ? sizeof(u32) : sizeof(u16);
+    }
+
     class Mesh : public Asset
     {
     public:
+        /* LODs are limited by the bits given to them in draw keys */
+        static constexpr u32 MaxLodCount = 4;
+
+        /* Submesh index that draws every submesh at once */
+        static constexpr u32 AllSubmeshes = ~0u;
+
+        /**
+         * Range of indices drawn for one level of detail. All levels index the same vertices.
+         */
+        struct Lod
+        {
+            i32 firstIndex;
+            i32 indexCount;
+            f32 error;  // Approximate distance from the full detail surface, in mesh units
+        };
+
         struct Submesh
         {
             i32 firstIndex;
             i32 indexCount;
+
+            Bounds bounds;
+
+            /* Range of each level of detail, coarser each level. Empty if no LODs have been generated. */
+            std::vector<Lod> lods;
         };
 
     public:
         ~Mesh() override;
 
-        auto getIndices() const -> const std::vector<u16>&;
+        auto getIndices() const -> const std::vector<u32>&;
+        /**
+         * @return 16bit when every vertex can be addressed with 16bit indices, which halves the index memory.
+         */
+        auto getIndexType() const -> IndexType;
         auto getVertices() const -> const std::vector<Vertex>&;
+        /**
+         * @return How vertices are encoded on the GPU. Quantized positions are normalized over the vertex bounds at apply().
+         */
+        auto getVertexEncoding() const -> const VertexEncoding&;
         auto getTopology() const -> MeshTopology;
+        auto getSubmeshes() const -> const std::vector<Submesh>&;
+
+        /**
+         * @return Local space bounds enclosing all submeshes. Box is invalid if bounds have not been set.
+         */
+        auto getBounds() const -> const Bounds&;
+        void setBounds(const Bounds& bounds);
 
         void setVertices(const std::vector<Vertex>& vertices);
-        void setIndices(const std::vector<u16>& indices, MeshTopology topology);
+        void setVertexFormat(VertexFormat format);
+        void setIndices(const std::vector<u32>& indices, MeshTopology topology);
         void setSubmesh(size index, const Submesh& submesh);
 
+        /**
+         * @return Number of levels of detail, always at least 1 (the full index list).
+         */
+        auto getLodCount() const -> u32;
+        /**
+         * @return Index range covering every submesh at the given level. Level 0 is the full index list unless LODs were set.
+         */
+        auto getLod(u32 level) const -> Lod;
+        /**
+         * Set the index range of each level of detail, finest first. Must follow setIndices(), which clears them.
+         */
+        void setLods(const std::vector<Lod>& lods);
+
+        /**
+         * @param submesh Index of the submesh, or AllSubmeshes for the whole mesh.
+         * @return Indices drawn for the submesh at the given level of detail (clamped to the levels it has).
+         */
+        auto getIndexRange(u32 lod, u32 submesh) const -> Lod;
+
         void apply();
 
         auto getId() const -> u32;
@@ -43,10 +114,13 @@ namespace Rune
     private:
         // std::vector<Material> m_materials;
 
-        std::vector<u16> m_indices;
+        std::vector<u32> m_indices;
         std::vector<Vertex> m_vertices;
+        VertexEncoding m_vertexEncoding{};
         std::vector<Submesh> m_submeshes;
+        std::vector<Lod> m_lods;
         MeshTopology m_topology = MeshTopology::eNone;
+        Bounds m_bounds{};
 
         u32 m_id{};
     };
@@ -0,0 +1,47 @@
+// # Copyright  Stuart Millman <stu.millman15@gmail.com>
+
+#pragma once
+
+#include "rune/defines.hpp"
+#include "vertex.hpp"
+
+#include <vector>
+
+namespace Rune
+{
+    namespace MeshOptimize
+    {
+        /* Size of the FIFO post-transform cache triangles are ordered for and analysed with */
+        constexpr u32 VertexCacheSize = 16;
+
+        struct VertexCacheStats
+        {
+            f32 acmr = 0.0f;  // Average cache miss ratio, vertices transformed per triangle (0.5 - 3)
+            f32 atvr = 0.0f;  // Average transformed vertex ratio, vertices transformed per vertex used (1 is ideal)
+        };
+
+        /**
+         * Simulate a FIFO post-transform cache of VertexCacheSize entries running over the triangle list.
+         */
+        auto analyzeVertexCache(const u32* indices, size indexCount, size vertexCount) -> VertexCacheStats;
+
+        /**
+         * Reorder triangles so consecutive triangles reuse recently transformed vertices (Tipsify, Sander et al. 2007).
+         */
+        void optimizeVertexCache(u32* indices, size indexCount, size vertexCount);
+
+        /**
+         * Reorder clusters of a vertex cache optimized triangle list so outward facing ones are drawn first, which lets early
+         * depth testing reject more of what is behind them from any view.
+         * @param threshold How much worse than the input the ACMR can get, clusters are split up more the higher this is.
+         */
+        void optimizeOverdraw(const std::vector<Vertex>& vertices, u32* indices, size indexCount, f32 threshold = 1.05f);
+
+        /**
+         * Reorder vertices by first use in the triangle list and remap the indices, so vertex fetches walk memory in order.
+         * Vertices no triangle uses are removed.
+         * @return The new vertex count.
+         */
+        auto optimizeVertexFetch(std::vector<Vertex>& vertices, u32* indices, size indexCount) -> size;
+    }
+}
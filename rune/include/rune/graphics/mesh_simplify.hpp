@@ -0,0 +1,30 @@
+// # Copyright  Stuart Millman <stu.millman15@gmail.com>
+
+#pragma once
+
+#include "rune/defines.hpp"
+#include "vertex.hpp"
+
+#include <vector>
+
+namespace Rune
+{
+    namespace MeshSimplify
+    {
+        /**
+         * Reduce a triangle list by collapsing edges in order of their quadric error (Garland & Heckbert).
+         * Edges are only collapsed onto one of their existing vertices, so the result indexes the same vertices as the input
+         * and can share its vertex buffer. Vertices split by attribute seams are collapsed together with their seam partners,
+         * so seams do not open up.
+         * @param targetIndexCount Collapses stop once the triangle count reaches this, or no collapse is left that keeps the
+         * surface intact.
+         * @param outIndices Replaced with the simplified triangle list.
+         * @return Geometric error of the result, as an approximate distance from the original surface in mesh units.
+         */
+        auto simplify(const std::vector<Vertex>& vertices,
+                      const u32* indices,
+                      size indexCount,
+                      size targetIndexCount,
+                      std::vector<u32>& outIndices) -> f32;
+    }
+}
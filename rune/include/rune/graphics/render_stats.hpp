@@ -0,0 +1,80 @@
+// # Copyright  Stuart Millman <stu.millman15@gmail.com>
+
+#pragma once
+
+#include "rune/defines.hpp"
+
+#include <fstream>
+#include <string>
+
+namespace Rune
+{
+    /**
+     * Counters and timings for a single rendered frame.
+     * Backend counters are filled in by the active RendererBase, the rest by GraphicsSystem.
+     * Layout is mirrored by Rune.RenderStats in the script core, keep them in sync.
+     */
+    struct RenderStats
+    {
+        /* Submission */
+        u32 drawCalls = 0;
+        u32 instances = 0;
+        u64 triangles = 0;
+
+        /* State changes issued to the backend */
+        u32 programBinds = 0;
+        u32 vaoBinds = 0;
+        u32 textureBinds = 0;
+        u32 uniformBufferBinds = 0;
+        u32 storageBufferBinds = 0;
+        u32 redundantCallsSkipped = 0;  // State changes dropped because the backend already had that state
+
+        u64 bytesUploaded = 0;
+
+        /* Programs for materials created since the last frame */
+        u32 programCacheHits = 0;    // Shared with an existing material using the same shaders
+        u32 programBinaryLoads = 0;  // Loaded from a binary saved by an earlier run
+        u32 programCacheMisses = 0;  // Compiled from SPIR-V and linked
+
+        /* Culling */
+        u32 visibleRenderables = 0;
+        u32 culledRenderables = 0;
+
+        /* Shadows */
+        u32 shadowViewsRendered = 0;  // Shadow map layers drawn into this frame
+        u32 shadowViewsCached = 0;    // Shadow map layers whose static casters were reused from an earlier frame
+
+        /* Texture streaming */
+        u32 textureMipsStreamed = 0;   // Mip levels uploaded by the texture streamer
+        u32 textureMipsEvicted = 0;    // Mip levels dropped to stay within the texture memory budget
+        u32 textureMipsReloaded = 0;   // Streamed mip levels that had been evicted before
+        u32 texturesStreaming = 0;     // Textures still coarser than their requested mip
+        u64 textureResidentBytes = 0;  // Texture memory taken by resident mips
+
+        /* CPU time in milliseconds */
+        f32 cullTime = 0.0f;
+        f32 sortTime = 0.0f;
+        f32 submitTime = 0.0f;
+    };
+
+    /**
+     * Writes one row of RenderStats per frame to a CSV or JSON file, chosen by the file extension.
+     */
+    class RenderStatsWriter
+    {
+    public:
+        ~RenderStatsWriter();
+
+        bool open(const std::string& filename);
+        void close();
+
+        bool isOpen() const;
+
+        void write(u64 frameIndex, const RenderStats& stats);
+
+    private:
+        std::ofstream m_file;
+        bool m_isJson = false;
+        bool m_isFirstRow = true;
+    };
+}
@@ -3,6 +3,7 @@
 #pragma once
 #include "rune/defines.hpp"
 
+#include <optional>
 #include <string>
 #include <unordered_map>
 #include <vector>
@@ -14,6 +15,7 @@ namespace Rune
     struct Member
     {
         std::string name;
+        u64 id;  // Hash of "<binding>.<member>", the name materials look members up by
         u32 byteOffset;
         u32 byteSize;
     };
@@ -22,7 +24,9 @@ namespace Rune
     {
         eNone,
         eUniformBuffer,
-        eTexture
+        eStorageBuffer,
+        eTexture,
+        eTextureArray  // sampler2DArray, a layer per material instance
     };
 
     struct Binding
@@ -50,6 +54,26 @@ namespace Rune
     namespace ShaderReflection
     {
         auto reflect(const Shader* shader) -> ReflectionData;
+
+        /**
+         * @return Hash of the shader's vertex and fragment code, which reflection data is only valid for.
+         */
+        auto getCodeHash(const Shader* shader) -> u64;
+
+        /**
+         * Write reflection data to a binary file, with names stored once in a shared string table.
+         */
+        bool save(const std::string& filename, u64 codeHash, const ReflectionData& reflectionData);
+        /**
+         * Read reflection data saved by save(), mapping the file rather than reading it.
+         * @return Nothing if the file is missing or invalid, or was saved for different code.
+         */
+        auto load(const std::string& filename, u64 codeHash) -> std::optional<ReflectionData>;
+
+        /**
+         * @return Id of a uniform buffer member, from its "<binding>.<member>" name.
+         */
+        auto getMemberId(const std::string& bindingName, const std::string& memberName) -> u64;
     }
 
 }
@@ -0,0 +1,168 @@
+// # Copyright  Stuart Millman <stu.millman15@gmail.com>
+
+#pragma once
+
+#include "rune/defines.hpp"
+#include "light.hpp"
+#include "vertex.hpp"
+#include "rune/maths/bounds.hpp"
+#include "rune/maths/culling.hpp"
+
+#include <glm/ext/matrix_float4x4.hpp>
+#include <glm/ext/vector_int4.hpp>
+
+#include <array>
+#include <vector>
+
+namespace Rune
+{
+    class Mesh;
+    class RendererBase;
+    struct DrawCommand;
+
+    struct ShadowSettings
+    {
+        bool enabled = true;
+        u32 cascadeResolution = 2048;
+        u32 pointResolution = 512;
+        f32 distance = 100.0f;  // View distance covered by the cascades
+    };
+
+    /**
+     * Renders the depth of shadow casters from each shadowed light: cascades for a directional light and 6 faces per point light.
+     *
+     * Static casters are rendered into a cached copy of each shadow map, which is only re-rendered when a view's static casters or
+     * its light change. Each frame the cache is copied and dynamic casters are rendered on top, so a scene without moving objects
+     * costs no shadow draws at all.
+     */
+    class ShadowPass
+    {
+    public:
+        static constexpr u32 CascadeCount = 4;
+        static constexpr u32 MaxPointLights = 4;
+        static constexpr u32 PointFaceCount = 6;
+
+        struct Caster
+        {
+            Mesh* mesh;
+            u32 submesh;
+            u32 lod;
+            glm::mat4 transform;
+            AABB worldBox;  // Invalid if the mesh has no bounds, then it is never culled
+            bool isStatic;
+        };
+
+        struct ShadowedLight
+        {
+            Light light;
+            i32 shaderIndex;  // Global light index of a directional light, clustered light index of a point light
+        };
+
+        struct FrameCounts
+        {
+            u32 viewsRendered = 0;  // Views that had static or dynamic casters drawn
+            u32 viewsCached = 0;    // Views whose static casters came from the cache
+        };
+
+        ShadowPass();
+        ~ShadowPass();
+
+        void init(RendererBase* renderer);
+        void cleanup();
+
+        auto getSettings() const -> const ShadowSettings&;
+        void setSettings(const ShadowSettings& settings);
+
+        /**
+         * Render this frame's shadow maps, then bind them and their uniforms for the lit passes.
+         * @param casters Ordered so that casters sharing a mesh, submesh and LOD are adjacent, which lets them share a draw command.
+         */
+        void render(const glm::mat4& cameraProj,
+                    const glm::mat4& cameraView,
+                    const Frustum& cameraFrustum,
+                    f32 cameraNear,
+                    const std::vector<ShadowedLight>& lights,
+                    const std::vector<Caster>& casters,
+                    bool useMultiDrawIndirect);
+
+        auto getLastFrameCounts() const -> const FrameCounts&;
+
+    private:
+        enum MapType : u8
+        {
+            eCascadeMap = 0,
+            ePointMap,
+            eMapTypeCount
+        };
+
+        struct View
+        {
+            MapType mapType;
+            u32 layer;
+            glm::mat4 proj;
+            glm::mat4 view;
+
+            u64 staticHash;
+            bool isStaticDirty;
+            u32 firstStaticCommand, staticCommandCount;
+            u32 firstDynamicCommand, dynamicCommandCount;
+        };
+
+        /* Identifies what a layer of a static map was last rendered with */
+        struct CachedLayer
+        {
+            glm::mat4 viewProj = glm::mat4(0.0f);
+            u64 staticHash = 0;
+        };
+
+        struct ShadowMap
+        {
+            u32 staticId = 0;   // Static casters only, kept between frames
+            u32 dynamicId = 0;  // Copy of the static map with dynamic casters added
+            u32 resolution = 0;
+            std::vector<CachedLayer> cachedLayers;
+        };
+
+        /* Layout of the shadow uniform buffer in shaders */
+        struct ShadowUniforms
+        {
+            std::array<glm::mat4, CascadeCount> cascadeViewProj;
+            glm::vec4 cascadeSplits;  // View depth each cascade ends at
+            std::array<glm::mat4, MaxPointLights * PointFaceCount> pointViewProj;
+            glm::ivec4 pointShadowLights;  // Clustered light index of each point light shadow, -1 if unused
+            glm::ivec4 shadowInfo;         // Global light index of the directional shadow (-1 if none), point shadow count
+        };
+
+        void createMaps();
+        void destroyMaps();
+
+        void addCascadeViews(
+            const glm::mat4& cameraProj, const glm::mat4& cameraView, f32 cameraNear, const Light& light, const std::vector<Caster>& casters);
+        void addPointViews(const Light& light, u32 pointIndex, const std::vector<Caster>& casters);
+        void addView(MapType mapType, u32 layer, const glm::mat4& proj, const glm::mat4& view, const std::vector<Caster>& casters);
+        void addCommands(const std::vector<Caster>& casters, const std::vector<u32>& casterIndices);
+
+        void renderMap(MapType mapType, bool useMultiDrawIndirect);
+        void drawCommands(u32 firstCommand, u32 commandCount, bool useMultiDrawIndirect);
+
+    private:
+        RendererBase* m_renderer = nullptr;
+        ShadowSettings m_settings{};
+        std::array<ShadowMap, eMapTypeCount> m_maps{};
+
+        ShadowUniforms m_uniforms{};
+        std::vector<View> m_views;
+        std::vector<DrawCommand> m_commands;
+        std::vector<InstanceData> m_instances;
+
+        Culling::BoxBatch m_casterBoxes;
+        std::vector<u32> m_casterBoxIndices;    // Caster of each box
+        std::vector<u32> m_unboundedCasters;    // Casters without bounds
+        std::vector<u8> m_casterBoxVisibility;
+        std::vector<u8> m_casterVisibility;
+        std::vector<u32> m_staticCasters;
+        std::vector<u32> m_dynamicCasters;
+
+        FrameCounts m_lastFrameCounts{};
+    };
+}
@@ -4,6 +4,8 @@
 
 #include "rune/assets/asset.hpp"
 
+#include <algorithm>
+#include <bit>
 #include <vector>
 
 namespace Rune
@@ -14,29 +16,173 @@ namespace Rune
         eR,
         eRGB,
         eRGBA,
+
+        /* Block compressed, each 4x4 block of texels encoded together */
+        eBC1,  // RGB, 8 bytes per block
+        eBC3,  // RGBA, 16 bytes per block
+        eBC4,  // R, 8 bytes per block
+        eBC5,  // RG, 16 bytes per block. For normal maps, whose z is rebuilt from xy when sampled.
+        eBC7,  // RGBA, 16 bytes per block. Same size as BC3 with finer endpoints and indices, for colour with alpha.
     };
 
+    /**
+     * What a texture's channels hold, which decides how it is filtered into mips and compressed
+     */
+    enum class TextureUsage : u8
+    {
+        eColor,   // sRGB encoded colour, with optional alpha
+        eNormal,  // Tangent space normals in xyz
+        eMask     // Linear data in the first channel, eg. roughness or ambient occlusion
+    };
+
+    constexpr auto isCompressed(const TextureFormat format) -> bool
+    {
+        return format == TextureFormat::eBC1 || format == TextureFormat::eBC3 || format == TextureFormat::eBC4 ||
+               format == TextureFormat::eBC5 || format == TextureFormat::eBC7;
+    }
+
+    /**
+     * @return Bytes taken by a width x height image in the format. Compressed images are padded to whole blocks.
+     */
+    constexpr auto getTextureDataSize(const TextureFormat format, const u32 width, const u32 height) -> size
+    {
+        const size blockCount = static_cast<size>((width + 3) / 4) * ((height + 3) / 4);
+        const size texelCount = static_cast<size>(width) * height;
+        switch (format)
+        {
+            case TextureFormat::eR: return texelCount;
+            case TextureFormat::eRGB: return texelCount * 3;
+            case TextureFormat::eRGBA: return texelCount * 4;
+            case TextureFormat::eBC1:
+            case TextureFormat::eBC4: return blockCount * 8;
+            case TextureFormat::eBC3:
+            case TextureFormat::eBC5:
+            case TextureFormat::eBC7: return blockCount * 16;
+            case TextureFormat::eUnknown: return 0;
+        }
+        return 0;
+    }
+
+    /**
+     * @return Number of levels in a full mip chain, down to 1x1.
+     */
+    constexpr auto getMipLevelCount(const u32 width, const u32 height) -> u32
+    {
+        return static_cast<u32>(std::bit_width(std::max(width, height)));
+    }
+
+    constexpr auto getMipLevelSize(const u32 baseSize, const u32 level) -> u32
+    {
+        return std::max(baseSize >> level, 1u);
+    }
+
+    /**
+     * @return Bytes taken by the first mipCount levels, stored one after another from the full size level.
+     */
+    constexpr auto getMipChainDataSize(const TextureFormat format, const u32 width, const u32 height, const u32 mipCount) -> size
+    {
+        size dataSize = 0;
+        for (u32 level = 0; level < mipCount; ++level)
+        {
+            dataSize += getTextureDataSize(format, getMipLevelSize(width, level), getMipLevelSize(height, level));
+        }
+        return dataSize;
+    }
+
     class Texture : public Asset
     {
     public:
         ~Texture() override;
 
-        void init(i32 width, i32 height, TextureFormat format, const std::vector<u8>& data);
+        /**
+         * Only the mips the texture streamer keeps resident from the start are uploaded, the rest once they are requested.
+         * @param data Mip levels from importedMip down to 1x1, one after another.
+         * @param importedMip Finest mip in data. Finer ones are handed over by setImportedMip() once encoded.
+         */
+        void init(i32 width, i32 height, TextureFormat format, u32 mipCount, const std::vector<u8>& data, u32 importedMip = 0);
 
         auto getWidth() const -> i32;
         auto getHeight() const -> i32;
         auto getFormat() const -> TextureFormat;
+        auto getMipCount() const -> u32;
+
+        /**
+         * @return Finest mip that is uploaded and sampled from.
+         */
+        auto getResidentMip() const -> u32;
+        /**
+         * @return Bytes taken on the GPU by the resident mips.
+         */
+        auto getResidentDataSize() const -> size;
+        auto getMipDataSize(u32 mip) const -> size;
+        /**
+         * @return Finest mip that has ever been resident. Streaming in a mip at or below it again is a reload.
+         */
+        auto getFinestLoadedMip() const -> u32;
+        /**
+         * @return Finest mip whose data is held. Mips finer than it cannot be streamed in yet.
+         */
+        auto getImportedMip() const -> u32;
+        /**
+         * Hand over the data of the next finer mip than getImportedMip().
+         */
+        void setImportedMip(u32 mip, const std::vector<u8>& data);
 
+        /**
+         * Frame the texture was last bound for drawing in, used to evict the least recently used mips first.
+         */
+        auto getLastUsedFrame() const -> u64;
+        void setLastUsedFrame(u64 frameIndex);
+
+        /**
+         * Ask for a mip to be made resident. The finest mip requested since the last clearRequestedMip() is kept.
+         */
+        void requestMip(u32 mip);
+        /**
+         * @return Finest mip requested, or the mip count if none was.
+         */
+        auto getRequestedMip() const -> u32;
+        void clearRequestedMip();
+
+        /**
+         * Make the next finer mip resident. It is uploaded and sampled from once applyResidentMip() is called.
+         * @return Bytes it takes, 0 if every imported mip is already resident.
+         */
+        auto streamInMip() -> size;
+        /**
+         * Drop the finest resident mip, its memory is freed once applyResidentMip() is called. The last mip always stays resident.
+         * @return Bytes freed.
+         */
+        auto evictMip() -> size;
+        /**
+         * Reallocate the texture to hold the resident mips and upload those that were not resident before, once for every mip
+         * streamed in or evicted since the last call.
+         */
+        void applyResidentMip();
+
+        /**
+         * @return Every mip level, one after another from the full size level. Those finer than getImportedMip() are unset.
+         */
         auto getData() const -> const std::vector<u8>&;
 
         auto getInternalId() const -> u32;
 
+    private:
+        void uploadMip(u32 mip);
+
     private:
         u32 m_internalId{};
 
         i32 m_width{};
         i32 m_height{};
         TextureFormat m_format{};
+        u32 m_mipCount = 1;
+        u32 m_residentMip = 0;
+        u32 m_appliedResidentMip = 0;  // Finest mip the renderer holds, until applyResidentMip()
+        u32 m_requestedMip = 1;
+        u32 m_finestLoadedMip = 0;
+        u32 m_importedMip = 0;
+        u64 m_lastUsedFrame = 0;
 
         std::vector<u8> m_data;
     };
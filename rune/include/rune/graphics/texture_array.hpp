@@ -0,0 +1,43 @@
+// # Copyright  Stuart Millman <stu.millman15@gmail.com>
+
+#pragma once
+
+#include "rune/defines.hpp"
+
+#include <vector>
+
+namespace Rune
+{
+    class Texture;
+
+    /**
+     * Textures of the same size, format and mip count in the layers of one 2D array texture, so draws sampling any of them
+     * share a binding. Every mip of every layer is uploaded up front, texture arrays are not streamed.
+     */
+    class TextureArray
+    {
+    public:
+        /* Minimum GL_MAX_ARRAY_TEXTURE_LAYERS required by GL 4.5 */
+        static constexpr u32 MaxLayerCount = 2048;
+
+        ~TextureArray();
+
+        /**
+         * Upload each texture's full mip chain into the layer of its index.
+         */
+        void init(const std::vector<Texture*>& layers);
+
+        /**
+         * @return True if both textures can be layers of the same array.
+         */
+        static bool isCompatible(const Texture& a, const Texture& b);
+
+        auto getLayerCount() const -> u32;
+
+        auto getInternalId() const -> u32;
+
+    private:
+        u32 m_internalId{};
+        u32 m_layerCount = 0;
+    };
+}
@@ -0,0 +1,43 @@
+// # Copyright  Stuart Millman <stu.millman15@gmail.com>
+
+#pragma once
+
+#include "rune/defines.hpp"
+#include "texture.hpp"
+
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace Rune
+{
+    /**
+     * Block compressed mip chain of a texture, as imported from its source image.
+     */
+    struct EncodedTexture
+    {
+        u32 width;
+        u32 height;
+        TextureFormat format;
+        u32 mipCount;
+        std::vector<u8> data;  // Every mip level, one after another from the full size level
+    };
+
+    namespace TextureCache
+    {
+        /**
+         * @return Filename of the encoded texture kept beside a source image.
+         */
+        auto getCacheFilename(const std::string& sourceFilename) -> std::string;
+
+        /**
+         * Write an encoded texture to a binary file, for the source image whose bytes hash to sourceHash.
+         */
+        bool save(const std::string& filename, u64 sourceHash, const EncodedTexture& texture);
+        /**
+         * Read an encoded texture saved by save(), mapping the file rather than reading it.
+         * @return Nothing if the file is missing or invalid, or was saved for a different source image or encoder.
+         */
+        auto load(const std::string& filename, u64 sourceHash) -> std::optional<EncodedTexture>;
+    }
+}
@@ -0,0 +1,31 @@
+// # Copyright  Stuart Millman <stu.millman15@gmail.com>
+
+#pragma once
+
+#include "rune/defines.hpp"
+#include "texture.hpp"
+
+#include <vector>
+
+namespace Rune
+{
+    class ThreadPool;
+
+    namespace TextureCompress
+    {
+        /**
+         * Colour textures are compressed to BC1, or BC7 if any texel is not fully opaque. Normal maps keep x and y in BC5,
+         * and masks their first channel in BC4.
+         * @param channels Channels per texel in the source pixels (1 - 4).
+         */
+        auto chooseFormat(TextureUsage usage, const u8* pixels, u32 width, u32 height, u32 channels) -> TextureFormat;
+
+        /**
+         * Encode 8bit pixels into a block compressed format, one row of blocks per job on the thread pool.
+         * Edge blocks of images that are not a multiple of 4 texels repeat the last row/column.
+         * @return getTextureDataSize() bytes of encoded blocks, in rows from the first row of pixels.
+         */
+        auto compress(const u8* pixels, u32 width, u32 height, u32 channels, TextureFormat format, ThreadPool& threadPool)
+            -> std::vector<u8>;
+    }
+}
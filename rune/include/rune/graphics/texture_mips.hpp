@@ -0,0 +1,25 @@
+// # Copyright  Stuart Millman <stu.millman15@gmail.com>
+
+#pragma once
+
+#include "rune/defines.hpp"
+#include "texture.hpp"
+
+#include <vector>
+
+namespace Rune
+{
+    class ThreadPool;
+
+    namespace TextureMips
+    {
+        /**
+         * Build the mip chain below an 8bit image, each level box filtered from the one above it. Odd sized levels fold their
+         * last row/column into the last texel, so nothing is dropped.
+         * Colour is filtered in linear space and stored back as sRGB, and normal maps are renormalized after filtering.
+         * @return Pixels of each level after the full size one, down to 1x1, with the same channel count as the source.
+         */
+        auto generate(const u8* pixels, u32 width, u32 height, u32 channels, TextureUsage usage, ThreadPool& threadPool)
+            -> std::vector<std::vector<u8>>;
+    }
+}
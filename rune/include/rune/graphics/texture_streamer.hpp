@@ -0,0 +1,170 @@
+// # Copyright  Stuart Millman <stu.millman15@gmail.com>
+
+#pragma once
+
+#include "rune/defines.hpp"
+#include "rune/graphics/texture.hpp"
+#include "rune/utility/thread_pool.hpp"
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace Rune
+{
+    class MaterialInst;
+
+    struct TextureStreamingSettings
+    {
+        bool enabled = true;
+        u32 residentSize = 128;                     // Mips no larger than this on their longest side are uploaded when created
+        size uploadBudget = size(4) * 1024 * 1024;  // Bytes of finer mips uploaded per frame
+        size memoryBudget = 0;                      // Bytes of resident mips across all textures. 0 for no limit
+    };
+
+    /**
+     * What is left of a texture's import once it has been created with its initial mips: encoding the finer ones.
+     */
+    struct TextureImportJob
+    {
+        Texture* texture;
+        u32 width;
+        u32 height;
+        u32 channels;
+        TextureFormat format;
+        u32 mipCount;
+        u32 importedMip;                         // Finest mip the texture was created with
+        std::vector<u8> pixels;                  // Full size source image
+        std::vector<std::vector<u8>> mipPixels;  // Source of each level after the full size one
+        std::vector<u8> importedData;            // Encoded mips the texture was created with
+        std::string cacheFilename;               // Where the full encoded chain is saved once done
+        u64 sourceHash;
+    };
+
+    /**
+     * Brings the finer mips of textures onto the GPU once something on screen needs them, and drops them again when over budget.
+     *
+     * Textures start with only their small mips resident. Each frame the renderer requests the mip every visible texture needs
+     * at its size on screen, and update() picks the missing levels one at a time, coarsest first and round robin between
+     * textures, until the frame's upload budget is spent. Each texture is then reallocated once for the levels it gained or lost.
+     *
+     * When resident mips would go over the memory budget, the finest mips of the least recently used textures are evicted to
+     * make room. Mips requested this frame and those every texture starts with are never evicted, so the budget can still be
+     * exceeded when they alone do not fit.
+     *
+     * The finer mips of newly imported textures are encoded on a background thread, coarsest first. Each is handed to its
+     * texture in update() once encoded, and can only be streamed in after that.
+     */
+    class TextureStreamer
+    {
+    public:
+        ~TextureStreamer();
+
+        struct FrameCounts
+        {
+            u32 mipsStreamed = 0;      // Mip levels uploaded this frame
+            u32 mipsEvicted = 0;       // Mip levels dropped to stay within the memory budget
+            u32 mipsReloaded = 0;      // Streamed mips that had been resident before
+            u32 texturesPending = 0;   // Textures still coarser than requested after this frame's uploads
+            u64 residentDataSize = 0;  // Bytes of resident mips after this frame's uploads and evictions
+        };
+
+        auto getSettings() const -> const TextureStreamingSettings&;
+        /**
+         * Disabling streaming uploads every remaining mip on the next update().
+         */
+        void setSettings(const TextureStreamingSettings& settings);
+
+        /**
+         * @return Finest mip a new texture is created with.
+         */
+        auto getInitialResidentMip(u32 width, u32 height, u32 mipCount) const -> u32;
+
+        void add(Texture* texture);
+        /**
+         * Also cancels the texture's import, if it is still being encoded.
+         */
+        void remove(Texture* texture);
+
+        /**
+         * Encode the rest of a texture's mips in the background. Starts the import thread on first use.
+         */
+        void addImport(TextureImportJob job);
+        /**
+         * Block until every mip of the texture has been encoded, and hand them over.
+         */
+        void waitForImport(const Texture* texture);
+        /**
+         * Stop the import thread, dropping unfinished imports.
+         */
+        void cleanup();
+
+        /**
+         * Record the material instance's textures as used in this frame.
+         */
+        void markUsed(const MaterialInst& materialInst, u64 frameIndex);
+
+        /**
+         * Upload requested mips within the budgets, then clear every request for the next frame.
+         */
+        void update();
+
+        auto getLastFrameCounts() const -> const FrameCounts&;
+
+    private:
+        void importLoop();
+        void importMips(const TextureImportJob& job);
+        /**
+         * Hand encoded mips over to their textures, only those of the given texture if not null.
+         */
+        void handOverImportedMips(const Texture* texture);
+
+        /**
+         * @return Finest mip the texture can be streamed in to this frame.
+         */
+        static auto getTargetMip(const Texture& texture) -> u32;
+        /**
+         * @return Coarsest mip the texture can be evicted to this frame.
+         */
+        auto getKeptMip(const Texture& texture) const -> u32;
+
+        /**
+         * Evict the finest mips of the least recently used textures until resident mips take at most targetSize bytes.
+         * @return True if they fit.
+         */
+        bool evictUntil(size targetSize);
+
+    private:
+        TextureStreamingSettings m_settings{};
+
+        std::vector<Texture*> m_textures;
+        std::vector<Texture*> m_pendingTextures;
+
+        std::vector<Texture*> m_evictionCandidates;
+        size m_nextEvictionCandidate = 0;
+        size m_residentDataSize = 0;
+
+        FrameCounts m_lastFrameCounts{};
+
+        struct ImportedMip
+        {
+            Texture* texture;
+            u32 mip;
+            std::vector<u8> data;
+        };
+
+        std::thread m_importThread;
+        ThreadPool m_importThreadPool;  // Never started, so encoding stays on the import thread and leaves the frame's workers free
+        std::mutex m_importMutex;
+        std::condition_variable m_importWakeCondition;
+        std::condition_variable m_importDoneCondition;
+        std::deque<TextureImportJob> m_importJobs;
+        std::vector<ImportedMip> m_importedMips;
+        const Texture* m_currentImport = nullptr;
+        bool m_isCurrentImportCancelled = false;
+        bool m_isImportStopping = false;
+    };
+}
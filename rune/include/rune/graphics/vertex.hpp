@@ -2,8 +2,12 @@
 
 #pragma once
 
+#include "rune/defines.hpp"
+
 #include <glm/vec2.hpp>
 #include <glm/vec3.hpp>
+#include <glm/vec4.hpp>
+#include <glm/ext/matrix_float4x4.hpp>
 
 namespace Rune
 {
@@ -14,4 +18,63 @@ namespace Rune
         glm::vec3 norm{};
     };
 
-}
\ No newline at end of file
+    /**
+     * Layout a mesh's vertices are stored with on the GPU. Meshes always keep full Vertex data on the CPU.
+     */
+    enum class VertexFormat : u8
+    {
+        eFull,      // Vertex as is
+        eQuantized  // QuantizedVertex, half the size
+    };
+
+    struct QuantizedVertex
+    {
+        u16 pos[3];   // Normalized within the mesh bounds, see VertexEncoding
+        u16 padding;
+        u16 uv[2];    // Half floats
+        i16 norm[2];  // Octahedral encoded, normalized
+    };
+    static_assert(sizeof(QuantizedVertex) * 2 == sizeof(Vertex), "Quantized vertices should be half the size of full vertices!");
+
+    /**
+     * How a mesh's vertices are encoded on the GPU, and how shaders decode their positions.
+     */
+    struct VertexEncoding
+    {
+        VertexFormat format = VertexFormat::eFull;
+
+        /* Positions decode as offset + pos * scale. Full vertices keep the identity. */
+        glm::vec3 positionOffset{ 0.0f };
+        glm::vec3 positionScale{ 1.0f };
+    };
+
+    constexpr auto getVertexSize(const VertexFormat format) -> size
+    {
+        return format == VertexFormat::eQuantized ? sizeof(QuantizedVertex) : sizeof(Vertex);
+    }
+
+    /**
+     * @return Size of a vertex in the position-only stream used by depth-only passes.
+     */
+    constexpr auto getPositionSize(const VertexFormat format) -> size
+    {
+        return format == VertexFormat::eQuantized ? sizeof(QuantizedVertex::pos) : sizeof(glm::vec3);
+    }
+
+    /**
+     * Per-instance data read by vertex shaders from the instance storage buffer
+     */
+    struct InstanceData
+    {
+        glm::mat4 worldMatrix;
+        glm::vec4 positionScale;  // w is 1 when normals are octahedral encoded
+        glm::vec4 positionOffset;  // w is the material instance's layer in texture arrays
+
+        static auto create(const glm::mat4& worldMatrix, const VertexEncoding& encoding, const u32 textureLayer = 0) -> InstanceData
+        {
+            const f32 octahedralNormals = encoding.format == VertexFormat::eQuantized ? 1.0f : 0.0f;
+            const auto layer = static_cast<f32>(textureLayer);
+            return { worldMatrix, glm::vec4(encoding.positionScale, octahedralNormals), glm::vec4(encoding.positionOffset, layer) };
+        }
+    };
+}
@@ -0,0 +1,34 @@
+// # Copyright  Stuart Millman <stu.millman15@gmail.com>
+
+#pragma once
+
+#include "rune/defines.hpp"
+#include "vertex.hpp"
+
+#include <vector>
+
+namespace Rune
+{
+    namespace VertexQuantize
+    {
+        /**
+         * Largest difference between vertices and what their quantized versions decode back to.
+         */
+        struct QuantizationError
+        {
+            f32 position = 0.0f;  // In mesh units, per axis
+            f32 uv = 0.0f;
+            f32 normal = 0.0f;  // Angle in radians
+        };
+
+        /**
+         * @return Quantized encoding with positions normalized over the bounds of the vertices.
+         */
+        auto computeEncoding(const std::vector<Vertex>& vertices) -> VertexEncoding;
+
+        auto encode(const Vertex& vertex, const VertexEncoding& encoding) -> QuantizedVertex;
+        auto decode(const QuantizedVertex& vertex, const VertexEncoding& encoding) -> Vertex;
+
+        auto measureError(const std::vector<Vertex>& vertices, const VertexEncoding& encoding) -> QuantizationError;
+    }
+}
@@ -0,0 +1,82 @@
+// # Copyright  Stuart Millman <stu.millman15@gmail.com>
+
+#pragma once
+
+#include "rune/defines.hpp"
+
+#include <glm/ext/matrix_float4x4.hpp>
+#include <glm/ext/vector_float3.hpp>
+#include <glm/ext/vector_float4.hpp>
+
+#include <array>
+
+namespace Rune
+{
+    /**
+     * Axis-aligned bounding box
+     */
+    struct AABB
+    {
+        glm::vec3 min = glm::vec3(f32_max);
+        glm::vec3 max = glm::vec3(-f32_max);
+
+        bool isValid() const;
+
+        auto getCenter() const -> glm::vec3;
+        auto getExtents() const -> glm::vec3;
+
+        void expand(const glm::vec3& point);
+        void expand(const AABB& other);
+
+        /**
+         * @return The box enclosing this box after being transformed.
+         */
+        auto transformed(const glm::mat4& transform) const -> AABB;
+    };
+
+    struct BoundingSphere
+    {
+        glm::vec3 center{};
+        f32 radius = 0.0f;
+    };
+
+    struct Bounds
+    {
+        AABB box{};
+        BoundingSphere sphere{};
+    };
+
+    /**
+     * View frustum as 6 inward facing planes (xyz = normal, w = distance).
+     */
+    struct Frustum
+    {
+        enum Plane : u8
+        {
+            eLeft = 0,
+            eRight,
+            eBottom,
+            eTop,
+            eNear,
+            eFar,
+            eCount
+        };
+
+        std::array<glm::vec4, eCount> planes{};
+
+        /**
+         * Extract the planes from a combined projection * view matrix.
+         */
+        static auto fromMatrix(const glm::mat4& viewProj) -> Frustum;
+
+        bool intersects(const AABB& box) const;
+    };
+
+    namespace BoundsUtils
+    {
+        /**
+         * @return Box and sphere enclosing the points. The sphere is centered on the box.
+         */
+        auto fromPoints(const glm::vec3* points, size count, size stride) -> Bounds;
+    }
+}
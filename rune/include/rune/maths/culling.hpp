@@ -0,0 +1,45 @@
+// # Copyright  Stuart Millman <stu.millman15@gmail.com>
+
+#pragma once
+
+#include "rune/defines.hpp"
+#include "bounds.hpp"
+
+#include <vector>
+
+namespace Rune
+{
+    namespace Culling
+    {
+        /**
+         * World space boxes stored as structure-of-arrays so they can be tested several at a time.
+         */
+        struct BoxBatch
+        {
+            std::vector<f32> centerX;
+            std::vector<f32> centerY;
+            std::vector<f32> centerZ;
+            std::vector<f32> extentX;
+            std::vector<f32> extentY;
+            std::vector<f32> extentZ;
+
+            void clear();
+            void add(const AABB& box);
+
+            auto count() const -> size;
+        };
+
+        /**
+         * Test every box in the batch against the frustum, using SIMD to test 4 (SSE) or 8 (AVX) boxes per iteration.
+         * @param outVisible Resized to the box count. Set to 1 where the box intersects the frustum, otherwise 0.
+         * @return Number of visible boxes.
+         */
+        auto cullBoxes(const Frustum& frustum, const BoxBatch& boxes, std::vector<u8>& outVisible) -> size;
+
+        /**
+         * Find which boxes in [first, first + count) overlap the sphere, testing several at a time like cullBoxes().
+         * @param outIndices Indices of the overlapping boxes, relative to first, are appended.
+         */
+        void overlapSphere(const BoxBatch& boxes, size first, size count, const BoundingSphere& sphere, std::vector<u32>& outIndices);
+    }
+}
@@ -9,6 +9,7 @@
 #include <glm/ext/matrix_transform.hpp>
 
 #include <string>
+#include <vector>
 
 #define COMPONENT_DEFAULT_CTORS(COMP_NAME) \
     COMP_NAME() = default;                 \
@@ -67,6 +68,11 @@ namespace Rune
     {
         Mesh* mesh;
         MaterialInst* material;
+        /* Material of each submesh, drawn instead of material when not empty */
+        std::vector<MaterialInst*> submeshMaterials;
+
+        /* LOD picked last frame, kept for hysteresis */
+        u8 lod = 0;
 
         COMPONENT_DEFAULT_CTORS(MeshRenderer)
     };
@@ -25,7 +25,14 @@ namespace Rune
 
         auto getEntityByGuid(const Guid& guid) -> Entity;
 
+        /**
+         * Whether this scene is rendered with a depth pre-pass (see GraphicsSystem::setDepthPrePassEnabled()).
+         */
+        bool isDepthPrePassEnabled() const;
+        void setDepthPrePassEnabled(bool enabled);
+
     private:
         entt::registry m_registry;
+        bool m_depthPrePassEnabled = false;
     };
 }
\ No newline at end of file
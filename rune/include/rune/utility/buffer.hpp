@@ -25,6 +25,9 @@ namespace Rune
         template <typename T>
         auto read(u32 offset = 0) const -> T&;
 
+        /**
+         * @return Copy of the bytes, which the caller must delete[].
+         */
         auto readBytes(u32 size, u32 offset) const -> u8*;
         void write(const void* data, u32 size, u32 offset = 0) const;
 
@@ -0,0 +1,43 @@
+// # Copyright  Stuart Millman <stu.millman15@gmail.com>
+
+#pragma once
+
+#include "rune/defines.hpp"
+
+#include <string_view>
+
+namespace Rune
+{
+    namespace Hash
+    {
+        constexpr u64 FnvOffsetBasis = 14695981039346656037ull;
+        constexpr u64 FnvPrime = 1099511628211ull;
+
+        /**
+         * 64bit FNV-1a. Pass the previous hash as the seed to hash several ranges as one.
+         */
+        inline auto fnv1a(const void* data, const size byteSize, const u64 seed = FnvOffsetBasis) -> u64
+        {
+            const auto* bytes = static_cast<const u8*>(data);
+            u64 hash = seed;
+            for (size i = 0; i < byteSize; ++i)
+            {
+                hash = (hash ^ bytes[i]) * FnvPrime;
+            }
+            return hash;
+        }
+
+        /**
+         * 64bit FNV-1a of a string's characters, the same as fnv1a() of its bytes. Usable at compile time.
+         */
+        constexpr auto fnv1aString(const std::string_view text, const u64 seed = FnvOffsetBasis) -> u64
+        {
+            u64 hash = seed;
+            for (const char c : text)
+            {
+                hash = (hash ^ static_cast<u8>(c)) * FnvPrime;
+            }
+            return hash;
+        }
+    }
+}
@@ -0,0 +1,36 @@
+// # Copyright  Stuart Millman <stu.millman15@gmail.com>
+
+#pragma once
+
+#include "rune/defines.hpp"
+
+#include <string>
+
+namespace Rune
+{
+    /**
+     * Read-only view of a whole file mapped into memory, so it can be read in place without copying.
+     */
+    class MappedFile
+    {
+    public:
+        MappedFile() = default;
+        ~MappedFile();
+
+        MappedFile(const MappedFile&) = delete;
+        auto operator=(const MappedFile&) -> MappedFile& = delete;
+
+        /**
+         * @return False if the file does not exist, is empty, or could not be mapped.
+         */
+        bool open(const std::string& filename);
+        void close();
+
+        auto getData() const -> const u8*;
+        auto getSize() const -> size;
+
+    private:
+        const u8* m_data = nullptr;
+        size m_size = 0;
+    };
+}
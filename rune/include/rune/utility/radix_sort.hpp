@@ -0,0 +1,75 @@
+// # Copyright  Stuart Millman <stu.millman15@gmail.com>
+
+#pragma once
+
+#include "rune/defines.hpp"
+
+#include <array>
+#include <vector>
+
+namespace Rune
+{
+    /**
+     * Stable LSD radix sort of values by a 64bit key, 8bits per pass.
+     * Passes where every key shares the same digit are skipped, so keys using only their low bits sort in fewer passes.
+     * @param scratch Reused between calls to avoid allocating every sort.
+     */
+    template <typename T, typename KeyFunc>
+    void radixSort(std::vector<T>& values, std::vector<T>& scratch, KeyFunc getKey)
+    {
+        constexpr size RadixBits = 8;
+        constexpr size BucketCount = size(1) << RadixBits;
+        constexpr size PassCount = sizeof(u64) * 8 / RadixBits;
+
+        const size count = values.size();
+        if (count <= 1)
+            return;
+
+        // Build the histograms for every pass in a single read of the keys
+        std::array<std::array<size, BucketCount>, PassCount> histograms{};
+        for (const auto& value : values)
+        {
+            const u64 key = getKey(value);
+            for (size pass = 0; pass < PassCount; ++pass)
+            {
+                ++histograms[pass][(key >> (pass * RadixBits)) & (BucketCount - 1)];
+            }
+        }
+
+        scratch.resize(count);
+
+        auto* src = &values;
+        auto* dst = &scratch;
+        for (size pass = 0; pass < PassCount; ++pass)
+        {
+            auto& histogram = histograms[pass];
+            const size shift = pass * RadixBits;
+
+            // All keys have the same digit, order would not change
+            const u64 firstDigit = (getKey((*src)[0]) >> shift) & (BucketCount - 1);
+            if (histogram[firstDigit] == count)
+                continue;
+
+            // Exclusive prefix sum to get the output offset of each bucket
+            size offset = 0;
+            for (auto& bucket : histogram)
+            {
+                const size bucketSize = bucket;
+                bucket = offset;
+                offset += bucketSize;
+            }
+
+            for (const auto& value : *src)
+            {
+                const auto digit = (getKey(value) >> shift) & (BucketCount - 1);
+                (*dst)[histogram[digit]++] = value;
+            }
+
+            std::swap(src, dst);
+        }
+
+        // Make sure the sorted result ends up in the callers vector
+        if (src != &values)
+            values.swap(scratch);
+    }
+}
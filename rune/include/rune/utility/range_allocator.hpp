@@ -0,0 +1,52 @@
+// # Copyright  Stuart Millman <stu.millman15@gmail.com>
+
+#pragma once
+
+#include "rune/defines.hpp"
+
+#include <map>
+
+namespace Rune
+{
+    /**
+     * Sub-allocates ranges from a linear space of elements (eg. vertices in a buffer).
+     * Free ranges are kept in a free list that is searched best-fit, and are merged with their neighbours when freed.
+     */
+    class RangeAllocator
+    {
+    public:
+        void init(u32 capacity);
+
+        /**
+         * @param outOffset Offset of the first element of the allocated range.
+         * @return False if there is no free range large enough.
+         */
+        bool allocate(u32 count, u32& outOffset);
+        void free(u32 offset, u32 count);
+
+        /**
+         * Extend the space. Existing allocations are unchanged.
+         */
+        void grow(u32 newCapacity);
+
+        auto getCapacity() const -> u32;
+        auto getUsedCount() const -> u32;
+        auto getFreeCount() const -> u32;
+
+        /**
+         * @return Number of free elements that are not part of the free range at the end of the space. Compacting would reclaim these.
+         */
+        auto getFragmentedCount() const -> u32;
+
+    private:
+        void addFreeRange(u32 offset, u32 count);
+        void removeFreeRange(std::map<u32, u32>::iterator it);
+
+    private:
+        u32 m_capacity = 0;
+        u32 m_usedCount = 0;
+
+        std::map<u32, u32> m_freeByOffset;     // Offset -> Count
+        std::multimap<u32, u32> m_freeByCount;  // Count -> Offset
+    };
+}
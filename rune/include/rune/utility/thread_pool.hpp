@@ -0,0 +1,60 @@
+// # Copyright  Stuart Millman <stu.millman15@gmail.com>
+
+#pragma once
+
+#include "rune/defines.hpp"
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace Rune
+{
+    /**
+     * Fixed set of worker threads that split loops between them.
+     * The calling thread also takes part, so a pool with no workers runs everything inline.
+     */
+    class ThreadPool
+    {
+    public:
+        ~ThreadPool();
+
+        /**
+         * @param workerCount Number of threads to start. 0 to start one less than the hardware thread count.
+         */
+        void init(u32 workerCount = 0);
+        void cleanup();
+
+        /**
+         * Call func for every index in [0, count), spread across the workers. Blocks until every call has returned.
+         * Indices are handed out one at a time, so func should do a meaningful amount of work per index.
+         */
+        void parallelFor(u32 count, const std::function<void(u32)>& func);
+
+        /**
+         * @return Number of threads that run work, including the calling thread.
+         */
+        auto getThreadCount() const -> u32;
+
+    private:
+        void workerLoop();
+        void runJob();
+
+    private:
+        std::vector<std::thread> m_workers;
+
+        std::mutex m_mutex;
+        std::condition_variable m_wakeCondition;
+        std::condition_variable m_doneCondition;
+
+        const std::function<void(u32)>* m_job = nullptr;
+        u32 m_jobCount = 0;
+        std::atomic<u32> m_nextIndex = 0;
+        u32 m_busyWorkers = 0;
+        u64 m_jobGeneration = 0;
+        bool m_isStopping = false;
+    };
+}
@@ -4,9 +4,18 @@
 #include "rune/assets/asset_factory.hpp"
 
 #include "rune/macros.hpp"
+#include "rune/graphics/graphics.hpp"
 #include "rune/graphics/texture.hpp"
+#include "rune/graphics/texture_cache.hpp"
+#include "rune/graphics/texture_compress.hpp"
+#include "rune/graphics/texture_mips.hpp"
 #include "rune/graphics/mesh.hpp"
+#include "rune/graphics/mesh_optimize.hpp"
+#include "rune/graphics/mesh_simplify.hpp"
+#include "rune/graphics/vertex_quantize.hpp"
 #include "rune/graphics/shader.hpp"
+#include "rune/utility/hash.hpp"
+#include "rune/utility/mapped_file.hpp"
 
 #define STB_IMAGE_IMPLEMENTATION
 #include <stb/stb_image.h>
@@ -18,10 +27,28 @@
 #define TOML_EXCEPTIONS 0
 #include <toml++/toml.hpp>
 
+#include <algorithm>
+#include <array>
+#include <cctype>
 #include <filesystem>
+#include <string_view>
 
 namespace Rune
 {
+    namespace
+    {
+        /* A level is only kept if it removes at least this fraction of the previous level's triangles */
+        constexpr f32 MinLodReduction = 0.15f;
+
+        /* Submeshes are not simplified below this many triangles */
+        constexpr size MinLodTriangleCount = 32;
+
+        /* Meshes are quantized only if no vertex moves further than these, in mesh units, UV space and radians of normal angle */
+        constexpr f32 MaxQuantizedPositionError = 0.0005f;
+        constexpr f32 MaxQuantizedUvError = 1.0f / 2048.0f;
+        constexpr f32 MaxQuantizedNormalError = 0.1f * 3.14159265f / 180.0f;  // 0.1 degrees
+    }
+
     auto formatFromChannels(const i32 c) -> TextureFormat
     {
         if (c == 1)
@@ -34,17 +61,82 @@ namespace Rune
         return TextureFormat::eUnknown;
     }
 
+    /**
+     * Textures have no import settings, so guess what their channels hold from the words in their file name.
+     */
+    auto guessTextureUsage(const std::string& filename) -> TextureUsage
+    {
+        std::string stem = std::filesystem::path(filename).stem().string();
+        std::transform(stem.begin(), stem.end(), stem.begin(), [](const unsigned char c) { return static_cast<char>(std::tolower(c)); });
+
+        constexpr std::array<std::string_view, 3> NormalWords = { "normal", "norm", "nrm" };
+        constexpr std::array<std::string_view, 11> MaskWords = {
+            "ao", "occlusion", "rough", "roughness", "metal", "metallic", "spec", "specular", "gloss", "height", "mask"
+        };
+
+        auto start = stem.begin();
+        while (start != stem.end())
+        {
+            const auto end = std::find_if(start, stem.end(), [](const char c) { return std::isalpha(static_cast<unsigned char>(c)) == 0; });
+            const std::string_view word(&*start, static_cast<size>(end - start));
+
+            if (std::find(NormalWords.begin(), NormalWords.end(), word) != NormalWords.end())
+                return TextureUsage::eNormal;
+            if (std::find(MaskWords.begin(), MaskWords.end(), word) != MaskWords.end())
+                return TextureUsage::eMask;
+
+            start = end == stem.end() ? end : end + 1;
+        }
+        return TextureUsage::eColor;
+    }
+
+    auto calculateBounds(const std::vector<Vertex>& vertices, const size firstVertex, const size vertexCount) -> Bounds
+    {
+        if (vertexCount == 0)
+            return {};
+
+        return BoundsUtils::fromPoints(&vertices[firstVertex].pos, vertexCount, sizeof(Vertex));
+    }
+
+    /**
+     * Reorder a range of triangles for the post-transform vertex cache, then for less overdraw.
+     */
+    void optimizeTriangleOrder(const std::vector<Vertex>& vertices, u32* indices, const size indexCount)
+    {
+        MeshOptimize::optimizeVertexCache(indices, indexCount, vertices.size());
+        MeshOptimize::optimizeOverdraw(vertices, indices, indexCount);
+    }
+
     auto TextureFactory::createFromFile(const std::string& filename) -> Owned<Asset>
     {
         // Create texture
         auto texture = CreateOwned<Texture>();
 
+        MappedFile sourceFile;
+        if (!sourceFile.open(filename))
+        {
+            CORE_LOG_ERROR("Failed to load texture file: {}", filename);
+            return nullptr;
+        }
+
+        // The encoded mip chain is kept beside the image, so only the first load after the image changes decodes and encodes it
+        const auto cacheFilename = TextureCache::getCacheFilename(filename);
+        const u64 sourceHash = Hash::fnv1a(sourceFile.getData(), sourceFile.getSize());
+        if (const auto encoded = TextureCache::load(cacheFilename, sourceHash))
+        {
+            CORE_LOG_TRACE("Texture loaded {} from {}", filename, cacheFilename);
+            const auto width = static_cast<i32>(encoded->width);
+            const auto height = static_cast<i32>(encoded->height);
+            texture->init(width, height, encoded->format, encoded->mipCount, encoded->data);
+            return std::move(texture);
+        }
+
         // Enable flipping texture on load
         stbi_set_flip_vertically_on_load(true);
 
         // Load texture file
         i32 w, h, c;
-        auto* data = stbi_load(filename.c_str(), &w, &h, &c, 0);
+        auto* data = stbi_load_from_memory(sourceFile.getData(), static_cast<i32>(sourceFile.getSize()), &w, &h, &c, 0);
         if (data == nullptr)
         {
             CORE_LOG_ERROR("Failed to load texture file: {}", filename);
@@ -60,11 +152,61 @@ namespace Rune
             return nullptr;
         }
 
-        std::vector<u8> pixels;
-        pixels.assign(data, data + w * h * c);
+        const auto width = static_cast<u32>(w);
+        const auto height = static_cast<u32>(h);
+        const auto channels = static_cast<u32>(c);
+
+        const auto usage = guessTextureUsage(filename);
+        auto& threadPool = GraphicsSystem::getInstance().getThreadPool();
+
+        // Mips are filtered from the uncompressed pixels, filtering decoded blocks would compound their error
+        auto mips = TextureMips::generate(data, width, height, channels, usage, threadPool);
+        const u32 mipCount = static_cast<u32>(mips.size()) + 1;
+
+        // Block compress, so less memory is needed and sampled.
+        // Only the mips the texture starts with are encoded here, the finer ones are encoded in the background and streamed in
+        const auto compressedFormat = TextureCompress::chooseFormat(usage, data, width, height, channels);
+        auto& streamer = GraphicsSystem::getInstance().getTextureStreamer();
+        const u32 importedMip = streamer.getInitialResidentMip(width, height, mipCount);
+        std::vector<u8> blocks;
+        for (u32 level = importedMip; level < mipCount; ++level)
+        {
+            const auto levelBlocks = TextureCompress::compress(level == 0 ? data : mips[level - 1].data(),
+                                                               getMipLevelSize(width, level),
+                                                               getMipLevelSize(height, level),
+                                                               channels,
+                                                               compressedFormat,
+                                                               threadPool);
+            blocks.insert(blocks.end(), levelBlocks.begin(), levelBlocks.end());
+        }
+
+        const size compressedSize = getMipChainDataSize(compressedFormat, width, height, mipCount);
+        CORE_LOG_TRACE("Texture loaded {}", filename);
+        CORE_LOG_TRACE("  size  =  {}x{}, {} channels, {} mips", w, h, c, mipCount);
+        CORE_LOG_TRACE("  data  =  {} KiB -> {} KiB", getTextureDataSize(format, width, height) / 1024, compressedSize / 1024);
 
         // Init texture with loaded data
-        texture->init(w, h, format, pixels);
+        texture->init(w, h, compressedFormat, mipCount, blocks, importedMip);
+        if (importedMip == 0)
+        {
+            TextureCache::save(cacheFilename, sourceHash, { width, height, compressedFormat, mipCount, std::move(blocks) });
+        }
+        else
+        {
+            std::vector<u8> pixels(data, data + getTextureDataSize(format, width, height));
+            streamer.addImport({ texture.get(),
+                                 width,
+                                 height,
+                                 channels,
+                                 compressedFormat,
+                                 mipCount,
+                                 importedMip,
+                                 std::move(pixels),
+                                 std::move(mips),
+                                 std::move(blocks),
+                                 cacheFilename,
+                                 sourceHash });
+        }
 
         // Free texture data
         stbi_image_free(data);
@@ -98,23 +240,18 @@ namespace Rune
 
         std::vector<Vertex> vertices;
         size vertexCount = 0;
-        std::vector<u16> indices;
+        std::vector<u32> indices;
         size indexCount = 0;
 
         for (size meshIndex = 0; meshIndex < scene->mNumMeshes; ++meshIndex)
         {
             const auto* submesh = scene->mMeshes[meshIndex];
+            const auto baseVertex = vertexCount;
 
             // Vertices
             vertices.resize(vertexCount + submesh->mNumVertices);
             for (size vertIndex = 0; vertIndex < submesh->mNumVertices; ++vertIndex)
             {
-                if (vertexCount > u16_max)
-                {
-                    CORE_LOG_ERROR("Only 16bit indices are supported! So cannot have more than {} vertices!", u16_max);
-                    break;
-                }
-
                 auto& newVertex = vertices[vertexCount];
 
                 const auto& vert = submesh->mVertices[vertIndex];
@@ -133,6 +270,7 @@ namespace Rune
             Mesh::Submesh newSubmesh{};
             newSubmesh.firstIndex = indexCount;
             newSubmesh.indexCount = submesh->mNumFaces * 3;
+            newSubmesh.bounds = calculateBounds(vertices, baseVertex, vertexCount - baseVertex);
             newMesh->setSubmesh(meshIndex, newSubmesh);
 
             // Triangles
@@ -143,27 +281,137 @@ namespace Rune
 
                 RUNE_ENG_ASSERT(face.mNumIndices == 3, "Faces should consist of 3 vertices!");
 
-                indices[indexCount] = face.mIndices[0];
-                indices[indexCount + 1] = face.mIndices[1];
-                indices[indexCount + 2] = face.mIndices[2];
+                // Submeshes share one vertex array, so offset by the first vertex of this submesh
+                indices[indexCount] = baseVertex + face.mIndices[0];
+                indices[indexCount + 1] = baseVertex + face.mIndices[1];
+                indices[indexCount + 2] = baseVertex + face.mIndices[2];
 
                 indexCount += 3;
             }
         }
 
+        const auto bounds = calculateBounds(vertices, 0, vertexCount);
+
+        // Triangles are reordered within each submesh, so submesh ranges stay valid
+        const auto statsBefore = MeshOptimize::analyzeVertexCache(indices.data(), indexCount, vertexCount);
+        for (const auto& submesh : newMesh->getSubmeshes())
+        {
+            optimizeTriangleOrder(vertices, indices.data() + submesh.firstIndex, static_cast<size>(submesh.indexCount));
+        }
+
+        const auto lods = generateLods(*newMesh, vertices, indices);
+
+        // Last, as it renumbers the vertices. Every LOD only uses vertices of the full detail mesh, which comes first.
+        vertexCount = MeshOptimize::optimizeVertexFetch(vertices, indices.data(), indices.size());
+        const auto statsAfter = MeshOptimize::analyzeVertexCache(indices.data(), indexCount, vertexCount);
+
+        // Halve the vertex size wherever the precision lost is not noticeable
+        const auto quantizationError = VertexQuantize::measureError(vertices, VertexQuantize::computeEncoding(vertices));
+        const bool isQuantized = quantizationError.position <= MaxQuantizedPositionError &&
+                                 quantizationError.uv <= MaxQuantizedUvError && quantizationError.normal <= MaxQuantizedNormalError;
+        newMesh->setVertexFormat(isQuantized ? VertexFormat::eQuantized : VertexFormat::eFull);
+
         CORE_LOG_TRACE("Mesh loaded {}", filename);
         CORE_LOG_TRACE("  submeshes  =  {}", scene->mNumMeshes);
-        CORE_LOG_TRACE("   vertices  =  {}", vertexCount);
-        CORE_LOG_TRACE("    indices  =  {}", indexCount);
+        CORE_LOG_TRACE("   vertices  =  {} ({}, error {} / uv {} / normal {})",
+                       vertexCount,
+                       isQuantized ? "quantized" : "full",
+                       quantizationError.position,
+                       quantizationError.uv,
+                       quantizationError.normal);
+        CORE_LOG_TRACE("    indices  =  {} ({}bit)", indexCount, vertexCount > static_cast<size>(u16_max) + 1 ? 32 : 16);
+        CORE_LOG_TRACE("       acmr  =  {:.3f} -> {:.3f}", statsBefore.acmr, statsAfter.acmr);
+        CORE_LOG_TRACE("       atvr  =  {:.3f} -> {:.3f}", statsBefore.atvr, statsAfter.atvr);
+        for (u32 level = 1; level < lods.size(); ++level)
+        {
+            CORE_LOG_TRACE("      lod {}  =  {} indices, error {}", level, lods[level].indexCount, lods[level].error);
+        }
 
-        // Init mesh with loaded data
+        // Init mesh with loaded data. LODs last, as setting indices clears them.
         newMesh->setVertices(vertices);
         newMesh->setIndices(indices, MeshTopology::eTriangles);
+        newMesh->setLods(lods);
+        newMesh->setBounds(bounds);
+        RUNE_ENG_ASSERT(newMesh->getLod(0).firstIndex == 0 && newMesh->getLod(0).indexCount == static_cast<i32>(indexCount),
+                        "Mesh LOD 0 must cover exactly the full detail indices!");
         newMesh->apply();
 
         return std::move(newMesh);
     }
 
+    auto MeshFactory::generateLods(Mesh& mesh, const std::vector<Vertex>& vertices, std::vector<u32>& indices) -> std::vector<Mesh::Lod>
+    {
+        auto submeshes = mesh.getSubmeshes();
+        if (submeshes.empty())
+            return {};
+
+        const auto fullIndexCount = static_cast<i32>(indices.size());
+        std::vector<Mesh::Lod> lods = { { 0, fullIndexCount, 0.0f } };
+        for (auto& submesh : submeshes)
+        {
+            submesh.lods = { { submesh.firstIndex, submesh.indexCount, 0.0f } };
+        }
+
+        std::vector<u32> simplified;
+        for (u32 level = 1; level < Mesh::MaxLodCount; ++level)
+        {
+            const auto levelStart = static_cast<i32>(indices.size());
+            f32 levelError = 0.0f;
+
+            for (auto& submesh : submeshes)
+            {
+                // Always simplify from the full detail submesh, so the error is measured against the original surface
+                const auto& previous = submesh.lods.back();
+                const size targetIndexCount = std::max((static_cast<size>(submesh.indexCount) >> level) / 3, MinLodTriangleCount) * 3;
+
+                f32 error = previous.error;
+                simplified.clear();
+                if (targetIndexCount < static_cast<size>(previous.indexCount))
+                {
+                    error = MeshSimplify::simplify(
+                        vertices, indices.data() + submesh.firstIndex, static_cast<size>(submesh.indexCount), targetIndexCount, simplified);
+                }
+
+                // Carry the previous level forward if this one did not get simpler, every level must cover every submesh
+                if (simplified.empty() || simplified.size() > static_cast<size>(previous.indexCount))
+                {
+                    simplified.assign(indices.begin() + previous.firstIndex, indices.begin() + previous.firstIndex + previous.indexCount);
+                    error = previous.error;
+                }
+
+                optimizeTriangleOrder(vertices, simplified.data(), simplified.size());
+
+                const auto firstIndex = static_cast<i32>(indices.size());
+                indices.insert(indices.end(), simplified.begin(), simplified.end());
+                submesh.lods.push_back({ firstIndex, static_cast<i32>(simplified.size()), error });
+                levelError = std::max(levelError, error);
+            }
+
+            const auto levelIndexCount = static_cast<i32>(indices.size()) - levelStart;
+            if (static_cast<f32>(levelIndexCount) > static_cast<f32>(lods.back().indexCount) * (1.0f - MinLodReduction))
+            {
+                // Not worth keeping, nothing simplified enough
+                indices.resize(levelStart);
+                for (auto& submesh : submeshes)
+                {
+                    submesh.lods.pop_back();
+                }
+                break;
+            }
+
+            lods.push_back({ levelStart, levelIndexCount, levelError });
+        }
+
+        for (size i = 0; i < submeshes.size(); ++i)
+        {
+            mesh.setSubmesh(i, submeshes[i]);
+        }
+        if (lods.size() == 1)
+            return {};
+
+        return lods;
+    }
+
     auto ShaderFactory::createFromFile(const std::string& filename) -> Owned<Asset>
     {
         auto shader = CreateOwned<Shader>();
@@ -187,7 +435,19 @@ namespace Rune
         shader->setIsCompiled(isCompiled);
         shader->setVertexCode(readShaderSource(assetDirPath.string() + "/" + vertexFile));
         shader->setFragmentCode(readShaderSource(assetDirPath.string() + "/" + fragmentFile));
-        shader->reflect();
+
+        // Reflection is kept beside the shader, so only the first load after its code changes parses the SPIR-V
+        const auto reflectionFilename = std::filesystem::path(filename).replace_extension(".reflection").string();
+        const u64 codeHash = ShaderReflection::getCodeHash(shader.get());
+        if (auto reflectionData = ShaderReflection::load(reflectionFilename, codeHash))
+        {
+            shader->setReflectionData(*reflectionData);
+        }
+        else
+        {
+            shader->reflect();
+            ShaderReflection::save(reflectionFilename, codeHash, shader->getReflectionData());
+        }
 
         return std::move(shader);
     }
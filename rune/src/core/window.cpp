@@ -141,6 +141,8 @@ namespace Rune
         m_data.cursorMode = mode;
 
         auto* glfwWindow = static_cast<GLFWwindow*>(m_windowPtr);
+        if (glfwWindow == nullptr)
+            return;
 
         if (mode == CursorMode::eNormal)
         {
@@ -241,6 +243,9 @@ namespace Rune
 
     void WindowSystem::update() const
     {
+        if (m_windowPtr == nullptr)
+            return;
+
         glfwSwapBuffers(static_cast<GLFWwindow*>(m_windowPtr));
         glfwPollEvents();
     }
@@ -0,0 +1,116 @@
+// # Copyright  Stuart Millman <stu.millman15@gmail.com>
+
+#include "pch.hpp"
+#include "rune/graphics/draw_key.hpp"
+
+#include <bit>
+
+namespace Rune
+{
+    namespace
+    {
+        constexpr auto mask(const u32 bits) -> u64
+        {
+            return (u64(1) << bits) - 1;
+        }
+
+        static_assert(DrawKey::PassBits + 1 + DrawKey::ProgramBits + DrawKey::MaterialInstBits + DrawKey::MeshBits + DrawKey::SubmeshBits +
+                              DrawKey::LodBits + DrawKey::DepthBits ==
+                          64,
+                      "Draw key fields must fill 64bits!");
+
+        constexpr u32 TranslucentShift = 64 - DrawKey::PassBits - 1;
+        constexpr u32 PassShift = TranslucentShift + 1;
+
+        // Opaque field offsets
+        constexpr u32 OpaqueDepthShift = 0;
+        constexpr u32 OpaqueLodShift = OpaqueDepthShift + DrawKey::DepthBits;
+        constexpr u32 OpaqueSubmeshShift = OpaqueLodShift + DrawKey::LodBits;
+        constexpr u32 OpaqueMeshShift = OpaqueSubmeshShift + DrawKey::SubmeshBits;
+        constexpr u32 OpaqueMaterialInstShift = OpaqueMeshShift + DrawKey::MeshBits;
+        constexpr u32 OpaqueProgramShift = OpaqueMaterialInstShift + DrawKey::MaterialInstBits;
+
+        // Translucent field offsets
+        constexpr u32 TranslucentLodShift = 0;
+        constexpr u32 TranslucentSubmeshShift = TranslucentLodShift + DrawKey::LodBits;
+        constexpr u32 TranslucentMeshShift = TranslucentSubmeshShift + DrawKey::SubmeshBits;
+        constexpr u32 TranslucentMaterialInstShift = TranslucentMeshShift + DrawKey::MeshBits;
+        constexpr u32 TranslucentProgramShift = TranslucentMaterialInstShift + DrawKey::MaterialInstBits;
+        constexpr u32 TranslucentDepthShift = TranslucentProgramShift + DrawKey::ProgramBits;
+    }
+
+    auto DrawKey::encode(const RenderPass pass,
+                         const bool isTranslucent,
+                         const u32 program,
+                         const u32 materialInst,
+                         const u32 mesh,
+                         const u32 submesh,
+                         const u32 lod,
+                         const u16 depth) -> u64
+    {
+        u64 key = (static_cast<u64>(pass) & mask(PassBits)) << PassShift;
+        key |= static_cast<u64>(isTranslucent) << TranslucentShift;
+
+        if (isTranslucent)
+        {
+            // Invert depth so that further away draws come first (back-to-front)
+            const u16 invertedDepth = u16_max - depth;
+            key |= static_cast<u64>(invertedDepth) << TranslucentDepthShift;
+            key |= (static_cast<u64>(program) & mask(ProgramBits)) << TranslucentProgramShift;
+            key |= (static_cast<u64>(materialInst) & mask(MaterialInstBits)) << TranslucentMaterialInstShift;
+            key |= (static_cast<u64>(mesh) & mask(MeshBits)) << TranslucentMeshShift;
+            key |= (static_cast<u64>(submesh) & mask(SubmeshBits)) << TranslucentSubmeshShift;
+            key |= (static_cast<u64>(lod) & mask(LodBits)) << TranslucentLodShift;
+        }
+        else
+        {
+            key |= (static_cast<u64>(program) & mask(ProgramBits)) << OpaqueProgramShift;
+            key |= (static_cast<u64>(materialInst) & mask(MaterialInstBits)) << OpaqueMaterialInstShift;
+            key |= (static_cast<u64>(mesh) & mask(MeshBits)) << OpaqueMeshShift;
+            key |= (static_cast<u64>(submesh) & mask(SubmeshBits)) << OpaqueSubmeshShift;
+            key |= (static_cast<u64>(lod) & mask(LodBits)) << OpaqueLodShift;
+            key |= static_cast<u64>(depth) << OpaqueDepthShift;
+        }
+
+        return key;
+    }
+
+    auto DrawKey::decode(const u64 key) -> DrawKeyFields
+    {
+        DrawKeyFields fields{};
+        fields.pass = static_cast<RenderPass>((key >> PassShift) & mask(PassBits));
+        fields.isTranslucent = (key >> TranslucentShift) & 1;
+
+        if (fields.isTranslucent)
+        {
+            fields.depth = u16_max - static_cast<u16>((key >> TranslucentDepthShift) & mask(DepthBits));
+            fields.program = static_cast<u32>((key >> TranslucentProgramShift) & mask(ProgramBits));
+            fields.materialInst = static_cast<u32>((key >> TranslucentMaterialInstShift) & mask(MaterialInstBits));
+            fields.mesh = static_cast<u32>((key >> TranslucentMeshShift) & mask(MeshBits));
+            fields.submesh = static_cast<u32>((key >> TranslucentSubmeshShift) & mask(SubmeshBits));
+            fields.lod = static_cast<u32>((key >> TranslucentLodShift) & mask(LodBits));
+        }
+        else
+        {
+            fields.program = static_cast<u32>((key >> OpaqueProgramShift) & mask(ProgramBits));
+            fields.materialInst = static_cast<u32>((key >> OpaqueMaterialInstShift) & mask(MaterialInstBits));
+            fields.mesh = static_cast<u32>((key >> OpaqueMeshShift) & mask(MeshBits));
+            fields.submesh = static_cast<u32>((key >> OpaqueSubmeshShift) & mask(SubmeshBits));
+            fields.lod = static_cast<u32>((key >> OpaqueLodShift) & mask(LodBits));
+            fields.depth = static_cast<u16>((key >> OpaqueDepthShift) & mask(DepthBits));
+        }
+
+        return fields;
+    }
+
+    auto DrawKey::quantizeDepth(const f32 viewDepth) -> u16
+    {
+        if (!(viewDepth > 0.0f))
+            return 0;
+
+        // The bit pattern of a positive float increases with its value, so the top 16bits
+        // (sign, exponent and 7 mantissa bits) give a monotonic, range-independent quantization.
+        const auto bits = std::bit_cast<u32>(viewDepth);
+        return static_cast<u16>(bits >> 16);
+    }
+}
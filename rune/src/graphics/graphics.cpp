@@ -5,11 +5,68 @@
 
 #include "rune/macros.hpp"
 #include "rune/events/events.hpp"
+#include "rune/core/window.hpp"
+#include "rune/utility/radix_sort.hpp"
+
+#include "platform/null/renderer.hpp"
+
+#include <glm/geometric.hpp>
+
+#include <chrono>
+#include <limits>
 
 namespace Rune
 {
     static std::unordered_map<RenderingApi, GraphicsSystem::RendererFactoryFunc> s_factoryFuncsMap;
 
+    namespace
+    {
+        using Clock = std::chrono::high_resolution_clock;
+
+        auto elapsedMilliseconds(const Clock::time_point start, const Clock::time_point end) -> f32
+        {
+            return std::chrono::duration<f32, std::milli>(end - start).count();
+        }
+
+        /**
+         * @return Distance at which the light's attenuation drops its brightest channel below 1/256, or 0 if it never does.
+         */
+        auto getLightRange(const Light& light) -> f32
+        {
+            if (light.range > 0.0f)
+                return light.range;
+
+            const f32 maxIntensity = std::max({ light.diffuseColor.r, light.diffuseColor.g, light.diffuseColor.b });
+            const f32 cutoff = maxIntensity * 256.0f;
+
+            // Solve constant + linear * d + quadratic * d^2 = cutoff
+            if (light.quadratic > 0.0f)
+            {
+                const f32 discriminant = light.linear * light.linear - 4.0f * light.quadratic * (light.constant - cutoff);
+                return (-light.linear + std::sqrt(std::max(discriminant, 0.0f))) / (2.0f * light.quadratic);
+            }
+            if (light.linear > 0.0f)
+                return std::max(cutoff - light.constant, 0.0f) / light.linear;
+
+            return 0.0f;
+        }
+
+        /**
+         * Estimates the texture as stretched once across the renderable's bounding sphere, so tiled textures get coarser mips
+         * than they need.
+         * @return Coarsest mip with a texel for every pixel of the renderable on screen.
+         */
+        auto getMipForScreenSize(const Texture& texture, const f32 screenSize) -> u32
+        {
+            const auto texelCount = static_cast<f32>(std::max(texture.getWidth(), texture.getHeight()));
+            if (screenSize >= texelCount)
+                return 0;
+
+            const auto mip = static_cast<u32>(std::log2(texelCount / std::max(screenSize, 1.0f)));
+            return std::min(mip, texture.getMipCount() - 1);
+        }
+    }
+
     auto GraphicsSystem::getInstance() -> GraphicsSystem&
     {
         static GraphicsSystem renderingSystem;
@@ -24,18 +81,23 @@ namespace Rune
 
     void GraphicsSystem::init(const RenderingApi renderingApi)
     {
+        // Needs no GPU, so is available on every platform
+        registerRendererFactory(RenderingApi::eNull, Renderer_Null::create);
         initRendererFactories();
         setRenderingApi(renderingApi);
 
+        m_threadPool.init();
+
         EventSystem::listen<EventFramebufferSize>([this](const EventFramebufferSize& event)
                                                   { onFramebufferSize(event.width, event.height); });
-
-        m_sceneUbo = m_renderer->createBuffer(sizeof(Scene), &m_sceneData);
-        m_lightingUbo = m_renderer->createBuffer(sizeof(Lighting), &m_lightingData);
     }
 
     void GraphicsSystem::cleanup()
     {
+        stopStatsCapture();
+        m_textureStreamer.cleanup();
+        m_threadPool.cleanup();
+        m_shadowPass.cleanup();
         m_renderingApi = RenderingApi::eNone;
         m_renderer = nullptr;
     }
@@ -54,6 +116,7 @@ namespace Rune
         if (m_renderer != nullptr)
         {
             // Shutdown active renderer
+            m_shadowPass.cleanup();
             m_renderer->cleanup();
             m_renderer = nullptr;
         }
@@ -67,6 +130,8 @@ namespace Rune
         m_renderer = factoryFunc();
         m_renderer->init();
         m_renderer->setWindow(m_window);
+
+        m_shadowPass.init(m_renderer.get());
     }
 
     auto GraphicsSystem::getRenderer() const -> RendererBase*
@@ -74,6 +139,11 @@ namespace Rune
         return m_renderer.get();
     }
 
+    auto GraphicsSystem::getThreadPool() -> ThreadPool&
+    {
+        return m_threadPool;
+    }
+
     auto GraphicsSystem::getWindow() const -> WindowSystem*
     {
         return m_window;
@@ -83,6 +153,9 @@ namespace Rune
     {
         m_window = window;
         m_renderer->setWindow(m_window);
+
+        if (m_window != nullptr)
+            m_framebufferSize = { std::max<i32>(m_window->getWidth(), 1), std::max<i32>(m_window->getHeight(), 1) };
     }
 
     void GraphicsSystem::beginScene(const glm::mat4 proj, const glm::mat4& view, const Lighting& lighting)
@@ -91,29 +164,48 @@ namespace Rune
         m_sceneData.view = view;
         // TODO: Upload to scene UBO
 
-        m_lightingData = lighting;
-        // TODO: Only upload required lights
-        m_renderer->updateBuffer(m_lightingUbo, 0, sizeof(Lighting), &m_lightingData);
+        m_frustum = Frustum::fromMatrix(proj * view);
+
+        m_lighting = lighting;
     }
 
-    void GraphicsSystem::addRenderable(const glm::mat4& transform, Mesh* mesh, MaterialInst* material)
+    void GraphicsSystem::addRenderable(
+        const glm::mat4& transform, Mesh* mesh, MaterialInst* material, const bool isStatic, u8* lodState)
     {
-        if (canFrustumCull())
-        {
-            // TODO: Maybe add to list of culled objects, for debugging
-            return;
-        }
-
         auto& drawData = m_drawData.emplace_back();
         drawData.transform = transform;
         drawData.mesh = mesh;
         drawData.material = material;
+        drawData.batchMaterial = material;
+        drawData.isStatic = isStatic;
+        drawData.submesh = Mesh::AllSubmeshes;
+        drawData.lod = 0;
+        drawData.lodState = lodState;
+    }
+
+    void GraphicsSystem::addRenderable(const glm::mat4& transform,
+                                       Mesh* mesh,
+                                       const std::vector<MaterialInst*>& submeshMaterials,
+                                       const bool isStatic,
+                                       u8* lodState)
+    {
+        if (submeshMaterials.empty())
+            return;
+
+        const auto submeshCount = static_cast<u32>(mesh->getSubmeshes().size());
+        if (submeshCount <= 1)
+        {
+            addRenderable(transform, mesh, submeshMaterials[0], isStatic, lodState);
+            return;
+        }
 
-        DrawInstance instance{ .key = buildInstanceKey(), .drawDataIndex = m_drawData.size() - 1 };
+        for (u32 submesh = 0; submesh < submeshCount; ++submesh)
+        {
+            auto* material = submesh < submeshMaterials.size() ? submeshMaterials[submesh] : nullptr;
 
-        // Put instance in buckets
-        m_shadowBucket.push_back(instance);
-        m_geometryBucket.push_back(instance);
+            addRenderable(transform, mesh, material != nullptr ? material : submeshMaterials[0], isStatic, lodState);
+            m_drawData.back().submesh = submesh;
+        }
     }
 
     void GraphicsSystem::render()
@@ -121,72 +213,677 @@ namespace Rune
         if (m_renderer == nullptr)
             return;
 
-        std::sort(m_shadowBucket.begin(), m_shadowBucket.end());
-        std::sort(m_geometryBucket.begin(), m_geometryBucket.end());
+        const auto cullStart = Clock::now();
+        frustumCull();
+        selectLods();
+        requestTextureMips();
+
+        const auto sortStart = Clock::now();
+        for (u32 drawDataIndex = 0; drawDataIndex < m_drawData.size(); ++drawDataIndex)
+        {
+            auto& drawData = m_drawData[drawDataIndex];
+
+            // Casters outside the view can still shadow what is visible, so shadows are not camera culled
+            m_shadowBucket.push_back({ buildInstanceKey(RenderPass::eShadow, drawData), drawDataIndex });
+
+            if (!m_drawVisibility[drawDataIndex])
+                continue;
+
+            drawData.batchMaterial = drawData.material->getBatchInst();
+            m_geometryBucket.push_back({ buildInstanceKey(RenderPass::eGeometry, drawData), drawDataIndex });
+
+            // The depth program transforms positions like instanced material shaders do, so only those can be sure to match
+            const auto* material = drawData.material->getMaterial();
+            if (m_depthPrePassEnabled && !material->isTranslucent() && material->isDepthTested() && material->supportsInstancing() &&
+                drawData.mesh->getTopology() == MeshTopology::eTriangles)
+                m_depthPrePassBucket.push_back({ buildInstanceKey(RenderPass::eDepthPrePass, drawData), drawDataIndex });
+        }
+
+        if (m_drawSortingEnabled)
+        {
+            const auto getKey = [](const DrawInstance& instance) { return instance.key; };
+            radixSort(m_shadowBucket, m_sortScratch, getKey);
+            radixSort(m_depthPrePassBucket, m_sortScratch, getKey);
+            radixSort(m_geometryBucket, m_sortScratch, getKey);
+        }
+
+        buildDrawBatches(m_geometryBucket);
+        buildDepthPrePass();
 
+        const auto submitStart = Clock::now();
         m_renderer->beginFrame();
 
-        m_drawData[0].material->setFloat3("u_material.diffuse", { 1, 1, 1 });
-        m_drawData[0].material->setFloat("u_material.shininess", 32);
+        // Mips uploaded now can already be sampled by this frame's draws
+        m_textureStreamer.update();
+
+        // Before any draw reads them
+        uploadMaterialUniforms();
+
+        uploadLighting();
+        renderShadows();
 
-        for (const auto& instance : m_geometryBucket)
+        // Instanced draws read their world matrix from the instance buffer, so the scene only needs uploading once
+        m_sceneData.world = glm::mat4(1.0f);
+        const auto frameSceneRange = m_renderer->uploadFrameData(&m_sceneData, sizeof(Scene));
+
+        // Materials do not own the engine buffers, so these stay bound for the whole frame
+        m_renderer->bindFrameUniformBuffer(frameSceneRange, ShaderBindings::SceneUniformBuffer);
+
+        if (!m_instanceData.empty())
         {
-            const auto& drawData = m_drawData[instance.drawDataIndex];
-            m_renderer->bindMaterial(drawData.material);
-            m_renderer->bindUniformBuffer(m_sceneUbo, 0);
-            m_renderer->bindUniformBuffer(m_lightingUbo, 1);
+            const auto instanceRange = m_renderer->uploadFrameData(m_instanceData.data(), m_instanceData.size() * sizeof(InstanceData));
+            m_renderer->bindFrameStorageBuffer(instanceRange, ShaderBindings::InstanceStorageBuffer);
+        }
+
+        renderDepthPrePass();
 
-            m_renderer->bindMesh(drawData.mesh);
+        m_lastFrameBindCounts = {};
+        const Material* boundMaterial = nullptr;
+        const MaterialInst* boundMaterialInst = nullptr;
+        const Mesh* boundMesh = nullptr;
+        u32 boundLod = 0;
+        u32 boundSubmesh = Mesh::AllSubmeshes;
 
+        for (size batchIndex = 0; batchIndex < m_drawBatches.size(); ++batchIndex)
+        {
+            const auto& batch = m_drawBatches[batchIndex];
+            const auto& drawData = m_drawData[batch.drawDataIndex];
+
+            // Only rebind state that differs from the previous draw
+            if (drawData.batchMaterial != boundMaterialInst)
+            {
+                if (drawData.batchMaterial->getMaterial() != boundMaterial)
+                {
+                    boundMaterial = drawData.batchMaterial->getMaterial();
+                    ++m_lastFrameBindCounts.programBinds;
+                }
+
+                m_renderer->bindMaterial(drawData.batchMaterial);
+                m_textureStreamer.markUsed(*drawData.batchMaterial, m_frameIndex);
+                boundMaterialInst = drawData.batchMaterial;
+                ++m_lastFrameBindCounts.materialBinds;
+            }
+
+            // Restore the frame scene data in case a non-instanced draw replaced it (skipped by the renderer if unchanged)
+            if (batch.isInstanced)
+                m_renderer->bindFrameUniformBuffer(frameSceneRange, ShaderBindings::SceneUniformBuffer);
+
+            if (batch.isInstanced && m_multiDrawIndirectEnabled)
+            {
+                // Instanced batches sharing this material instance become one indirect draw, each command selecting its own mesh
+                m_drawCommands.clear();
+                for (; batchIndex < m_drawBatches.size(); ++batchIndex)
+                {
+                    const auto& nextBatch = m_drawBatches[batchIndex];
+                    const auto& nextDrawData = m_drawData[nextBatch.drawDataIndex];
+                    if (!nextBatch.isInstanced || nextDrawData.batchMaterial != drawData.batchMaterial ||
+                        nextDrawData.mesh->getTopology() != drawData.mesh->getTopology())
+                        break;
+
+                    m_drawCommands.push_back(
+                        { nextDrawData.mesh, nextBatch.instanceCount, nextBatch.firstInstance, nextDrawData.lod, nextDrawData.submesh });
+                }
+                --batchIndex;
+
+                m_renderer->drawIndirect(m_drawCommands.data(), static_cast<u32>(m_drawCommands.size()));
+                ++m_lastFrameBindCounts.drawCalls;
+                boundMesh = nullptr;
+                continue;
+            }
+
+            if (drawData.mesh != boundMesh || drawData.lod != boundLod || drawData.submesh != boundSubmesh)
+            {
+                m_renderer->bindMesh(drawData.mesh, drawData.lod, drawData.submesh);
+                boundMesh = drawData.mesh;
+                boundLod = drawData.lod;
+                boundSubmesh = drawData.submesh;
+                ++m_lastFrameBindCounts.meshBinds;
+            }
+
+            if (batch.isInstanced)
+            {
+                m_renderer->drawInstanced(batch.instanceCount, batch.firstInstance);
+                ++m_lastFrameBindCounts.drawCalls;
+                continue;
+            }
+
+            // Each draw gets its own copy of the scene data, written linearly into the frame buffer
             m_sceneData.world = drawData.transform;
-            // TODO: Only upload what changed
-            m_renderer->updateBuffer(m_sceneUbo, 0, sizeof(Scene), &m_sceneData);
+            const auto sceneRange = m_renderer->uploadFrameData(&m_sceneData, sizeof(Scene));
+            m_renderer->bindFrameUniformBuffer(sceneRange, ShaderBindings::SceneUniformBuffer);
 
             m_renderer->draw();
+            ++m_lastFrameBindCounts.drawCalls;
         }
 
         m_renderer->endFrame();
-
-        m_lightingData.lightCount = 0;
+        const auto submitEnd = Clock::now();
+
+        m_lastFrameStats = m_renderer->getLastFrameStats();
+        m_lastFrameStats.visibleRenderables = m_lastFrameCullCounts.visible;
+        m_lastFrameStats.culledRenderables = m_lastFrameCullCounts.culled;
+        m_lastFrameStats.shadowViewsRendered = m_shadowPass.getLastFrameCounts().viewsRendered;
+        m_lastFrameStats.shadowViewsCached = m_shadowPass.getLastFrameCounts().viewsCached;
+        m_lastFrameStats.textureMipsStreamed = m_textureStreamer.getLastFrameCounts().mipsStreamed;
+        m_lastFrameStats.textureMipsEvicted = m_textureStreamer.getLastFrameCounts().mipsEvicted;
+        m_lastFrameStats.textureMipsReloaded = m_textureStreamer.getLastFrameCounts().mipsReloaded;
+        m_lastFrameStats.texturesStreaming = m_textureStreamer.getLastFrameCounts().texturesPending;
+        m_lastFrameStats.textureResidentBytes = m_textureStreamer.getLastFrameCounts().residentDataSize;
+        m_lastFrameStats.cullTime = elapsedMilliseconds(cullStart, sortStart);
+        m_lastFrameStats.sortTime = elapsedMilliseconds(sortStart, submitStart);
+        m_lastFrameStats.submitTime = elapsedMilliseconds(submitStart, submitEnd);
+
+        m_statsWriter.write(m_frameIndex, m_lastFrameStats);
+        ++m_frameIndex;
+
+        m_lighting.lights.clear();
+        m_lighting.shadowCastingLights.clear();
         m_shadowBucket.clear();
+        m_depthPrePassBucket.clear();
         m_geometryBucket.clear();
         m_drawData.clear();
     }
 
-    void GraphicsSystem::onFramebufferSize(const i32 width, const i32 height) const
+    bool GraphicsSystem::isDrawSortingEnabled() const
+    {
+        return m_drawSortingEnabled;
+    }
+
+    void GraphicsSystem::setDrawSortingEnabled(const bool enabled)
+    {
+        m_drawSortingEnabled = enabled;
+    }
+
+    auto GraphicsSystem::getLastFrameBindCounts() const -> const DrawBindCounts&
+    {
+        return m_lastFrameBindCounts;
+    }
+
+    auto GraphicsSystem::getLastFrameStats() const -> const RenderStats&
+    {
+        return m_lastFrameStats;
+    }
+
+    bool GraphicsSystem::startStatsCapture(const std::string& filename)
+    {
+        if (!m_statsWriter.open(filename))
+            return false;
+
+        CORE_LOG_INFO("Capturing render stats to '{}'", filename);
+        return true;
+    }
+
+    void GraphicsSystem::stopStatsCapture()
+    {
+        m_statsWriter.close();
+    }
+
+    bool GraphicsSystem::isMultiDrawIndirectEnabled() const
+    {
+        return m_multiDrawIndirectEnabled;
+    }
+
+    void GraphicsSystem::setMultiDrawIndirectEnabled(const bool enabled)
+    {
+        m_multiDrawIndirectEnabled = enabled;
+    }
+
+    bool GraphicsSystem::isInstancingEnabled() const
+    {
+        return m_instancingEnabled;
+    }
+
+    void GraphicsSystem::setInstancingEnabled(const bool enabled)
+    {
+        m_instancingEnabled = enabled;
+    }
+
+    bool GraphicsSystem::isFrustumCullingEnabled() const
+    {
+        return m_frustumCullingEnabled;
+    }
+
+    void GraphicsSystem::setFrustumCullingEnabled(const bool enabled)
+    {
+        m_frustumCullingEnabled = enabled;
+    }
+
+    auto GraphicsSystem::getLastFrameCullCounts() const -> const DrawCullCounts&
     {
+        return m_lastFrameCullCounts;
+    }
+
+    auto GraphicsSystem::getShadowSettings() const -> const ShadowSettings&
+    {
+        return m_shadowPass.getSettings();
+    }
+
+    void GraphicsSystem::setShadowSettings(const ShadowSettings& settings)
+    {
+        m_shadowPass.setSettings(settings);
+    }
+
+    bool GraphicsSystem::isDepthPrePassEnabled() const
+    {
+        return m_depthPrePassEnabled;
+    }
+
+    void GraphicsSystem::setDepthPrePassEnabled(const bool enabled)
+    {
+        m_depthPrePassEnabled = enabled;
+    }
+
+    auto GraphicsSystem::getLodSettings() const -> const LodSettings&
+    {
+        return m_lodSettings;
+    }
+
+    void GraphicsSystem::setLodSettings(const LodSettings& settings)
+    {
+        m_lodSettings = settings;
+    }
+
+    auto GraphicsSystem::getTextureStreamer() -> TextureStreamer&
+    {
+        return m_textureStreamer;
+    }
+
+    void GraphicsSystem::queueUniformUpload(const MaterialInst* materialInst)
+    {
+        m_uniformUploadQueue.push_back(materialInst);
+    }
+
+    void GraphicsSystem::cancelUniformUpload(const MaterialInst* materialInst)
+    {
+        std::erase(m_uniformUploadQueue, materialInst);
+    }
+
+    void GraphicsSystem::onFramebufferSize(const i32 width, const i32 height)
+    {
+        m_framebufferSize = { std::max(width, 1), std::max(height, 1) };
+
         if (m_renderer == nullptr)
             return;
 
         m_renderer->onFramebufferSize(width, height);
     }
 
-    bool GraphicsSystem::canFrustumCull() const
+    void GraphicsSystem::uploadMaterialUniforms()
+    {
+        if (m_uniformUploadQueue.empty())
+            return;
+
+        m_uniformUploadRanges.clear();
+        m_uniformUploadData.clear();
+        for (const auto* materialInst : m_uniformUploadQueue)
+        {
+            materialInst->takeUniformUploads(m_uniformUploadRanges, m_uniformUploadData);
+        }
+        m_uniformUploadQueue.clear();
+
+        m_renderer->updateBufferRanges(m_uniformUploadRanges, m_uniformUploadData.data(), m_uniformUploadData.size());
+    }
+
+    void GraphicsSystem::uploadLighting()
+    {
+        m_lightingUniforms.viewPos = m_lighting.viewPos;
+        m_lightingUniforms.ambient = m_lighting.ambient;
+        m_lightingUniforms.globalLightCount = 0;
+
+        m_lightCastsShadows.assign(m_lighting.lights.size(), 0);
+        for (const auto lightIndex : m_lighting.shadowCastingLights)
+        {
+            if (lightIndex < m_lightCastsShadows.size())
+                m_lightCastsShadows[lightIndex] = 1;
+        }
+
+        // Split the lights into those that light everything and those that can be clustered, in view space
+        m_clusteredLights.clear();
+        m_clusteredLightSpheres.clear();
+        m_shadowedLights.clear();
+        for (size lightIndex = 0; lightIndex < m_lighting.lights.size(); ++lightIndex)
+        {
+            const auto& light = m_lighting.lights[lightIndex];
+            const f32 range = light.isDirectional ? 0.0f : getLightRange(light);
+            if (range <= 0.0f)
+            {
+                if (m_lightingUniforms.globalLightCount >= static_cast<i32>(Lighting::MaxGlobalLights))
+                    continue;
+
+                if (m_lightCastsShadows[lightIndex])
+                    m_shadowedLights.push_back({ light, m_lightingUniforms.globalLightCount });
+                m_lightingUniforms.globalLights[m_lightingUniforms.globalLightCount++] = light;
+                continue;
+            }
+
+            auto& clusteredLight = m_clusteredLights.emplace_back(light);
+            clusteredLight.range = range;
+            // A light given only a range fades out over it without any other attenuation
+            if (light.constant == 0.0f && light.linear == 0.0f && light.quadratic == 0.0f)
+                clusteredLight.constant = 1.0f;
+
+            if (m_lightCastsShadows[lightIndex])
+                m_shadowedLights.push_back({ clusteredLight, static_cast<i32>(m_clusteredLights.size() - 1) });
+
+            const auto viewCenter = glm::vec3(m_sceneData.view * glm::vec4(light.position, 1.0f));
+            m_clusteredLightSpheres.push_back({ viewCenter, range });
+        }
+
+        m_lightClusters.setProjection(m_sceneData.proj);
+        m_lightClusters.build(m_clusteredLightSpheres, m_threadPool);
+
+        m_lightingUniforms.clusterGrid = {
+            LightClusterGrid::TileCountX, LightClusterGrid::TileCountY, LightClusterGrid::SliceCount, static_cast<u32>(m_clusteredLights.size())
+        };
+        m_lightingUniforms.clusterDepth = {
+            m_lightClusters.getNearPlane(), m_lightClusters.getFarPlane(), m_lightClusters.getSliceScale(), m_lightClusters.getSliceBias()
+        };
+        m_lightingUniforms.clusterTileScale = { f32(LightClusterGrid::TileCountX) / f32(m_framebufferSize.x),
+                                                f32(LightClusterGrid::TileCountY) / f32(m_framebufferSize.y),
+                                                0.0f,
+                                                0.0f };
+
+        const auto lightingRange = m_renderer->uploadFrameData(&m_lightingUniforms, sizeof(LightingUniforms));
+        m_renderer->bindFrameUniformBuffer(lightingRange, ShaderBindings::LightingUniformBuffer);
+
+        // Storage buffer ranges cannot be empty
+        if (m_clusteredLights.empty())
+            m_clusteredLights.emplace_back();
+
+        const auto& clusters = m_lightClusters.getClusters();
+        const auto& lightIndices = m_lightClusters.getLightIndices();
+        const u32 emptyIndex = 0;
+
+        const auto lightsRange = m_renderer->uploadFrameData(m_clusteredLights.data(), m_clusteredLights.size() * sizeof(Light));
+        const auto clustersRange = m_renderer->uploadFrameData(clusters.data(), clusters.size() * sizeof(LightCluster));
+        const auto indicesRange = lightIndices.empty() ? m_renderer->uploadFrameData(&emptyIndex, sizeof(u32))
+                                                       : m_renderer->uploadFrameData(lightIndices.data(), lightIndices.size() * sizeof(u32));
+
+        m_renderer->bindFrameStorageBuffer(lightsRange, ShaderBindings::LightStorageBuffer);
+        m_renderer->bindFrameStorageBuffer(clustersRange, ShaderBindings::LightClusterStorageBuffer);
+        m_renderer->bindFrameStorageBuffer(indicesRange, ShaderBindings::LightIndexStorageBuffer);
+    }
+
+    void GraphicsSystem::renderShadows()
+    {
+        // The shadow bucket is sorted by mesh, so casters sharing a mesh end up in the same draw command
+        m_shadowCasters.clear();
+        for (const auto& instance : m_shadowBucket)
+        {
+            const auto& drawData = m_drawData[instance.drawDataIndex];
+            if (drawData.mesh->getTopology() != MeshTopology::eTriangles)
+                continue;
+
+            const auto& localBox = drawData.mesh->getBounds().box;
+            const auto worldBox = localBox.isValid() ? localBox.transformed(drawData.transform) : AABB{};
+            m_shadowCasters.push_back({ drawData.mesh, drawData.submesh, drawData.lod, drawData.transform, worldBox, drawData.isStatic });
+        }
+
+        m_shadowPass.render(m_sceneData.proj,
+                            m_sceneData.view,
+                            m_frustum,
+                            m_lightClusters.getNearPlane(),
+                            m_shadowedLights,
+                            m_shadowCasters,
+                            m_multiDrawIndirectEnabled);
+    }
+
+    void GraphicsSystem::buildDepthPrePass()
+    {
+        m_depthPrePassCommands.clear();
+        m_depthPrePassCulledCount = 0;
+
+        // Culled draws first, so each cull state is one contiguous run of commands even when the bucket is unsorted
+        for (const bool cullBackFaces : { true, false })
+        {
+            const size firstCommand = m_depthPrePassCommands.size();
+            for (const auto& instance : m_depthPrePassBucket)
+            {
+                const auto& drawData = m_drawData[instance.drawDataIndex];
+                if (drawData.material->getMaterial()->isDoubleSided() == cullBackFaces)
+                    continue;
+
+                const bool isSameRange = m_depthPrePassCommands.size() > firstCommand &&
+                                         m_depthPrePassCommands.back().mesh == drawData.mesh &&
+                                         m_depthPrePassCommands.back().submesh == drawData.submesh &&
+                                         m_depthPrePassCommands.back().lod == drawData.lod;
+                if (isSameRange)
+                    ++m_depthPrePassCommands.back().instanceCount;
+                else
+                    m_depthPrePassCommands.push_back(
+                        { drawData.mesh, 1, static_cast<u32>(m_instanceData.size()), drawData.lod, drawData.submesh });
+
+                m_instanceData.push_back(InstanceData::create(drawData.transform, drawData.mesh->getVertexEncoding()));
+            }
+
+            if (cullBackFaces)
+                m_depthPrePassCulledCount = static_cast<u32>(m_depthPrePassCommands.size());
+        }
+    }
+
+    void GraphicsSystem::renderDepthPrePass()
+    {
+        if (m_depthPrePassCommands.empty())
+            return;
+
+        const auto drawCommands = [this](const u32 firstCommand, const u32 commandCount, const bool cullBackFaces)
+        {
+            if (commandCount == 0)
+                return;
+
+            m_renderer->beginDepthPrePass(cullBackFaces);
+            if (m_multiDrawIndirectEnabled)
+            {
+                m_renderer->drawIndirect(&m_depthPrePassCommands[firstCommand], commandCount);
+            }
+            else
+            {
+                for (u32 i = firstCommand; i < firstCommand + commandCount; ++i)
+                {
+                    const auto& command = m_depthPrePassCommands[i];
+                    m_renderer->bindMesh(command.mesh, command.lod, command.submesh);
+                    m_renderer->drawInstanced(m_depthPrePassCommands[i].instanceCount, m_depthPrePassCommands[i].firstInstance);
+                }
+            }
+            m_renderer->endDepthPrePass();
+        };
+
+        drawCommands(0, m_depthPrePassCulledCount, true);
+        drawCommands(m_depthPrePassCulledCount,
+                     static_cast<u32>(m_depthPrePassCommands.size()) - m_depthPrePassCulledCount,
+                     false);
+    }
+
+    void GraphicsSystem::frustumCull()
+    {
+        m_drawVisibility.assign(m_drawData.size(), 1);
+        m_lastFrameCullCounts = { static_cast<u32>(m_drawData.size()), 0 };
+
+        if (!m_frustumCullingEnabled)
+            return;
+
+        // Gather world space boxes of everything that has bounds
+        m_cullBoxes.clear();
+        m_cullDrawDataIndices.clear();
+        for (u32 drawDataIndex = 0; drawDataIndex < m_drawData.size(); ++drawDataIndex)
+        {
+            const auto& drawData = m_drawData[drawDataIndex];
+            const auto& localBox = drawData.mesh->getBounds().box;
+            if (!localBox.isValid())
+                continue;
+
+            m_cullBoxes.add(localBox.transformed(drawData.transform));
+            m_cullDrawDataIndices.push_back(drawDataIndex);
+        }
+
+        const auto visibleCount = Culling::cullBoxes(m_frustum, m_cullBoxes, m_cullResults);
+
+        for (size i = 0; i < m_cullResults.size(); ++i)
+        {
+            m_drawVisibility[m_cullDrawDataIndices[i]] = m_cullResults[i];
+        }
+
+        const auto culledCount = static_cast<u32>(m_cullBoxes.count() - visibleCount);
+        m_lastFrameCullCounts = { static_cast<u32>(m_drawData.size()) - culledCount, culledCount };
+    }
+
+    void GraphicsSystem::selectLods()
     {
-        // TODO: Check if can be Frustum culled?
-        // TODO: Meshes need a bounding box (local space) (AABB?)
-        return false;
+        // Pixels covered by one unit at a view depth of 1 (or at any depth for an orthographic projection)
+        const bool isOrthographic = m_sceneData.proj[3][3] == 1.0f;
+        const f32 pixelsPerUnit = std::abs(m_sceneData.proj[1][1]) * static_cast<f32>(m_framebufferSize.y) * 0.5f;
+
+        for (auto& drawData : m_drawData)
+        {
+            drawData.lod = 0;
+            drawData.screenSize = std::numeric_limits<f32>::infinity();
+
+            const auto* mesh = drawData.mesh;
+            const auto& sphere = mesh->getBounds().sphere;
+            const u32 lodCount = mesh->getLodCount();
+            if (sphere.radius > 0.0f)
+            {
+                const auto& transform = drawData.transform;
+                const f32 maxScaleSqr = std::max({ glm::dot(glm::vec3(transform[0]), glm::vec3(transform[0])),
+                                                   glm::dot(glm::vec3(transform[1]), glm::vec3(transform[1])),
+                                                   glm::dot(glm::vec3(transform[2]), glm::vec3(transform[2])) });
+                const f32 maxScale = std::sqrt(maxScaleSqr);
+
+                const auto viewCenter = m_sceneData.view * transform * glm::vec4(sphere.center, 1.0f);
+                const f32 viewDepth = viewCenter.z;
+
+                // Inside (or behind) the bounding sphere the screen size is unbounded, so keep full detail
+                if (isOrthographic || viewDepth > sphere.radius * maxScale)
+                {
+                    // Pixels covered by one unit of mesh space at the renderable's distance
+                    const f32 pixelsPerMeshUnit = pixelsPerUnit * maxScale / (isOrthographic ? 1.0f : viewDepth);
+                    drawData.screenSize = 2.0f * sphere.radius * pixelsPerMeshUnit;
+
+                    if (m_lodSettings.enabled && lodCount > 1)
+                    {
+                        const auto pickLod = [&](const f32 sizeScale)
+                        {
+                            u32 lod = 0;
+                            while (lod + 1 < lodCount &&
+                                   mesh->getLod(lod + 1).error * pixelsPerMeshUnit * sizeScale <= m_lodSettings.maxPixelError)
+                                ++lod;
+                            return lod;
+                        };
+
+                        if (drawData.lodState != nullptr)
+                        {
+                            // Keep the previous LOD unless the size has moved past the switch point by the hysteresis margin
+                            const u32 finestLod = pickLod(1.0f + m_lodSettings.hysteresis);
+                            const u32 coarsestLod = pickLod(1.0f - m_lodSettings.hysteresis);
+                            drawData.lod = std::clamp<u32>(*drawData.lodState, finestLod, coarsestLod);
+                        }
+                        else
+                        {
+                            drawData.lod = pickLod(1.0f);
+                        }
+                    }
+                }
+            }
+
+            if (drawData.lodState != nullptr)
+                *drawData.lodState = static_cast<u8>(drawData.lod);
+        }
     }
 
-    auto GraphicsSystem::buildInstanceKey() -> u32
+    void GraphicsSystem::requestTextureMips()
     {
-        u32 key = 0;
+        for (u32 drawDataIndex = 0; drawDataIndex < m_drawData.size(); ++drawDataIndex)
+        {
+            if (!m_drawVisibility[drawDataIndex])
+                continue;
+
+            const auto& drawData = m_drawData[drawDataIndex];
+            for (const auto& slot : drawData.material->getTextureSlots())
+            {
+                // Texture arrays hold every mip of their layers
+                if (slot.texture != nullptr && !slot.isArray)
+                    slot.texture->requestMip(getMipForScreenSize(*slot.texture, drawData.screenSize));
+            }
+        }
+    }
 
-        bool isTransparent = true;
-        u8 materialIndex = 255;
-        u8 meshIndex = 4;
+    void GraphicsSystem::buildDrawBatches(const std::vector<DrawInstance>& bucket)
+    {
+        m_drawBatches.clear();
+        m_instanceData.clear();
 
-        key = (key | isTransparent) << 8;
-        key = (key | materialIndex) << 8;
-        key = (key | meshIndex);
+        for (size i = 0; i < bucket.size();)
+        {
+            const auto& first = m_drawData[bucket[i].drawDataIndex];
+            if (!first.material->getMaterial()->supportsInstancing())
+            {
+                // Shader reads its world matrix from the scene buffer, so must be drawn one at a time
+                m_drawBatches.push_back({ bucket[i].drawDataIndex, 0, 1, false });
+                ++i;
+                continue;
+            }
+
+            // Sorting places draws sharing a mesh range and batch material instance next to each other
+            size runEnd = i + 1;
+            while (m_instancingEnabled && runEnd < bucket.size())
+            {
+                const auto& next = m_drawData[bucket[runEnd].drawDataIndex];
+                if (next.mesh != first.mesh || next.submesh != first.submesh || next.lod != first.lod ||
+                    next.batchMaterial != first.batchMaterial)
+                    break;
+                ++runEnd;
+            }
+
+            auto& batch = m_drawBatches.emplace_back();
+            batch.drawDataIndex = bucket[i].drawDataIndex;
+            batch.firstInstance = static_cast<u32>(m_instanceData.size());
+            batch.instanceCount = static_cast<u32>(runEnd - i);
+            batch.isInstanced = true;
+
+            for (; i < runEnd; ++i)
+            {
+                const auto& drawData = m_drawData[bucket[i].drawDataIndex];
+                const auto& encoding = drawData.mesh->getVertexEncoding();
+                m_instanceData.push_back(InstanceData::create(drawData.transform, encoding, drawData.material->getTextureLayer()));
+            }
+        }
+    }
 
-        // CORE_LOG_TRACE("{:B}", key);
+    auto GraphicsSystem::buildInstanceKey(const RenderPass pass, const DrawData& drawData) const -> u64
+    {
+        // Shadow casters are drawn with a shared depth-only program, so only the mesh matters
+        if (pass == RenderPass::eShadow)
+            return DrawKey::encode(pass, false, 0, 0, drawData.mesh->getId(), drawData.submesh, drawData.lod, 0);
+
+        const auto* material = drawData.material->getMaterial();
+
+        // Distance along the view direction to the origin of the draw
+        const auto viewPos = m_sceneData.view * drawData.transform[3];
+        const auto depth = DrawKey::quantizeDepth(viewPos.z);
+
+        // Also a shared depth-only program, the only state that changes is culling. Front-to-back within each mesh.
+        if (pass == RenderPass::eDepthPrePass)
+            return DrawKey::encode(
+                pass, false, material->isDoubleSided(), 0, drawData.mesh->getId(), drawData.submesh, drawData.lod, depth);
+
+        return DrawKey::encode(pass,
+                               material->isTranslucent(),
+                               material->getId(),
+                               drawData.batchMaterial->getId(),
+                               drawData.mesh->getId(),
+                               drawData.submesh,
+                               drawData.lod,
+                               depth);
+    }
 
-        return key;
+    auto RendererBase::getLastFrameStats() const -> const RenderStats&
+    {
+        return m_lastFrameStats;
     }
 
-    bool GraphicsSystem::DrawInstance::operator<(const DrawInstance& other) const
+    void RendererBase::finishFrameStats()
     {
-        return other.key < other.key;
+        m_lastFrameStats = m_frameStats;
+        m_frameStats = {};
     }
 }
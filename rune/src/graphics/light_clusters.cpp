@@ -0,0 +1,208 @@
+// # Copyright  Stuart Millman <stu.millman15@gmail.com>
+
+#include "pch.hpp"
+#include "rune/graphics/light_clusters.hpp"
+
+#include "rune/utility/thread_pool.hpp"
+
+#include <glm/common.hpp>
+
+namespace Rune
+{
+    namespace
+    {
+        /**
+         * @return Inclusive range of tiles along one axis covered by [center - radius, center + radius] between two view depths.
+         */
+        auto getTileRange(const f32 center, const f32 radius, const f32 minDepth, const f32 maxDepth, const f32 projScale, const u32 tileCount)
+            -> std::pair<u32, u32>
+        {
+            // Dividing by depth moves the edge outwards at the nearest depth if it is off-center that way, otherwise at the furthest
+            const f32 minEdge = center - radius;
+            const f32 maxEdge = center + radius;
+            const f32 minNdc = minEdge * projScale / (minEdge < 0.0f ? minDepth : maxDepth);
+            const f32 maxNdc = maxEdge * projScale / (maxEdge > 0.0f ? minDepth : maxDepth);
+
+            const auto toTile = [tileCount](const f32 ndc)
+            { return static_cast<u32>(std::clamp((ndc * 0.5f + 0.5f) * f32(tileCount), 0.0f, f32(tileCount - 1))); };
+            return { toTile(minNdc), toTile(maxNdc) };
+        }
+    }
+
+    void LightClusterGrid::setProjection(const glm::mat4& proj)
+    {
+        if (proj == m_proj)
+            return;
+
+        m_proj = proj;
+
+        // Planes of a left-handed perspective projection with -1..1 depth
+        m_nearPlane = proj[3][2] / (-1.0f - proj[2][2]);
+        m_farPlane = proj[3][2] / (1.0f - proj[2][2]);
+
+        const f32 logDepthRatio = std::log(m_farPlane / m_nearPlane);
+        m_sliceScale = f32(SliceCount) / logDepthRatio;
+        m_sliceBias = -f32(SliceCount) * std::log(m_nearPlane) / logDepthRatio;
+
+        // A point at NDC x and view depth z sits at view x = ndcX * z / proj[0][0] (same for y)
+        for (u32 slice = 0; slice <= SliceCount; ++slice)
+        {
+            m_sliceDepths[slice] = m_nearPlane * std::pow(m_farPlane / m_nearPlane, f32(slice) / SliceCount);
+        }
+
+        m_clusterBounds.clear();
+        for (u32 slice = 0; slice < SliceCount; ++slice)
+        {
+            const f32 sliceNear = m_sliceDepths[slice];
+            const f32 sliceFar = m_sliceDepths[slice + 1];
+
+            for (u32 tileY = 0; tileY < TileCountY; ++tileY)
+            {
+                const f32 ndcMinY = -1.0f + 2.0f * f32(tileY) / TileCountY;
+                const f32 ndcMaxY = -1.0f + 2.0f * f32(tileY + 1) / TileCountY;
+
+                for (u32 tileX = 0; tileX < TileCountX; ++tileX)
+                {
+                    const f32 ndcMinX = -1.0f + 2.0f * f32(tileX) / TileCountX;
+                    const f32 ndcMaxX = -1.0f + 2.0f * f32(tileX + 1) / TileCountX;
+
+                    AABB box{};
+                    for (const f32 depth : { sliceNear, sliceFar })
+                    {
+                        box.expand(glm::vec3(ndcMinX * depth / proj[0][0], ndcMinY * depth / proj[1][1], depth));
+                        box.expand(glm::vec3(ndcMaxX * depth / proj[0][0], ndcMaxY * depth / proj[1][1], depth));
+                    }
+                    m_clusterBounds.add(box);
+                }
+            }
+        }
+    }
+
+    void LightClusterGrid::build(const std::vector<BoundingSphere>& lightSpheres, ThreadPool& threadPool)
+    {
+        // Depth range of each light, so a slice job only tests the lights that can reach it
+        m_lightMinSlice.resize(lightSpheres.size());
+        m_lightMaxSlice.resize(lightSpheres.size());
+        for (size i = 0; i < lightSpheres.size(); ++i)
+        {
+            const auto& sphere = lightSpheres[i];
+            const f32 minDepth = sphere.center.z - sphere.radius;
+            const f32 maxDepth = sphere.center.z + sphere.radius;
+            if (maxDepth < m_nearPlane || minDepth > m_farPlane)
+            {
+                m_lightMinSlice[i] = 1;
+                m_lightMaxSlice[i] = 0;
+                continue;
+            }
+
+            m_lightMinSlice[i] = getSlice(minDepth);
+            m_lightMaxSlice[i] = getSlice(maxDepth);
+        }
+
+        threadPool.parallelFor(SliceCount, [&](const u32 slice) { binSlice(slice, lightSpheres); });
+
+        // Concatenate the slices' lists, in cluster order
+        m_clusters.resize(ClusterCount);
+        m_lightIndices.clear();
+        for (u32 slice = 0; slice < SliceCount; ++slice)
+        {
+            const auto& bins = m_sliceBins[slice];
+
+            u32 offset = static_cast<u32>(m_lightIndices.size());
+            for (u32 tile = 0; tile < TilesPerSlice; ++tile)
+            {
+                m_clusters[slice * TilesPerSlice + tile] = { offset, bins.counts[tile] };
+                offset += bins.counts[tile];
+            }
+            m_lightIndices.insert(m_lightIndices.end(), bins.lightIndices.begin(), bins.lightIndices.end());
+        }
+    }
+
+    auto LightClusterGrid::getClusters() const -> const std::vector<LightCluster>&
+    {
+        return m_clusters;
+    }
+
+    auto LightClusterGrid::getLightIndices() const -> const std::vector<u32>&
+    {
+        return m_lightIndices;
+    }
+
+    auto LightClusterGrid::getNearPlane() const -> f32
+    {
+        return m_nearPlane;
+    }
+
+    auto LightClusterGrid::getFarPlane() const -> f32
+    {
+        return m_farPlane;
+    }
+
+    auto LightClusterGrid::getSliceScale() const -> f32
+    {
+        return m_sliceScale;
+    }
+
+    auto LightClusterGrid::getSliceBias() const -> f32
+    {
+        return m_sliceBias;
+    }
+
+    auto LightClusterGrid::getSlice(const f32 viewDepth) const -> u32
+    {
+        const f32 slice = std::log(std::max(viewDepth, m_nearPlane)) * m_sliceScale + m_sliceBias;
+        return std::min(static_cast<u32>(std::max(slice, 0.0f)), SliceCount - 1);
+    }
+
+    void LightClusterGrid::binSlice(const u32 slice, const std::vector<BoundingSphere>& lightSpheres)
+    {
+        auto& bins = m_sliceBins[slice];
+        bins.pairTiles.clear();
+        bins.pairLights.clear();
+
+        for (u32 lightIndex = 0; lightIndex < lightSpheres.size(); ++lightIndex)
+        {
+            if (slice < m_lightMinSlice[lightIndex] || slice > m_lightMaxSlice[lightIndex])
+                continue;
+
+            // Only test the tiles under the light's screen space rectangle within this slice
+            const auto& sphere = lightSpheres[lightIndex];
+            const f32 minDepth = std::max(sphere.center.z - sphere.radius, m_sliceDepths[slice]);
+            const f32 maxDepth = std::min(sphere.center.z + sphere.radius, m_sliceDepths[slice + 1]);
+            const auto [minTileX, maxTileX] = getTileRange(sphere.center.x, sphere.radius, minDepth, maxDepth, m_proj[0][0], TileCountX);
+            const auto [minTileY, maxTileY] = getTileRange(sphere.center.y, sphere.radius, minDepth, maxDepth, m_proj[1][1], TileCountY);
+
+            for (u32 tileY = minTileY; tileY <= maxTileY; ++tileY)
+            {
+                const u32 firstTile = tileY * TileCountX + minTileX;
+
+                bins.overlaps.clear();
+                Culling::overlapSphere(m_clusterBounds, slice * TilesPerSlice + firstTile, maxTileX - minTileX + 1, sphere, bins.overlaps);
+                for (const auto tile : bins.overlaps)
+                {
+                    bins.pairTiles.push_back(firstTile + tile);
+                    bins.pairLights.push_back(lightIndex);
+                }
+            }
+        }
+
+        // Counting sort the pairs by tile. Lights were visited in order, so each tile's lights stay in ascending order.
+        bins.counts.fill(0);
+        for (const auto tile : bins.pairTiles)
+        {
+            ++bins.counts[tile];
+        }
+
+        std::array<u32, TilesPerSlice> writeOffsets{};
+        for (u32 tile = 1; tile < TilesPerSlice; ++tile)
+        {
+            writeOffsets[tile] = writeOffsets[tile - 1] + bins.counts[tile - 1];
+        }
+
+        bins.lightIndices.resize(bins.pairTiles.size());
+        for (size i = 0; i < bins.pairTiles.size(); ++i)
+        {
+            bins.lightIndices[writeOffsets[bins.pairTiles[i]]++] = bins.pairLights[i];
+        }
+    }
+}
@@ -6,11 +6,15 @@
 #include "rune/macros.hpp"
 #include "rune/graphics/graphics.hpp"
 #include "rune/graphics/shader.hpp"
+#include "rune/graphics/texture_array.hpp"
+#include "rune/utility/hash.hpp"
 
 #include <glm/gtc/type_ptr.hpp>
 
+#include <cstring>
+
 #define GET_UNIFORM(type)                                                     \
-    const auto* member = getUniformBufferMember(name);                        \
+    const auto* member = getUniformBufferMember(handle);                      \
     if (member == nullptr)                                                    \
         return {};                                                            \
                                                                               \
@@ -19,20 +23,29 @@
     return value
 
 #define SET_UNIFORM(type, value_ptr)                                          \
-    const auto* member = getUniformBufferMember(name);                        \
+    const auto* member = getUniformBufferMember(handle);                      \
     if (member == nullptr)                                                    \
         return;                                                               \
                                                                               \
     const auto& uniformBuffer = m_uniformBuffers[member->uniformBufferIndex]; \
     uniformBuffer.data.write(value_ptr, sizeof(type), member->byteOffset)
 
-#define UPDATE_UNIFORM_BUFFER()                                                         \
-    auto* renderer = GraphicsSystem::getInstance().getRenderer();                       \
-    void* newData = uniformBuffer.data.readBytes(member->byteSize, member->byteOffset); \
-    renderer->updateBuffer(uniformBuffer.internalId, member->byteOffset, member->byteSize, newData)
+#define SET_INSTANCE_UNIFORM(type, value_ptr)            \
+    const auto* member = getUniformBufferMember(handle); \
+    if (member == nullptr)                               \
+        return;                                          \
+                                                         \
+    writeUniform(*member, value_ptr, sizeof(type))
 
 namespace Rune
 {
+    namespace
+    {
+        u32 s_nextMaterialInstId = 1;
+    }
+
+    Material::Material() = default;
+
     Material::~Material()
     {
         // Kill default instance
@@ -68,6 +81,7 @@ namespace Rune
         // Create default instance
         m_defaultInstance = CreateOwned<MaterialInst>();
         m_defaultInstance->init(this);
+        markBatchesDirty();
     }
 
     auto Material::getDefaultInstance() const -> MaterialInst*
@@ -79,29 +93,206 @@ namespace Rune
     {
         m_instances.push_back(CreateOwned<MaterialInst>());
         m_instances.back()->init(this);
+        markBatchesDirty();
         return m_instances.back().get();
     }
 
-    auto Material::getFloat(const std::string& name) const -> float
+    bool Material::packInstanceTextures()
+    {
+        const auto instances = getAllInstances();
+        if (instances.size() > TextureArray::MaxLayerCount)
+        {
+            CORE_LOG_WARN("Cannot pack the textures of more than {} material instances!", TextureArray::MaxLayerCount);
+            return false;
+        }
+
+        // Check every slot before replacing any arrays, so a failure leaves the previous packing in use
+        for (size slotIndex = 0; slotIndex < m_textures.size(); ++slotIndex)
+        {
+            if (!m_textures[slotIndex].isArray)
+                continue;
+
+            const auto* first = instances.front()->m_textures[slotIndex].texture;
+            for (const auto* instance : instances)
+            {
+                const auto* texture = instance->m_textures[slotIndex].texture;
+                if (texture == nullptr || first == nullptr || !TextureArray::isCompatible(*first, *texture))
+                {
+                    CORE_LOG_WARN("Cannot pack texture '{}', every instance needs one of the same size, format and mip count!",
+                                  m_textures[slotIndex].name);
+                    return false;
+                }
+                if (texture->getImportedMip() != 0)
+                {
+                    CORE_LOG_WARN("Cannot pack texture '{}' before every mip of it has been imported!", m_textures[slotIndex].name);
+                    return false;
+                }
+            }
+        }
+
+        for (auto* instance : instances)
+        {
+            for (auto& slot : instance->m_textures)
+                slot.textureArray = nullptr;
+        }
+        m_textureArrays.clear();
+
+        std::vector<Texture*> layers(instances.size());
+        for (size slotIndex = 0; slotIndex < m_textures.size(); ++slotIndex)
+        {
+            if (!m_textures[slotIndex].isArray)
+                continue;
+
+            for (size layer = 0; layer < instances.size(); ++layer)
+                layers[layer] = instances[layer]->m_textures[slotIndex].texture;
+
+            auto& textureArray = m_textureArrays.emplace_back(CreateOwned<TextureArray>());
+            textureArray->init(layers);
+            for (auto* instance : instances)
+                instance->m_textures[slotIndex].textureArray = textureArray.get();
+        }
+
+        for (size layer = 0; layer < instances.size(); ++layer)
+            instances[layer]->m_textureLayer = static_cast<u32>(layer);
+
+        markBatchesDirty();
+        return true;
+    }
+
+    void Material::markBatchesDirty()
+    {
+        m_batchesDirty = true;
+    }
+
+    void Material::updateBatchInstances()
+    {
+        if (!m_batchesDirty)
+            return;
+        m_batchesDirty = false;
+
+        // Few instances differ per material, so each is compared against the first instance of every batch so far
+        std::vector<MaterialInst*> batchInstances;
+        for (auto* instance : getAllInstances())
+        {
+            instance->m_batchInst = instance;
+            for (auto* batchInst : batchInstances)
+            {
+                if (batchInst->hasSameBindings(*instance))
+                {
+                    instance->m_batchInst = batchInst;
+                    break;
+                }
+            }
+
+            if (instance->m_batchInst == instance)
+                batchInstances.push_back(instance);
+        }
+    }
+
+    bool Material::isTranslucent() const
+    {
+        return m_translucent;
+    }
+
+    void Material::setTranslucent(const bool translucent)
+    {
+        m_translucent = translucent;
+    }
+
+    bool Material::isDoubleSided() const
+    {
+        return m_doubleSided;
+    }
+
+    void Material::setDoubleSided(const bool doubleSided)
+    {
+        m_doubleSided = doubleSided;
+    }
+
+    bool Material::isDepthTested() const
+    {
+        return m_depthTest;
+    }
+
+    void Material::setDepthTest(const bool depthTest)
+    {
+        m_depthTest = depthTest;
+    }
+
+    bool Material::supportsInstancing() const
+    {
+        return m_supportsInstancing;
+    }
+
+    auto Material::findUniform(const std::string_view name) const -> UniformHandle
+    {
+        const auto it = m_uniformMemberIndices.find(Hash::fnv1aString(name));
+        if (it == m_uniformMemberIndices.end())
+        {
+            CORE_LOG_WARN("Uniform member '{}' does not exist!", name);
+            return {};
+        }
+
+        return { it->second };
+    }
+
+    auto Material::findUniform(const u64 id) const -> UniformHandle
+    {
+        const auto it = m_uniformMemberIndices.find(id);
+        if (it == m_uniformMemberIndices.end())
+        {
+            CORE_LOG_WARN("Uniform member with id {:#x} does not exist!", id);
+            return {};
+        }
+
+        return { it->second };
+    }
+
+    auto Material::getUniformBufferMember(const UniformHandle handle) const -> const UniformBufferMember*
+    {
+        return handle.isValid() ? &m_uniformMembers[handle.index] : nullptr;
+    }
+
+    auto Material::getFloat(const UniformHandle handle) const -> float
     {
         GET_UNIFORM(float);
     }
 
-    void Material::setFloat(const std::string& name, const float value) const
+    void Material::setFloat(const UniformHandle handle, const float value) const
     {
         SET_UNIFORM(float, &value);
     }
 
-    auto Material::getMat4(const std::string& name) const -> glm::mat4
+    auto Material::getFloat(const std::string& name) const -> float
+    {
+        return getFloat(findUniform(name));
+    }
+
+    void Material::setFloat(const std::string& name, const float value) const
+    {
+        setFloat(findUniform(name), value);
+    }
+
+    auto Material::getMat4(const UniformHandle handle) const -> glm::mat4
     {
         GET_UNIFORM(glm::mat4);
     }
 
-    void Material::setMat4(const std::string& name, const glm::mat4& value) const
+    void Material::setMat4(const UniformHandle handle, const glm::mat4& value) const
     {
         SET_UNIFORM(glm::mat4, glm::value_ptr(value));
     }
 
+    auto Material::getMat4(const std::string& name) const -> glm::mat4
+    {
+        return getMat4(findUniform(name));
+    }
+
+    void Material::setMat4(const std::string& name, const glm::mat4& value) const
+    {
+        setMat4(findUniform(name), value);
+    }
+
     void Material::setTexture(const std::string& name, Texture* texture)
     {
         const auto it = m_textureMap.find(name);
@@ -141,6 +332,9 @@ namespace Rune
             {
                 if (binding.type == BindingType::eUniformBuffer)
                 {
+                    if (ShaderBindings::isEngineUniformBuffer(binding.binding))
+                        continue;
+
                     // Create buffer
                     u32 uniformBufferIndex = m_uniformBuffers.size();
                     auto& uniformBuffer = m_uniformBuffers.emplace_back();
@@ -150,44 +344,58 @@ namespace Rune
 
                     for (const auto& bufferMember : binding.bufferMembers)
                     {
-                        auto memberName = binding.name + "." + bufferMember.name;
-
-                        m_uniformMemberMap[memberName] = {
+                        m_uniformMemberIndices[bufferMember.id] = static_cast<u32>(m_uniformMembers.size());
+                        m_uniformMembers.push_back({
                             uniformBufferIndex,
                             bufferMember.byteOffset,
                             bufferMember.byteSize,
-                        };
+                        });
                     }
                 }
-                else if (binding.type == BindingType::eTexture)
+                else if (binding.type == BindingType::eTexture || binding.type == BindingType::eTextureArray)
                 {
+                    if (ShaderBindings::isEngineTexture(binding.binding))
+                        continue;
+
                     auto textureIndex = m_textures.size();
 
                     auto& texture = m_textures.emplace_back();
                     texture.name = binding.name;
                     texture.binding = binding.binding;
+                    texture.isArray = binding.type == BindingType::eTextureArray;
 
                     m_textureMap[binding.name] = textureIndex;
                 }
+                else if (binding.type == BindingType::eStorageBuffer)
+                {
+                    if (binding.binding == ShaderBindings::InstanceStorageBuffer)
+                        m_supportsInstancing = true;
+                }
             }
         }
     }
 
-    auto Material::getUniformBufferMember(const std::string& name) const -> const UniformBufferMember*
+    auto Material::getAllInstances() const -> std::vector<MaterialInst*>
     {
-        const auto it = m_uniformMemberMap.find(name);
-        if (it == m_uniformMemberMap.end())
-        {
-            CORE_LOG_WARN("Uniform member '{}' does not exist!", name);
-            return nullptr;
-        }
+        std::vector<MaterialInst*> instances;
+        instances.reserve(m_instances.size() + 1);
+        instances.push_back(m_defaultInstance.get());
+        for (const auto& instance : m_instances)
+            instances.push_back(instance.get());
+        return instances;
+    }
 
-        return &it->second;
+    MaterialInst::~MaterialInst()
+    {
+        if (m_uniformUploadQueued)
+            GraphicsSystem::getInstance().cancelUniformUpload(this);
     }
 
     void MaterialInst::init(Material* material)
     {
         m_material = material;
+        m_id = s_nextMaterialInstId++;
+        m_batchInst = this;
 
         initUniforms();
     }
@@ -197,88 +405,187 @@ namespace Rune
         return m_material;
     }
 
-    auto MaterialInst::getInt(const std::string& name) const -> i32
+    auto MaterialInst::getId() const -> u32
+    {
+        return m_id;
+    }
+
+    auto MaterialInst::getTextureLayer() const -> u32
+    {
+        return m_textureLayer;
+    }
+
+    auto MaterialInst::getBatchInst() const -> MaterialInst*
+    {
+        m_material->updateBatchInstances();
+        return m_batchInst;
+    }
+
+    bool MaterialInst::hasSameBindings(const MaterialInst& other) const
+    {
+        for (size i = 0; i < m_uniformBuffers.size(); ++i)
+        {
+            const auto& data = m_uniformBuffers[i].data;
+            const auto& otherData = other.m_uniformBuffers[i].data;
+            if (data.getSize() != otherData.getSize() || std::memcmp(data.getData(), otherData.getData(), data.getSize()) != 0)
+                return false;
+        }
+
+        for (size i = 0; i < m_textures.size(); ++i)
+        {
+            // Array slots only need the same array, each instance samples its own layer
+            const auto& slot = m_textures[i];
+            const auto& otherSlot = other.m_textures[i];
+            if (slot.isArray ? slot.textureArray != otherSlot.textureArray : slot.texture != otherSlot.texture)
+                return false;
+        }
+        return true;
+    }
+
+    auto MaterialInst::getInt(const UniformHandle handle) const -> i32
     {
         GET_UNIFORM(i32);
     }
 
+    void MaterialInst::setInt(const UniformHandle handle, const i32 value) const
+    {
+        SET_INSTANCE_UNIFORM(i32, &value);
+    }
+
+    auto MaterialInst::getInt(const std::string& name) const -> i32
+    {
+        return getInt(m_material->findUniform(name));
+    }
+
     void MaterialInst::setInt(const std::string& name, const i32 value) const
     {
-        SET_UNIFORM(i32, &value);
-        UPDATE_UNIFORM_BUFFER();
+        setInt(m_material->findUniform(name), value);
     }
 
-    auto MaterialInst::getFloat(const std::string& name) const -> float
+    auto MaterialInst::getFloat(const UniformHandle handle) const -> float
     {
         GET_UNIFORM(float);
     }
 
+    void MaterialInst::setFloat(const UniformHandle handle, const float value) const
+    {
+        SET_INSTANCE_UNIFORM(float, &value);
+    }
+
+    auto MaterialInst::getFloat(const std::string& name) const -> float
+    {
+        return getFloat(m_material->findUniform(name));
+    }
+
     void MaterialInst::setFloat(const std::string& name, const float value) const
     {
-        SET_UNIFORM(float, &value);
-        UPDATE_UNIFORM_BUFFER();
+        setFloat(m_material->findUniform(name), value);
     }
 
-    auto MaterialInst::getFloat2(const std::string& name) const -> glm::vec2
+    auto MaterialInst::getFloat2(const UniformHandle handle) const -> glm::vec2
     {
         GET_UNIFORM(glm::vec2);
     }
 
+    void MaterialInst::setFloat2(const UniformHandle handle, const glm::vec2& value) const
+    {
+        SET_INSTANCE_UNIFORM(glm::vec2, glm::value_ptr(value));
+    }
+
+    auto MaterialInst::getFloat2(const std::string& name) const -> glm::vec2
+    {
+        return getFloat2(m_material->findUniform(name));
+    }
+
     void MaterialInst::setFloat2(const std::string& name, const glm::vec2& value) const
     {
-        SET_UNIFORM(glm::vec2, glm::value_ptr(value));
-        UPDATE_UNIFORM_BUFFER();
+        setFloat2(m_material->findUniform(name), value);
     }
 
-    auto MaterialInst::getFloat3(const std::string& name) const -> glm::vec3
+    auto MaterialInst::getFloat3(const UniformHandle handle) const -> glm::vec3
     {
         GET_UNIFORM(glm::vec3);
     }
 
+    void MaterialInst::setFloat3(const UniformHandle handle, const glm::vec3& value) const
+    {
+        SET_INSTANCE_UNIFORM(glm::vec3, glm::value_ptr(value));
+    }
+
+    auto MaterialInst::getFloat3(const std::string& name) const -> glm::vec3
+    {
+        return getFloat3(m_material->findUniform(name));
+    }
+
     void MaterialInst::setFloat3(const std::string& name, const glm::vec3& value) const
     {
-        SET_UNIFORM(glm::vec3, glm::value_ptr(value));
-        UPDATE_UNIFORM_BUFFER();
+        setFloat3(m_material->findUniform(name), value);
     }
 
-    auto MaterialInst::getFloat4(const std::string& name) const -> glm::vec4
+    auto MaterialInst::getFloat4(const UniformHandle handle) const -> glm::vec4
     {
         GET_UNIFORM(glm::vec4);
     }
 
+    void MaterialInst::setFloat4(const UniformHandle handle, const glm::vec4& value) const
+    {
+        SET_INSTANCE_UNIFORM(glm::vec4, glm::value_ptr(value));
+    }
+
+    auto MaterialInst::getFloat4(const std::string& name) const -> glm::vec4
+    {
+        return getFloat4(m_material->findUniform(name));
+    }
+
     void MaterialInst::setFloat4(const std::string& name, const glm::vec4& value) const
     {
-        SET_UNIFORM(glm::vec4, glm::value_ptr(value));
-        UPDATE_UNIFORM_BUFFER();
+        setFloat4(m_material->findUniform(name), value);
     }
 
-    auto MaterialInst::getMat4(const std::string& name) const -> glm::mat4
+    auto MaterialInst::getMat4(const UniformHandle handle) const -> glm::mat4
     {
         GET_UNIFORM(glm::mat4);
     }
 
+    void MaterialInst::setMat4(const UniformHandle handle, const glm::mat4& value) const
+    {
+        SET_INSTANCE_UNIFORM(glm::mat4, glm::value_ptr(value));
+    }
+
+    auto MaterialInst::getMat4(const std::string& name) const -> glm::mat4
+    {
+        return getMat4(m_material->findUniform(name));
+    }
+
     void MaterialInst::setMat4(const std::string& name, const glm::mat4& value) const
     {
-        SET_UNIFORM(glm::mat4, glm::value_ptr(value));
-        UPDATE_UNIFORM_BUFFER();
+        setMat4(m_material->findUniform(name), value);
     }
 
-    auto MaterialInst::getData(const std::string& name) const -> const void*
+    auto MaterialInst::getData(const UniformHandle handle) const -> const void*
     {
         GET_UNIFORM(const void*);
     }
 
-    void MaterialInst::setData(const std::string& name, const i32 size, const void* data) const
+    void MaterialInst::setData(const UniformHandle handle, const i32 size, const void* data) const
     {
-        const auto* member = getUniformBufferMember(name);
+        const auto* member = getUniformBufferMember(handle);
         if (member == nullptr)
             return;
 
         RUNE_ENG_ASSERT(size <= member->byteSize, "Uniform write size overflow!");
 
-        const auto& uniformBuffer = m_uniformBuffers[member->uniformBufferIndex];
-        uniformBuffer.data.write(data, size, member->byteOffset);
-        UPDATE_UNIFORM_BUFFER();
+        writeUniform(*member, data, static_cast<u32>(size));
+    }
+
+    auto MaterialInst::getData(const std::string& name) const -> const void*
+    {
+        return getData(m_material->findUniform(name));
+    }
+
+    void MaterialInst::setData(const std::string& name, const i32 size, const void* data) const
+    {
+        setData(m_material->findUniform(name), size, data);
     }
 
     void MaterialInst::setTexture(const std::string& name, Texture* texture)
@@ -292,7 +599,14 @@ namespace Rune
 
         const auto textureSlot = it->second;
 
-        m_textures[textureSlot].texture = texture;
+        auto& slot = m_textures[textureSlot];
+        if (slot.textureArray != nullptr && slot.texture != texture)
+        {
+            CORE_LOG_WARN("Texture '{}' is not sampled until the material packs its instance textures again", name);
+            slot.textureArray = nullptr;
+        }
+        slot.texture = texture;
+        m_material->markBatchesDirty();
     }
 
     auto MaterialInst::getUniformBuffers() const -> const std::vector<UniformBuffer>&
@@ -305,6 +619,25 @@ namespace Rune
         return m_textures;
     }
 
+    void MaterialInst::takeUniformUploads(std::vector<BufferRangeUpdate>& ranges, std::vector<u8>& data) const
+    {
+        for (const auto& uniformBuffer : m_uniformBuffers)
+        {
+            if (uniformBuffer.dirtyBegin == uniformBuffer.dirtyEnd)
+                continue;
+
+            const u32 byteSize = uniformBuffer.dirtyEnd - uniformBuffer.dirtyBegin;
+            ranges.push_back({ uniformBuffer.internalId, uniformBuffer.dirtyBegin, byteSize, static_cast<u32>(data.size()) });
+
+            const auto* bytes = static_cast<const u8*>(uniformBuffer.data.getData()) + uniformBuffer.dirtyBegin;
+            data.insert(data.end(), bytes, bytes + byteSize);
+
+            uniformBuffer.dirtyBegin = 0;
+            uniformBuffer.dirtyEnd = 0;
+        }
+        m_uniformUploadQueued = false;
+    }
+
     void MaterialInst::initUniforms()
     {
         auto* renderer = GraphicsSystem::getInstance().getRenderer();
@@ -316,31 +649,26 @@ namespace Rune
             {
                 if (binding.type == BindingType::eUniformBuffer)
                 {
-                    // Create buffer
-                    u32 uniformBufferIndex = m_uniformBuffers.size();
+                    if (ShaderBindings::isEngineUniformBuffer(binding.binding))
+                        continue;
+
+                    // Create buffer, its members are found through the material
                     auto& uniformBuffer = m_uniformBuffers.emplace_back();
                     uniformBuffer.binding = binding.binding;
                     uniformBuffer.data.allocate(binding.bufferSize);
                     uniformBuffer.data.zeroInitialise();
-
-                    for (const auto& bufferMember : binding.bufferMembers)
-                    {
-                        auto memberName = binding.name + "." + bufferMember.name;
-
-                        m_uniformMemberMap[memberName] = {
-                            uniformBufferIndex,
-                            bufferMember.byteOffset,
-                            bufferMember.byteSize,
-                        };
-                    }
                 }
-                else if (binding.type == BindingType::eTexture)
+                else if (binding.type == BindingType::eTexture || binding.type == BindingType::eTextureArray)
                 {
+                    if (ShaderBindings::isEngineTexture(binding.binding))
+                        continue;
+
                     auto textureIndex = m_textures.size();
 
                     auto& texture = m_textures.emplace_back();
                     texture.name = binding.name;
                     texture.binding = binding.binding;
+                    texture.isArray = binding.type == BindingType::eTextureArray;
 
                     m_textureMap[binding.name] = textureIndex;
                 }
@@ -350,8 +678,10 @@ namespace Rune
         // Copy uniform buffers and textures over
         for (size i = 0; i < m_material->getUniformBuffers().size(); ++i)
         {
+            // Buffer copies share their memory, so the values are copied into this instance's own buffer
             auto& uniformBuffer = m_uniformBuffers[i];
-            uniformBuffer.data = m_material->getUniformBuffers()[i].data;
+            const auto& materialData = m_material->getUniformBuffers()[i].data;
+            uniformBuffer.data.write(materialData.getData(), materialData.getSize());
 
             // Create create uniform buffer on gpu
             uniformBuffer.internalId = renderer->createBuffer(uniformBuffer.data.getSize(), uniformBuffer.data.getData());
@@ -363,15 +693,43 @@ namespace Rune
         }
     }
 
-    auto MaterialInst::getUniformBufferMember(const std::string& name) const -> const MaterialInst::UniformBufferMember*
+    auto MaterialInst::getUniformBufferMember(const UniformHandle handle) const -> const Material::UniformBufferMember*
+    {
+        return m_material->getUniformBufferMember(handle);
+    }
+
+    void MaterialInst::writeUniform(const Material::UniformBufferMember& member, const void* data, const u32 byteSize) const
+    {
+        // Values set every frame are often unchanged, and would otherwise regroup the batches and upload again each frame
+        const auto& uniformBuffer = m_uniformBuffers[member.uniformBufferIndex];
+        if (std::memcmp(uniformBuffer.data.readBytes(byteSize, member.byteOffset), data, byteSize) == 0)
+            return;
+
+        uniformBuffer.data.write(data, byteSize, member.byteOffset);
+        m_material->markBatchesDirty();
+        markUniformDirty(member);
+    }
+
+    void MaterialInst::markUniformDirty(const Material::UniformBufferMember& member) const
     {
-        const auto it = m_uniformMemberMap.find(name);
-        if (it == m_uniformMemberMap.end())
+        // One range per buffer, as re-uploading the bytes between two changes costs less than a copy per change
+        const auto& uniformBuffer = m_uniformBuffers[member.uniformBufferIndex];
+        const u32 memberEnd = member.byteOffset + member.byteSize;
+        if (uniformBuffer.dirtyBegin == uniformBuffer.dirtyEnd)
         {
-            CORE_LOG_WARN("Uniform member '{}' does not exist!", name);
-            return nullptr;
+            uniformBuffer.dirtyBegin = member.byteOffset;
+            uniformBuffer.dirtyEnd = memberEnd;
+        }
+        else
+        {
+            uniformBuffer.dirtyBegin = std::min(uniformBuffer.dirtyBegin, member.byteOffset);
+            uniformBuffer.dirtyEnd = std::max(uniformBuffer.dirtyEnd, memberEnd);
         }
 
-        return &it->second;
+        if (!m_uniformUploadQueued)
+        {
+            m_uniformUploadQueued = true;
+            GraphicsSystem::getInstance().queueUniformUpload(this);
+        }
     }
 }
@@ -3,7 +3,9 @@
 #include "pch.hpp"
 #include "rune/graphics/mesh.hpp"
 
+#include "rune/macros.hpp"
 #include "rune/graphics/graphics.hpp"
+#include "rune/graphics/vertex_quantize.hpp"
 
 namespace Rune
 {
@@ -13,30 +15,61 @@ namespace Rune
         renderer->destroyMesh(m_id);
     }
 
-    auto Mesh::getIndices() const -> const std::vector<u16>&
+    auto Mesh::getIndices() const -> const std::vector<u32>&
     {
         return m_indices;
     }
 
+    auto Mesh::getIndexType() const -> IndexType
+    {
+        return m_vertices.size() > static_cast<size>(u16_max) + 1 ? IndexType::eU32 : IndexType::eU16;
+    }
+
     auto Mesh::getVertices() const -> const std::vector<Vertex>&
     {
         return m_vertices;
     }
 
+    auto Mesh::getVertexEncoding() const -> const VertexEncoding&
+    {
+        return m_vertexEncoding;
+    }
+
     auto Mesh::getTopology() const -> MeshTopology
     {
         return m_topology;
     }
 
+    auto Mesh::getSubmeshes() const -> const std::vector<Submesh>&
+    {
+        return m_submeshes;
+    }
+
+    auto Mesh::getBounds() const -> const Bounds&
+    {
+        return m_bounds;
+    }
+
+    void Mesh::setBounds(const Bounds& bounds)
+    {
+        m_bounds = bounds;
+    }
+
     void Mesh::setVertices(const std::vector<Vertex>& vertices)
     {
         m_vertices = vertices;
     }
 
-    void Mesh::setIndices(const std::vector<u16>& indices, const MeshTopology topology)
+    void Mesh::setVertexFormat(const VertexFormat format)
+    {
+        m_vertexEncoding.format = format;
+    }
+
+    void Mesh::setIndices(const std::vector<u32>& indices, const MeshTopology topology)
     {
         m_topology = topology;
         m_indices = indices;
+        m_lods.clear();
     }
 
     void Mesh::setSubmesh(const size index, const Submesh& submesh)
@@ -49,16 +82,57 @@ namespace Rune
         m_submeshes[index] = submesh;
     }
 
+    auto Mesh::getLodCount() const -> u32
+    {
+        return std::max(static_cast<u32>(m_lods.size()), 1u);
+    }
+
+    auto Mesh::getLod(const u32 level) const -> Lod
+    {
+        if (m_lods.empty())
+            return { 0, static_cast<i32>(m_indices.size()), 0.0f };
+
+        return m_lods[std::min(level, static_cast<u32>(m_lods.size()) - 1)];
+    }
+
+    void Mesh::setLods(const std::vector<Lod>& lods)
+    {
+        RUNE_ENG_ASSERT(lods.size() <= MaxLodCount, "Too many mesh LODs!");
+        for (const auto& lod : lods)
+        {
+            RUNE_ENG_ASSERT(lod.firstIndex >= 0 && static_cast<size>(lod.firstIndex) + lod.indexCount <= m_indices.size(),
+                            "Mesh LOD is outside of the indices, they must be set first!");
+        }
+        m_lods = lods;
+    }
+
+    auto Mesh::getIndexRange(const u32 lod, const u32 submesh) const -> Lod
+    {
+        if (submesh == AllSubmeshes || submesh >= m_submeshes.size())
+            return getLod(lod);
+
+        const auto& submeshData = m_submeshes[submesh];
+        if (submeshData.lods.empty())
+            return { submeshData.firstIndex, submeshData.indexCount, 0.0f };
+
+        return submeshData.lods[std::min(lod, static_cast<u32>(submeshData.lods.size()) - 1)];
+    }
+
     void Mesh::apply()
     {
         auto* renderer = GraphicsSystem::getInstance().getRenderer();
 
+        if (m_vertexEncoding.format == VertexFormat::eQuantized)
+            m_vertexEncoding = VertexQuantize::computeEncoding(m_vertices);
+        else
+            m_vertexEncoding = {};
+
         if (m_id == 0)
-            m_id = renderer->createMesh(m_vertices, m_indices, m_topology);
+            m_id = renderer->createMesh(m_vertices, m_indices, getIndexType(), m_vertexEncoding, m_topology);
         else
         {
-            renderer->updateMeshVertices(m_id, m_vertices);
-            renderer->updateMeshIndices(m_id, m_indices);
+            renderer->updateMeshVertices(m_id, m_vertices, m_vertexEncoding);
+            renderer->updateMeshIndices(m_id, m_indices, getIndexType());
         }
     }
 
@@ -0,0 +1,320 @@
+// # Copyright  Stuart Millman <stu.millman15@gmail.com>
+
+#include "pch.hpp"
+#include "rune/graphics/mesh_optimize.hpp"
+
+#include <glm/geometric.hpp>
+
+#include <algorithm>
+#include <limits>
+#include <numeric>
+
+namespace Rune
+{
+    namespace
+    {
+        constexpr u32 NoVertex = std::numeric_limits<u32>::max();
+
+        /**
+         * FIFO cache simulated with timestamps: a vertex is cached if it was added less than VertexCacheSize misses ago.
+         */
+        struct CacheSimulator
+        {
+            std::vector<u32> timestamps;
+            u32 time = MeshOptimize::VertexCacheSize + 1;
+
+            explicit CacheSimulator(const size vertexCount) : timestamps(vertexCount, 0) {}
+
+            /**
+             * @return Number of the triangle's vertices that had to be transformed.
+             */
+            auto addTriangle(const u32* triangle) -> u32
+            {
+                u32 misses = 0;
+                for (u32 corner = 0; corner < 3; ++corner)
+                {
+                    auto& timestamp = timestamps[triangle[corner]];
+                    if (time - timestamp > MeshOptimize::VertexCacheSize)
+                    {
+                        timestamp = time++;
+                        ++misses;
+                    }
+                }
+                return misses;
+            }
+
+            void flush()
+            {
+                time += MeshOptimize::VertexCacheSize + 1;
+            }
+        };
+
+        /**
+         * Split a vertex cache optimized triangle list into clusters that can be reordered without hurting the cache much.
+         * Clusters start where the ordering could not continue from cached vertices, and are split further wherever the cache
+         * efficiency so far is within the threshold of the whole cluster's.
+         * @return First triangle of each cluster.
+         */
+        auto findClusters(const u32* indices, const size triangleCount, const size vertexCount, const f32 threshold) -> std::vector<u32>
+        {
+            CacheSimulator cache(vertexCount);
+
+            std::vector<u32> hardBoundaries;
+            for (u32 triangle = 0; triangle < triangleCount; ++triangle)
+            {
+                if (cache.addTriangle(&indices[triangle * 3]) == 3 || triangle == 0)
+                    hardBoundaries.push_back(triangle);
+            }
+            hardBoundaries.push_back(static_cast<u32>(triangleCount));
+
+            std::vector<u32> clusters;
+            for (size i = 0; i + 1 < hardBoundaries.size(); ++i)
+            {
+                const u32 clusterStart = hardBoundaries[i];
+                const u32 clusterEnd = hardBoundaries[i + 1];
+
+                cache.flush();
+                u32 clusterMisses = 0;
+                for (u32 triangle = clusterStart; triangle < clusterEnd; ++triangle)
+                {
+                    clusterMisses += cache.addTriangle(&indices[triangle * 3]);
+                }
+                const f32 maxAcmr = threshold * static_cast<f32>(clusterMisses) / static_cast<f32>(clusterEnd - clusterStart);
+
+                cache.flush();
+                clusters.push_back(clusterStart);
+                u32 start = clusterStart;
+                u32 misses = 0;
+                for (u32 triangle = clusterStart; triangle < clusterEnd; ++triangle)
+                {
+                    misses += cache.addTriangle(&indices[triangle * 3]);
+                    if (triangle + 1 < clusterEnd && static_cast<f32>(misses) <= maxAcmr * static_cast<f32>(triangle - start + 1))
+                    {
+                        clusters.push_back(triangle + 1);
+                        cache.flush();
+                        start = triangle + 1;
+                        misses = 0;
+                    }
+                }
+            }
+
+            return clusters;
+        }
+    }
+
+    auto MeshOptimize::analyzeVertexCache(const u32* indices, const size indexCount, const size vertexCount) -> VertexCacheStats
+    {
+        const size triangleCount = indexCount / 3;
+        if (triangleCount == 0)
+            return {};
+
+        CacheSimulator cache(vertexCount);
+        std::vector<u8> isUsed(vertexCount, 0);
+
+        u32 misses = 0;
+        u32 usedCount = 0;
+        for (size triangle = 0; triangle < triangleCount; ++triangle)
+        {
+            misses += cache.addTriangle(&indices[triangle * 3]);
+            for (u32 corner = 0; corner < 3; ++corner)
+            {
+                auto& used = isUsed[indices[triangle * 3 + corner]];
+                usedCount += used == 0;
+                used = 1;
+            }
+        }
+
+        return { static_cast<f32>(misses) / static_cast<f32>(triangleCount), static_cast<f32>(misses) / static_cast<f32>(usedCount) };
+    }
+
+    void MeshOptimize::optimizeVertexCache(u32* indices, const size indexCount, const size vertexCount)
+    {
+        const size triangleCount = indexCount / 3;
+        if (triangleCount == 0)
+            return;
+
+        // Triangles using each vertex
+        std::vector<u32> liveCounts(vertexCount, 0);
+        for (size i = 0; i < triangleCount * 3; ++i)
+        {
+            ++liveCounts[indices[i]];
+        }
+
+        std::vector<u32> adjacencyOffsets(vertexCount + 1, 0);
+        std::partial_sum(liveCounts.begin(), liveCounts.end(), adjacencyOffsets.begin() + 1);
+
+        std::vector<u32> adjacency(triangleCount * 3);
+        std::vector<u32> adjacencyFill(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+        for (size i = 0; i < triangleCount * 3; ++i)
+        {
+            adjacency[adjacencyFill[indices[i]]++] = static_cast<u32>(i / 3);
+        }
+
+        const std::vector<u32> input(indices, indices + triangleCount * 3);
+        std::vector<u8> isEmitted(triangleCount, 0);
+        std::vector<u32> cacheTimes(vertexCount, 0);
+        std::vector<u32> deadEnds;
+        std::vector<u32> candidates;
+
+        u32 time = VertexCacheSize + 1;
+        u32 nextInputVertex = 0;
+        u32 fanVertex = input[0];
+        size outputIndex = 0;
+
+        while (fanVertex != NoVertex)
+        {
+            // Emit every remaining triangle around the fanning vertex
+            candidates.clear();
+            for (u32 i = adjacencyOffsets[fanVertex]; i < adjacencyOffsets[fanVertex + 1]; ++i)
+            {
+                const u32 triangle = adjacency[i];
+                if (isEmitted[triangle])
+                    continue;
+
+                for (u32 corner = 0; corner < 3; ++corner)
+                {
+                    const u32 vertex = input[triangle * 3 + corner];
+                    indices[outputIndex++] = vertex;
+                    deadEnds.push_back(vertex);
+                    candidates.push_back(vertex);
+                    --liveCounts[vertex];
+
+                    if (time - cacheTimes[vertex] > VertexCacheSize)
+                        cacheTimes[vertex] = time++;
+                }
+                isEmitted[triangle] = 1;
+            }
+
+            // Fan next around the vertex that will still be in the cache after its remaining triangles are emitted, and has been
+            // in the cache longest
+            fanVertex = NoVertex;
+            i32 bestPriority = -1;
+            for (const auto vertex : candidates)
+            {
+                if (liveCounts[vertex] == 0)
+                    continue;
+
+                i32 priority = 0;
+                if (time - cacheTimes[vertex] + 2 * liveCounts[vertex] <= VertexCacheSize)
+                    priority = static_cast<i32>(time - cacheTimes[vertex]);
+
+                if (priority > bestPriority)
+                {
+                    bestPriority = priority;
+                    fanVertex = vertex;
+                }
+            }
+
+            if (fanVertex != NoVertex)
+                continue;
+
+            // Dead end. Prefer a recently used vertex, then continue in input order.
+            while (!deadEnds.empty())
+            {
+                const u32 vertex = deadEnds.back();
+                deadEnds.pop_back();
+                if (liveCounts[vertex] > 0)
+                {
+                    fanVertex = vertex;
+                    break;
+                }
+            }
+
+            while (fanVertex == NoVertex && nextInputVertex < vertexCount)
+            {
+                if (liveCounts[nextInputVertex] > 0)
+                    fanVertex = nextInputVertex;
+                ++nextInputVertex;
+            }
+        }
+    }
+
+    void MeshOptimize::optimizeOverdraw(const std::vector<Vertex>& vertices, u32* indices, const size indexCount, const f32 threshold)
+    {
+        const size triangleCount = indexCount / 3;
+        if (triangleCount == 0)
+            return;
+
+        const auto clusters = findClusters(indices, triangleCount, vertices.size(), threshold);
+        if (clusters.size() <= 1)
+            return;
+
+        // Area weighted centroid and normal of each cluster, and the mesh centroid
+        std::vector<glm::vec3> clusterCentroids(clusters.size(), glm::vec3(0.0f));
+        std::vector<glm::vec3> clusterNormals(clusters.size(), glm::vec3(0.0f));
+        glm::vec3 meshCentroid(0.0f);
+        f32 meshArea = 0.0f;
+
+        for (size cluster = 0; cluster < clusters.size(); ++cluster)
+        {
+            const u32 end = cluster + 1 < clusters.size() ? clusters[cluster + 1] : static_cast<u32>(triangleCount);
+
+            f32 clusterArea = 0.0f;
+            for (u32 triangle = clusters[cluster]; triangle < end; ++triangle)
+            {
+                const auto& p0 = vertices[indices[triangle * 3]].pos;
+                const auto& p1 = vertices[indices[triangle * 3 + 1]].pos;
+                const auto& p2 = vertices[indices[triangle * 3 + 2]].pos;
+
+                const auto normal = glm::cross(p1 - p0, p2 - p0);
+                const f32 area = glm::length(normal);
+                const auto centroid = (p0 + p1 + p2) * (area / 3.0f);
+
+                clusterCentroids[cluster] += centroid;
+                clusterNormals[cluster] += normal;
+                clusterArea += area;
+                meshCentroid += centroid;
+                meshArea += area;
+            }
+
+            if (clusterArea > 0.0f)
+                clusterCentroids[cluster] /= clusterArea;
+        }
+
+        if (meshArea > 0.0f)
+            meshCentroid /= meshArea;
+
+        // Clusters facing away from the centre are the ones most likely to occlude others
+        std::vector<f32> sortKeys(clusters.size());
+        for (size cluster = 0; cluster < clusters.size(); ++cluster)
+        {
+            const f32 normalLength = glm::length(clusterNormals[cluster]);
+            const auto normal = normalLength > 0.0f ? clusterNormals[cluster] / normalLength : glm::vec3(0.0f);
+            sortKeys[cluster] = glm::dot(clusterCentroids[cluster] - meshCentroid, normal);
+        }
+
+        std::vector<u32> order(clusters.size());
+        std::iota(order.begin(), order.end(), 0u);
+        std::stable_sort(order.begin(), order.end(), [&sortKeys](const u32 a, const u32 b) { return sortKeys[a] > sortKeys[b]; });
+
+        const std::vector<u32> input(indices, indices + triangleCount * 3);
+        size outputIndex = 0;
+        for (const auto cluster : order)
+        {
+            const u32 end = cluster + 1 < clusters.size() ? clusters[cluster + 1] : static_cast<u32>(triangleCount);
+            std::copy(input.begin() + clusters[cluster] * 3, input.begin() + end * 3, indices + outputIndex);
+            outputIndex += (end - clusters[cluster]) * 3;
+        }
+    }
+
+    auto MeshOptimize::optimizeVertexFetch(std::vector<Vertex>& vertices, u32* indices, const size indexCount) -> size
+    {
+        std::vector<u32> remap(vertices.size(), NoVertex);
+        std::vector<Vertex> reordered;
+        reordered.reserve(vertices.size());
+
+        for (size i = 0; i < indexCount; ++i)
+        {
+            auto& newIndex = remap[indices[i]];
+            if (newIndex == NoVertex)
+            {
+                newIndex = static_cast<u32>(reordered.size());
+                reordered.push_back(vertices[indices[i]]);
+            }
+            indices[i] = newIndex;
+        }
+
+        vertices = std::move(reordered);
+        return vertices.size();
+    }
+}
@@ -0,0 +1,440 @@
+// # Copyright  Stuart Millman <stu.millman15@gmail.com>
+
+#include "pch.hpp"
+#include "rune/graphics/mesh_simplify.hpp"
+
+#include <glm/geometric.hpp>
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cmath>
+#include <unordered_map>
+
+namespace Rune
+{
+    namespace
+    {
+        /* Open borders are held in place by planes perpendicular to them, weighted this much more than surface planes */
+        constexpr f64 BorderWeight = 10.0;
+
+        /* A collapse may not turn a triangle's normal further than this (cosine) */
+        constexpr f32 MinNormalDot = 0.25f;
+
+        /* Nor leave a triangle thinner than this (twice its area over its longest edge squared) */
+        constexpr f64 MinTriangleQuality = 0.05;
+
+        /**
+         * Sum of weighted squared distances to a set of planes, as a symmetric 4x4 matrix.
+         */
+        struct Quadric
+        {
+            f64 a00 = 0, a01 = 0, a02 = 0, a11 = 0, a12 = 0, a22 = 0;
+            f64 b0 = 0, b1 = 0, b2 = 0;
+            f64 c = 0;
+            f64 weight = 0;
+
+            static auto fromPlane(const glm::dvec3& normal, const f64 distance, const f64 weight) -> Quadric
+            {
+                Quadric q{};
+                q.a00 = normal.x * normal.x * weight;
+                q.a01 = normal.x * normal.y * weight;
+                q.a02 = normal.x * normal.z * weight;
+                q.a11 = normal.y * normal.y * weight;
+                q.a12 = normal.y * normal.z * weight;
+                q.a22 = normal.z * normal.z * weight;
+                q.b0 = normal.x * distance * weight;
+                q.b1 = normal.y * distance * weight;
+                q.b2 = normal.z * distance * weight;
+                q.c = distance * distance * weight;
+                q.weight = weight;
+                return q;
+            }
+
+            void add(const Quadric& other)
+            {
+                a00 += other.a00;
+                a01 += other.a01;
+                a02 += other.a02;
+                a11 += other.a11;
+                a12 += other.a12;
+                a22 += other.a22;
+                b0 += other.b0;
+                b1 += other.b1;
+                b2 += other.b2;
+                c += other.c;
+                weight += other.weight;
+            }
+
+            /**
+             * @return Weighted mean squared distance of the point to the planes.
+             */
+            auto evaluate(const glm::dvec3& p) const -> f64
+            {
+                const f64 result = a00 * p.x * p.x + a11 * p.y * p.y + a22 * p.z * p.z +
+                                   2.0 * (a01 * p.x * p.y + a02 * p.x * p.z + a12 * p.y * p.z) + 2.0 * (b0 * p.x + b1 * p.y + b2 * p.z) +
+                                   c;
+                return weight > 0.0 ? std::max(result, 0.0) / weight : 0.0;
+            }
+        };
+
+        struct Collapse
+        {
+            u32 from;  // Position collapsed away
+            u32 to;    // Position it collapses onto
+            f64 error;
+        };
+
+        auto makeEdgeKey(const u32 a, const u32 b) -> u64
+        {
+            return a < b ? (u64(a) << 32) | b : (u64(b) << 32) | a;
+        }
+
+        /**
+         * Builds compressed adjacency lists (offsets + items) from (owner, item) pairs.
+         */
+        void buildAdjacency(const u32 ownerCount,
+                            const std::vector<std::pair<u32, u32>>& pairs,
+                            std::vector<u32>& outOffsets,
+                            std::vector<u32>& outItems)
+        {
+            outOffsets.assign(ownerCount + 1, 0);
+            for (const auto& [owner, item] : pairs)
+            {
+                ++outOffsets[owner + 1];
+            }
+            for (u32 i = 0; i < ownerCount; ++i)
+            {
+                outOffsets[i + 1] += outOffsets[i];
+            }
+
+            outItems.resize(pairs.size());
+            std::vector<u32> cursor(outOffsets.begin(), outOffsets.end() - 1);
+            for (const auto& [owner, item] : pairs)
+            {
+                outItems[cursor[owner]++] = item;
+            }
+        }
+    }
+
+    auto MeshSimplify::simplify(const std::vector<Vertex>& vertices,
+                                const u32* indices,
+                                const size indexCount,
+                                const size targetIndexCount,
+                                std::vector<u32>& outIndices) -> f32
+    {
+        // Work on local vertices, welded by position so that vertices split by uv/normal seams share one position
+        std::vector<u32> localToGlobal;
+        std::vector<u32> vertexPosition;  // Local vertex -> welded position
+        std::vector<glm::dvec3> positions;
+        std::vector<u32> triangles(indexCount);
+        {
+            std::unordered_map<u32, u32> globalToLocal;
+            std::unordered_map<u64, std::vector<u32>> positionBuckets;
+            for (size i = 0; i < indexCount; ++i)
+            {
+                const u32 globalIndex = indices[i];
+                auto [it, inserted] = globalToLocal.try_emplace(globalIndex, static_cast<u32>(localToGlobal.size()));
+                if (inserted)
+                {
+                    localToGlobal.push_back(globalIndex);
+
+                    const auto& pos = vertices[globalIndex].pos;
+                    const u64 posHash = (u64(std::bit_cast<u32>(pos.x)) * 73856093u) ^ (u64(std::bit_cast<u32>(pos.y)) * 19349663u) ^
+                                        (u64(std::bit_cast<u32>(pos.z)) * 83492791u);
+                    auto& bucket = positionBuckets[posHash];
+
+                    u32 positionIndex = u32_max;
+                    for (const auto candidate : bucket)
+                    {
+                        if (vertices[localToGlobal[candidate]].pos == pos)
+                        {
+                            positionIndex = vertexPosition[candidate];
+                            break;
+                        }
+                    }
+                    if (positionIndex == u32_max)
+                    {
+                        positionIndex = static_cast<u32>(positions.size());
+                        positions.emplace_back(pos);
+                    }
+
+                    bucket.push_back(it->second);
+                    vertexPosition.push_back(positionIndex);
+                }
+                triangles[i] = it->second;
+            }
+        }
+
+        const auto vertexCount = static_cast<u32>(localToGlobal.size());
+        const auto positionCount = static_cast<u32>(positions.size());
+
+        // Error quadrics of the original surface, area weighted
+        std::vector<Quadric> quadrics(positionCount);
+        std::unordered_map<u64, u32> edgeUseCount;
+        for (size i = 0; i < triangles.size(); i += 3)
+        {
+            const u32 p0 = vertexPosition[triangles[i]];
+            const u32 p1 = vertexPosition[triangles[i + 1]];
+            const u32 p2 = vertexPosition[triangles[i + 2]];
+            const auto cross = glm::cross(positions[p1] - positions[p0], positions[p2] - positions[p0]);
+            const f64 doubleArea = glm::length(cross);
+            if (doubleArea <= 0.0)
+                continue;
+
+            const auto normal = cross / doubleArea;
+            const auto plane = Quadric::fromPlane(normal, -glm::dot(normal, positions[p0]), doubleArea * 0.5);
+            quadrics[p0].add(plane);
+            quadrics[p1].add(plane);
+            quadrics[p2].add(plane);
+
+            ++edgeUseCount[makeEdgeKey(p0, p1)];
+            ++edgeUseCount[makeEdgeKey(p1, p2)];
+            ++edgeUseCount[makeEdgeKey(p2, p0)];
+        }
+
+        // Edges used by a single triangle are open borders, keep them from being pulled inwards
+        for (size i = 0; i < triangles.size(); i += 3)
+        {
+            for (u32 corner = 0; corner < 3; ++corner)
+            {
+                const u32 pa = vertexPosition[triangles[i + corner]];
+                const u32 pb = vertexPosition[triangles[i + (corner + 1) % 3]];
+                const auto it = edgeUseCount.find(makeEdgeKey(pa, pb));
+                if (it == edgeUseCount.end() || it->second != 1)
+                    continue;
+
+                const u32 pc = vertexPosition[triangles[i + (corner + 2) % 3]];
+                const auto edge = positions[pb] - positions[pa];
+                const auto faceNormal = glm::cross(edge, positions[pc] - positions[pa]);
+                const auto borderNormal = glm::cross(edge, faceNormal);
+                const f64 normalLength = glm::length(borderNormal);
+                if (normalLength <= 0.0)
+                    continue;
+
+                const auto normal = borderNormal / normalLength;
+                const auto plane = Quadric::fromPlane(normal, -glm::dot(normal, positions[pa]), glm::dot(edge, edge) * BorderWeight);
+                quadrics[pa].add(plane);
+                quadrics[pb].add(plane);
+            }
+        }
+
+        // Vertices of each position, which collapse together
+        std::vector<u32> wedgeOffsets, wedgeItems;
+        {
+            std::vector<std::pair<u32, u32>> pairs;
+            pairs.reserve(vertexCount);
+            for (u32 v = 0; v < vertexCount; ++v)
+            {
+                pairs.emplace_back(vertexPosition[v], v);
+            }
+            buildAdjacency(positionCount, pairs, wedgeOffsets, wedgeItems);
+        }
+
+        std::vector<u32> remap(vertexCount);
+        std::vector<u8> positionLocked(positionCount);
+        std::vector<std::pair<u32, u32>> pairs;
+        std::vector<u32> positionTriOffsets, positionTriItems;
+        std::vector<u32> vertexNeighbourOffsets, vertexNeighbourItems;
+        std::vector<u64> edges;
+        std::vector<Collapse> collapses;
+
+        f64 maxError = 0.0;
+        size triangleCount = triangles.size() / 3;
+        const size targetTriangleCount = targetIndexCount / 3;
+
+        // Each pass collapses a set of edges whose neighbourhoods do not overlap, then rebuilds adjacency
+        while (triangleCount > targetTriangleCount)
+        {
+            // Triangles around each position and vertices around each vertex
+            pairs.clear();
+            for (u32 tri = 0; tri < triangleCount; ++tri)
+            {
+                for (u32 corner = 0; corner < 3; ++corner)
+                {
+                    pairs.emplace_back(vertexPosition[triangles[tri * 3 + corner]], tri);
+                }
+            }
+            buildAdjacency(positionCount, pairs, positionTriOffsets, positionTriItems);
+
+            pairs.clear();
+            edges.clear();
+            for (u32 tri = 0; tri < triangleCount; ++tri)
+            {
+                for (u32 corner = 0; corner < 3; ++corner)
+                {
+                    const u32 va = triangles[tri * 3 + corner];
+                    const u32 vb = triangles[tri * 3 + (corner + 1) % 3];
+                    pairs.emplace_back(va, vb);
+                    pairs.emplace_back(vb, va);
+                    edges.push_back(makeEdgeKey(vertexPosition[va], vertexPosition[vb]));
+                }
+            }
+            buildAdjacency(vertexCount, pairs, vertexNeighbourOffsets, vertexNeighbourItems);
+            std::sort(edges.begin(), edges.end());
+            edges.erase(std::unique(edges.begin(), edges.end()), edges.end());
+
+            // A position can collapse onto another if every one of its vertices has an edge to a vertex there
+            const auto findPartner = [&](const u32 vertex, const u32 toPosition) -> u32
+            {
+                for (u32 i = vertexNeighbourOffsets[vertex]; i < vertexNeighbourOffsets[vertex + 1]; ++i)
+                {
+                    if (vertexPosition[vertexNeighbourItems[i]] == toPosition)
+                        return vertexNeighbourItems[i];
+                }
+                return u32_max;
+            };
+            const auto canCollapse = [&](const u32 from, const u32 to)
+            {
+                for (u32 i = wedgeOffsets[from]; i < wedgeOffsets[from + 1]; ++i)
+                {
+                    const u32 vertex = wedgeItems[i];
+                    const bool isUsed = vertexNeighbourOffsets[vertex] != vertexNeighbourOffsets[vertex + 1];
+                    if (isUsed && findPartner(vertex, to) == u32_max)
+                        return false;
+                }
+                return true;
+            };
+
+            collapses.clear();
+            for (const auto edge : edges)
+            {
+                const auto pa = static_cast<u32>(edge >> 32);
+                const auto pb = static_cast<u32>(edge & u32_max);
+
+                Quadric combined = quadrics[pa];
+                combined.add(quadrics[pb]);
+                const f64 errorToB = canCollapse(pa, pb) ? combined.evaluate(positions[pb]) : f64_max;
+                const f64 errorToA = canCollapse(pb, pa) ? combined.evaluate(positions[pa]) : f64_max;
+                if (errorToB == f64_max && errorToA == f64_max)
+                    continue;
+
+                if (errorToB <= errorToA)
+                    collapses.push_back({ pa, pb, errorToB });
+                else
+                    collapses.push_back({ pb, pa, errorToA });
+            }
+            std::sort(collapses.begin(), collapses.end(), [](const Collapse& a, const Collapse& b) { return a.error < b.error; });
+
+            // Moving a position must not flip or squash any of the triangles it stays part of
+            const auto keepsTrianglesFacing = [&](const u32 from, const u32 to)
+            {
+                for (u32 i = positionTriOffsets[from]; i < positionTriOffsets[from + 1]; ++i)
+                {
+                    const u32 tri = positionTriItems[i];
+                    std::array<u32, 3> corners = { vertexPosition[triangles[tri * 3]],
+                                                   vertexPosition[triangles[tri * 3 + 1]],
+                                                   vertexPosition[triangles[tri * 3 + 2]] };
+                    if (corners[0] == to || corners[1] == to || corners[2] == to)
+                        continue;  // Becomes degenerate and is removed
+
+                    const auto oldNormal = glm::cross(positions[corners[1]] - positions[corners[0]], positions[corners[2]] - positions[corners[0]]);
+                    for (auto& corner : corners)
+                    {
+                        if (corner == from)
+                            corner = to;
+                    }
+                    const auto newNormal = glm::cross(positions[corners[1]] - positions[corners[0]], positions[corners[2]] - positions[corners[0]]);
+
+                    const f64 lengths = glm::length(oldNormal) * glm::length(newNormal);
+                    if (lengths <= 0.0 || glm::dot(oldNormal, newNormal) < MinNormalDot * lengths)
+                        return false;
+
+                    // Slivers have no reliable normal, so would slip past the check above on a later collapse
+                    const f64 longestEdgeSqr = std::max({ glm::dot(positions[corners[1]] - positions[corners[0]], positions[corners[1]] - positions[corners[0]]),
+                                                          glm::dot(positions[corners[2]] - positions[corners[1]], positions[corners[2]] - positions[corners[1]]),
+                                                          glm::dot(positions[corners[0]] - positions[corners[2]], positions[corners[0]] - positions[corners[2]]) });
+                    if (glm::length(newNormal) < MinTriangleQuality * longestEdgeSqr)
+                        return false;
+                }
+                return true;
+            };
+
+            const auto lockNeighbourhood = [&](const u32 position)
+            {
+                for (u32 i = positionTriOffsets[position]; i < positionTriOffsets[position + 1]; ++i)
+                {
+                    const u32 tri = positionTriItems[i];
+                    for (u32 corner = 0; corner < 3; ++corner)
+                    {
+                        positionLocked[vertexPosition[triangles[tri * 3 + corner]]] = 1;
+                    }
+                }
+            };
+
+            for (u32 v = 0; v < vertexCount; ++v)
+            {
+                remap[v] = v;
+            }
+            std::fill(positionLocked.begin(), positionLocked.end(), 0);
+
+            size removedTriangles = 0;
+            size collapseCount = 0;
+            for (const auto& collapse : collapses)
+            {
+                if (triangleCount - removedTriangles <= targetTriangleCount)
+                    break;
+                if (positionLocked[collapse.from] || positionLocked[collapse.to])
+                    continue;
+                if (!keepsTrianglesFacing(collapse.from, collapse.to))
+                    continue;
+
+                for (u32 i = wedgeOffsets[collapse.from]; i < wedgeOffsets[collapse.from + 1]; ++i)
+                {
+                    const u32 vertex = wedgeItems[i];
+                    const u32 partner = findPartner(vertex, collapse.to);
+                    if (partner != u32_max)
+                        remap[vertex] = partner;
+                }
+
+                for (u32 i = positionTriOffsets[collapse.from]; i < positionTriOffsets[collapse.from + 1]; ++i)
+                {
+                    const u32 tri = positionTriItems[i];
+                    const bool hasTo = vertexPosition[triangles[tri * 3]] == collapse.to || vertexPosition[triangles[tri * 3 + 1]] == collapse.to ||
+                                       vertexPosition[triangles[tri * 3 + 2]] == collapse.to;
+                    if (hasTo)
+                        ++removedTriangles;
+                }
+
+                lockNeighbourhood(collapse.from);
+                lockNeighbourhood(collapse.to);
+
+                quadrics[collapse.to].add(quadrics[collapse.from]);
+                maxError = std::max(maxError, collapse.error);
+                ++collapseCount;
+            }
+
+            if (collapseCount == 0)
+                break;
+
+            // Apply the collapses, dropping triangles that lost an edge
+            size writeIndex = 0;
+            for (u32 tri = 0; tri < triangleCount; ++tri)
+            {
+                const u32 v0 = remap[triangles[tri * 3]];
+                const u32 v1 = remap[triangles[tri * 3 + 1]];
+                const u32 v2 = remap[triangles[tri * 3 + 2]];
+                const u32 p0 = vertexPosition[v0];
+                const u32 p1 = vertexPosition[v1];
+                const u32 p2 = vertexPosition[v2];
+                if (p0 == p1 || p1 == p2 || p2 == p0)
+                    continue;
+
+                triangles[writeIndex++] = v0;
+                triangles[writeIndex++] = v1;
+                triangles[writeIndex++] = v2;
+            }
+            triangles.resize(writeIndex);
+            triangleCount = writeIndex / 3;
+
+        }
+
+        outIndices.resize(triangles.size());
+        for (size i = 0; i < triangles.size(); ++i)
+        {
+            outIndices[i] = localToGlobal[triangles[i]];
+        }
+
+        return static_cast<f32>(std::sqrt(maxError));
+    }
+}
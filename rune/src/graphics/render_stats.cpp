@@ -0,0 +1,102 @@
+// # Copyright  Stuart Millman <stu.millman15@gmail.com>
+
+#include "pch.hpp"
+#include "rune/graphics/render_stats.hpp"
+
+#include "rune/macros.hpp"
+
+#include <filesystem>
+
+namespace Rune
+{
+    RenderStatsWriter::~RenderStatsWriter()
+    {
+        close();
+    }
+
+    bool RenderStatsWriter::open(const std::string& filename)
+    {
+        close();
+
+        m_file.open(filename, std::ios::out | std::ios::trunc);
+        if (!m_file.is_open())
+        {
+            CORE_LOG_ERROR("[RenderStats] Failed to open '{}' for writing!", filename);
+            return false;
+        }
+
+        m_isJson = std::filesystem::path(filename).extension() == ".json";
+        m_isFirstRow = true;
+
+        if (m_isJson)
+        {
+            m_file << "[\n";
+        }
+        else
+        {
+            m_file << "frame,drawCalls,instances,triangles,programBinds,vaoBinds,textureBinds,uniformBufferBinds,storageBufferBinds,"
+                      "redundantCallsSkipped,bytesUploaded,programCacheHits,programBinaryLoads,programCacheMisses,visibleRenderables,"
+                      "culledRenderables,shadowViewsRendered,"
+                      "shadowViewsCached,textureMipsStreamed,textureMipsEvicted,textureMipsReloaded,texturesStreaming,textureResidentBytes,"
+                      "cullTimeMs,sortTimeMs,submitTimeMs\n";
+        }
+
+        return true;
+    }
+
+    void RenderStatsWriter::close()
+    {
+        if (!m_file.is_open())
+            return;
+
+        if (m_isJson)
+            m_file << "\n]\n";
+
+        m_file.close();
+    }
+
+    bool RenderStatsWriter::isOpen() const
+    {
+        return m_file.is_open();
+    }
+
+    void RenderStatsWriter::write(const u64 frameIndex, const RenderStats& stats)
+    {
+        if (!m_file.is_open())
+            return;
+
+        if (m_isJson)
+        {
+            if (!m_isFirstRow)
+                m_file << ",\n";
+
+            m_file << "  { \"frame\": " << frameIndex << ", \"drawCalls\": " << stats.drawCalls << ", \"instances\": " << stats.instances
+                   << ", \"triangles\": " << stats.triangles << ", \"programBinds\": " << stats.programBinds
+                   << ", \"vaoBinds\": " << stats.vaoBinds << ", \"textureBinds\": " << stats.textureBinds
+                   << ", \"uniformBufferBinds\": " << stats.uniformBufferBinds << ", \"storageBufferBinds\": " << stats.storageBufferBinds
+                   << ", \"redundantCallsSkipped\": " << stats.redundantCallsSkipped << ", \"bytesUploaded\": " << stats.bytesUploaded
+                   << ", \"programCacheHits\": " << stats.programCacheHits << ", \"programBinaryLoads\": " << stats.programBinaryLoads
+                   << ", \"programCacheMisses\": " << stats.programCacheMisses << ", \"visibleRenderables\": " << stats.visibleRenderables
+                   << ", \"culledRenderables\": " << stats.culledRenderables << ", \"shadowViewsRendered\": " << stats.shadowViewsRendered
+                   << ", \"shadowViewsCached\": " << stats.shadowViewsCached << ", \"textureMipsStreamed\": " << stats.textureMipsStreamed
+                   << ", \"textureMipsEvicted\": " << stats.textureMipsEvicted << ", \"textureMipsReloaded\": " << stats.textureMipsReloaded
+                   << ", \"texturesStreaming\": " << stats.texturesStreaming << ", \"textureResidentBytes\": " << stats.textureResidentBytes
+                   << ", \"cullTimeMs\": " << stats.cullTime
+                   << ", \"sortTimeMs\": " << stats.sortTime << ", \"submitTimeMs\": " << stats.submitTime << " }";
+        }
+        else
+        {
+            m_file << frameIndex << ',' << stats.drawCalls << ',' << stats.instances << ',' << stats.triangles << ',' << stats.programBinds
+                   << ',' << stats.vaoBinds << ',' << stats.textureBinds << ',' << stats.uniformBufferBinds << ','
+                   << stats.storageBufferBinds << ',' << stats.redundantCallsSkipped << ',' << stats.bytesUploaded << ','
+                   << stats.programCacheHits << ',' << stats.programBinaryLoads << ',' << stats.programCacheMisses << ','
+                   << stats.visibleRenderables << ',' << stats.culledRenderables << ',' << stats.shadowViewsRendered << ','
+                   << stats.shadowViewsCached << ','
+                   << stats.textureMipsStreamed << ',' << stats.textureMipsEvicted << ',' << stats.textureMipsReloaded << ','
+                   << stats.texturesStreaming << ',' << stats.textureResidentBytes << ','
+                   << stats.cullTime << ',' << stats.sortTime << ',' << stats.submitTime << '\n';
+        }
+
+        m_isFirstRow = false;
+    }
+}
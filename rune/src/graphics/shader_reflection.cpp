@@ -0,0 +1,252 @@
+// # Copyright  Stuart Millman <stu.millman15@gmail.com>
+
+#include "pch.hpp"
+#include "rune/graphics/shader_reflection.hpp"
+
+#include "rune/macros.hpp"
+#include "rune/graphics/shader.hpp"
+#include "rune/utility/hash.hpp"
+#include "rune/utility/mapped_file.hpp"
+
+#include <cstring>
+#include <fstream>
+
+namespace Rune
+{
+    namespace
+    {
+        constexpr u32 ReflectionMagic = 0x4C464552;  // "REFL"
+        constexpr u32 ReflectionVersion = 1;
+
+        /* The file is the header, then each array in turn, then the string table */
+        struct FileHeader
+        {
+            u32 magic;
+            u32 version;
+            u64 codeHash;
+            u32 setCount;
+            u32 bindingCount;
+            u32 memberCount;
+            u32 namesSize;  // Bytes of null terminated names
+        };
+
+        struct SetRecord
+        {
+            u32 set;
+            u32 firstBinding;
+            u32 bindingCount;
+            u32 padding;
+        };
+
+        struct BindingRecord
+        {
+            u64 bufferSize;
+            u32 set;
+            u32 binding;
+            u32 nameOffset;
+            u32 type;
+            u32 firstMember;
+            u32 memberCount;
+        };
+
+        struct MemberRecord
+        {
+            u64 id;
+            u32 nameOffset;
+            u32 byteOffset;
+            u32 byteSize;
+            u32 padding;
+        };
+
+        /* Every array starts 8 byte aligned in the mapping, so records can be read in place */
+        static_assert(sizeof(FileHeader) % 8 == 0 && sizeof(SetRecord) % 8 == 0 && sizeof(BindingRecord) % 8 == 0 &&
+                      sizeof(MemberRecord) % 8 == 0);
+
+        /**
+         * Names are stored once each, however many bindings or members share them.
+         */
+        class NameTable
+        {
+        public:
+            auto add(const std::string& name) -> u32
+            {
+                const auto [it, inserted] = m_offsets.try_emplace(name, static_cast<u32>(m_names.size()));
+                if (inserted)
+                    m_names.insert(m_names.end(), name.c_str(), name.c_str() + name.size() + 1);
+                return it->second;
+            }
+
+            auto getNames() const -> const std::vector<char>&
+            {
+                return m_names;
+            }
+
+        private:
+            std::unordered_map<std::string, u32> m_offsets;
+            std::vector<char> m_names;
+        };
+
+        template <typename T>
+        void writeArray(std::ofstream& file, const std::vector<T>& values)
+        {
+            file.write(reinterpret_cast<const char*>(values.data()), static_cast<std::streamsize>(values.size() * sizeof(T)));
+        }
+
+        /**
+         * Reads arrays out of a mapped file in order, failing once any would run past its end.
+         */
+        class Reader
+        {
+        public:
+            Reader(const u8* data, const size dataSize) : m_data(data), m_dataSize(dataSize) {}
+
+            template <typename T>
+            auto readArray(const size count) -> const T*
+            {
+                const size byteSize = count * sizeof(T);
+                if (m_offset + byteSize > m_dataSize)
+                    return nullptr;
+
+                const auto* values = reinterpret_cast<const T*>(m_data + m_offset);
+                m_offset += byteSize;
+                return values;
+            }
+
+        private:
+            const u8* m_data;
+            size m_dataSize;
+            size m_offset = 0;
+        };
+    }
+
+    auto ShaderReflection::getCodeHash(const Shader* shader) -> u64
+    {
+        // The size keeps the boundary between the stages, so code moving from one to the other changes the hash
+        const u64 vertexCodeSize = shader->getVertexCode().size();
+        u64 hash = Hash::fnv1a(&vertexCodeSize, sizeof(vertexCodeSize));
+        hash = Hash::fnv1a(shader->getVertexCode().data(), shader->getVertexCode().size(), hash);
+        return Hash::fnv1a(shader->getFragmentCode().data(), shader->getFragmentCode().size(), hash);
+    }
+
+    bool ShaderReflection::save(const std::string& filename, const u64 codeHash, const ReflectionData& reflectionData)
+    {
+        NameTable names;
+        std::vector<SetRecord> sets;
+        std::vector<BindingRecord> bindings;
+        std::vector<MemberRecord> members;
+
+        for (const auto& set : reflectionData.sets)
+        {
+            sets.push_back({ set.set, static_cast<u32>(bindings.size()), static_cast<u32>(set.bindings.size()), 0 });
+            for (const auto& binding : set.bindings)
+            {
+                bindings.push_back({ binding.bufferSize,
+                                     binding.set,
+                                     binding.binding,
+                                     names.add(binding.name),
+                                     static_cast<u32>(binding.type),
+                                     static_cast<u32>(members.size()),
+                                     static_cast<u32>(binding.bufferMembers.size()) });
+
+                for (const auto& member : binding.bufferMembers)
+                    members.push_back({ member.id, names.add(member.name), member.byteOffset, member.byteSize, 0 });
+            }
+        }
+
+        std::ofstream file(filename, std::ios::binary | std::ios::trunc);
+        if (!file.is_open())
+        {
+            CORE_LOG_WARN("Failed to write shader reflection '{}'", filename);
+            return false;
+        }
+
+        const FileHeader header{ ReflectionMagic,
+                                 ReflectionVersion,
+                                 codeHash,
+                                 static_cast<u32>(sets.size()),
+                                 static_cast<u32>(bindings.size()),
+                                 static_cast<u32>(members.size()),
+                                 static_cast<u32>(names.getNames().size()) };
+        file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        writeArray(file, sets);
+        writeArray(file, bindings);
+        writeArray(file, members);
+        writeArray(file, names.getNames());
+        return file.good();
+    }
+
+    auto ShaderReflection::load(const std::string& filename, const u64 codeHash) -> std::optional<ReflectionData>
+    {
+        MappedFile file;
+        if (!file.open(filename))
+            return std::nullopt;
+
+        Reader reader(file.getData(), file.getSize());
+        const auto* header = reader.readArray<FileHeader>(1);
+        if (header == nullptr || header->magic != ReflectionMagic || header->version != ReflectionVersion || header->codeHash != codeHash)
+            return std::nullopt;
+
+        const auto* sets = reader.readArray<SetRecord>(header->setCount);
+        const auto* bindings = reader.readArray<BindingRecord>(header->bindingCount);
+        const auto* members = reader.readArray<MemberRecord>(header->memberCount);
+        const auto* names = reader.readArray<char>(header->namesSize);
+        if (sets == nullptr || bindings == nullptr || members == nullptr || names == nullptr)
+            return std::nullopt;
+
+        // Offsets are checked so a damaged file cannot read past the mapping
+        const auto getName = [&](const u32 nameOffset) -> std::optional<std::string>
+        {
+            if (nameOffset >= header->namesSize)
+                return std::nullopt;
+            const auto* name = &names[nameOffset];
+            return std::string(name, strnlen(name, header->namesSize - nameOffset));
+        };
+
+        ReflectionData reflectionData;
+        reflectionData.sets.resize(header->setCount);
+        for (u32 setIndex = 0; setIndex < header->setCount; ++setIndex)
+        {
+            const auto& setRecord = sets[setIndex];
+            if (setRecord.firstBinding + static_cast<u64>(setRecord.bindingCount) > header->bindingCount)
+                return std::nullopt;
+
+            auto& set = reflectionData.sets[setIndex];
+            set.set = setRecord.set;
+            set.bindings.resize(setRecord.bindingCount);
+            for (u32 bindingIndex = 0; bindingIndex < setRecord.bindingCount; ++bindingIndex)
+            {
+                const auto& bindingRecord = bindings[setRecord.firstBinding + bindingIndex];
+                const auto bindingName = getName(bindingRecord.nameOffset);
+                if (!bindingName || bindingRecord.firstMember + static_cast<u64>(bindingRecord.memberCount) > header->memberCount)
+                    return std::nullopt;
+
+                auto& binding = set.bindings[bindingIndex];
+                binding.set = bindingRecord.set;
+                binding.binding = bindingRecord.binding;
+                binding.name = *bindingName;
+                binding.type = static_cast<BindingType>(bindingRecord.type);
+                binding.bufferSize = static_cast<size>(bindingRecord.bufferSize);
+
+                binding.bufferMembers.resize(bindingRecord.memberCount);
+                for (u32 memberIndex = 0; memberIndex < bindingRecord.memberCount; ++memberIndex)
+                {
+                    const auto& memberRecord = members[bindingRecord.firstMember + memberIndex];
+                    const auto memberName = getName(memberRecord.nameOffset);
+                    if (!memberName)
+                        return std::nullopt;
+
+                    binding.bufferMembers[memberIndex] = { *memberName, memberRecord.id, memberRecord.byteOffset, memberRecord.byteSize };
+                }
+            }
+        }
+        return reflectionData;
+    }
+
+    auto ShaderReflection::getMemberId(const std::string& bindingName, const std::string& memberName) -> u64
+    {
+        // Hashed in pieces, giving the same id as hashing the joined name
+        u64 id = Hash::fnv1aString(bindingName);
+        id = Hash::fnv1aString(".", id);
+        return Hash::fnv1aString(memberName, id);
+    }
+}
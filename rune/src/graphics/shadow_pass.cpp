@@ -0,0 +1,436 @@
+// # Copyright  Stuart Millman <stu.millman15@gmail.com>
+
+#include "pch.hpp"
+#include "rune/graphics/shadow_pass.hpp"
+
+#include "rune/graphics/graphics.hpp"
+
+#include <glm/common.hpp>
+#include <glm/ext/matrix_clip_space.hpp>
+#include <glm/ext/matrix_transform.hpp>
+#include <glm/matrix.hpp>
+#include <glm/trigonometric.hpp>
+
+namespace Rune
+{
+    namespace
+    {
+        /* Cascades move in steps of this fraction of their radius, so they stay cached while the camera moves a little */
+        constexpr f32 CascadeSnapFraction = 0.25f;
+
+        /* Blend between uniform (0) and logarithmic (1) cascade splits */
+        constexpr f32 CascadeSplitLambda = 0.75f;
+
+        constexpr f32 PointShadowNearPlane = 0.05f;
+
+        /* Same layout as the scene uniform buffer, for rendering from a light */
+        struct ShadowScene
+        {
+            glm::mat4 proj;
+            glm::mat4 view;
+            glm::mat4 world;
+        };
+
+        auto hashCaster(const ShadowPass::Caster& caster) -> u64
+        {
+            // FNV-1a of the mesh range and transform
+            u64 hash = 14695981039346656037ull;
+            const auto hashBytes = [&hash](const void* data, const size byteSize)
+            {
+                const auto* bytes = static_cast<const u8*>(data);
+                for (size i = 0; i < byteSize; ++i)
+                {
+                    hash = (hash ^ bytes[i]) * 1099511628211ull;
+                }
+            };
+
+            const u32 meshId = caster.mesh->getId();
+            hashBytes(&meshId, sizeof(meshId));
+            hashBytes(&caster.submesh, sizeof(caster.submesh));
+            hashBytes(&caster.lod, sizeof(caster.lod));
+            hashBytes(&caster.transform, sizeof(glm::mat4));
+            return hash;
+        }
+    }
+
+    ShadowPass::ShadowPass() = default;
+
+    ShadowPass::~ShadowPass() = default;
+
+    void ShadowPass::init(RendererBase* renderer)
+    {
+        m_renderer = renderer;
+        createMaps();
+    }
+
+    void ShadowPass::cleanup()
+    {
+        destroyMaps();
+        m_renderer = nullptr;
+    }
+
+    auto ShadowPass::getSettings() const -> const ShadowSettings&
+    {
+        return m_settings;
+    }
+
+    void ShadowPass::setSettings(const ShadowSettings& settings)
+    {
+        const bool mapsChanged = settings.enabled != m_settings.enabled || settings.cascadeResolution != m_settings.cascadeResolution ||
+                                 settings.pointResolution != m_settings.pointResolution;
+        m_settings = settings;
+
+        if (mapsChanged && m_renderer != nullptr)
+        {
+            destroyMaps();
+            createMaps();
+        }
+    }
+
+    void ShadowPass::render(const glm::mat4& cameraProj,
+                            const glm::mat4& cameraView,
+                            const Frustum& cameraFrustum,
+                            const f32 cameraNear,
+                            const std::vector<ShadowedLight>& lights,
+                            const std::vector<Caster>& casters,
+                            const bool useMultiDrawIndirect)
+    {
+        m_lastFrameCounts = {};
+        m_views.clear();
+        m_commands.clear();
+        m_instances.clear();
+        m_uniforms.pointShadowLights = glm::ivec4(-1);
+        m_uniforms.shadowInfo = { -1, 0, 0, 0 };
+
+        if (m_settings.enabled && !lights.empty())
+        {
+            // Every view culls against the same caster boxes
+            m_casterBoxes.clear();
+            m_casterBoxIndices.clear();
+            m_unboundedCasters.clear();
+            for (u32 casterIndex = 0; casterIndex < casters.size(); ++casterIndex)
+            {
+                if (casters[casterIndex].worldBox.isValid())
+                {
+                    m_casterBoxes.add(casters[casterIndex].worldBox);
+                    m_casterBoxIndices.push_back(casterIndex);
+                }
+                else
+                {
+                    m_unboundedCasters.push_back(casterIndex);
+                }
+            }
+
+            bool hasCascades = false;
+            u32 pointCount = 0;
+            for (const auto& shadowedLight : lights)
+            {
+                const auto& light = shadowedLight.light;
+                if (light.isDirectional)
+                {
+                    if (hasCascades)
+                        continue;
+
+                    hasCascades = true;
+                    m_uniforms.shadowInfo.x = shadowedLight.shaderIndex;
+                    addCascadeViews(cameraProj, cameraView, cameraNear, light, casters);
+                }
+                else if (pointCount < MaxPointLights && light.range > 0.0f)
+                {
+                    // A light whose reach is out of view cannot shadow anything visible
+                    const AABB reach = { light.position - glm::vec3(light.range), light.position + glm::vec3(light.range) };
+                    if (!cameraFrustum.intersects(reach))
+                        continue;
+
+                    m_uniforms.pointShadowLights[static_cast<i32>(pointCount)] = shadowedLight.shaderIndex;
+                    addPointViews(light, pointCount, casters);
+                    ++pointCount;
+                }
+            }
+            m_uniforms.shadowInfo.y = static_cast<i32>(pointCount);
+        }
+
+        // Every view draws from one upload of the instance data
+        if (!m_instances.empty())
+        {
+            const auto instanceRange = m_renderer->uploadFrameData(m_instances.data(), m_instances.size() * sizeof(InstanceData));
+            m_renderer->bindFrameStorageBuffer(instanceRange, ShaderBindings::InstanceStorageBuffer);
+        }
+
+        renderMap(eCascadeMap, useMultiDrawIndirect);
+        renderMap(ePointMap, useMultiDrawIndirect);
+
+        const auto uniformRange = m_renderer->uploadFrameData(&m_uniforms, sizeof(ShadowUniforms));
+        m_renderer->bindFrameUniformBuffer(uniformRange, ShaderBindings::ShadowUniformBuffer);
+    }
+
+    auto ShadowPass::getLastFrameCounts() const -> const FrameCounts&
+    {
+        return m_lastFrameCounts;
+    }
+
+    void ShadowPass::createMaps()
+    {
+        // Maps exist even with shadows disabled, so lit shaders always have something bound
+        const std::array<u32, eMapTypeCount> resolutions = { m_settings.cascadeResolution, m_settings.pointResolution };
+        const std::array<u32, eMapTypeCount> layerCounts = { CascadeCount, MaxPointLights * PointFaceCount };
+
+        for (u32 mapType = 0; mapType < eMapTypeCount; ++mapType)
+        {
+            auto& map = m_maps[mapType];
+            map.resolution = m_settings.enabled ? resolutions[mapType] : 1;
+            map.staticId = m_renderer->createShadowMap(map.resolution, layerCounts[mapType]);
+            map.dynamicId = m_renderer->createShadowMap(map.resolution, layerCounts[mapType]);
+            map.cachedLayers.assign(layerCounts[mapType], {});
+        }
+    }
+
+    void ShadowPass::destroyMaps()
+    {
+        for (auto& map : m_maps)
+        {
+            if (map.staticId != 0)
+                m_renderer->destroyShadowMap(map.staticId);
+            if (map.dynamicId != 0)
+                m_renderer->destroyShadowMap(map.dynamicId);
+
+            map = {};
+        }
+    }
+
+    void ShadowPass::addCascadeViews(const glm::mat4& cameraProj,
+                                     const glm::mat4& cameraView,
+                                     const f32 cameraNear,
+                                     const Light& light,
+                                     const std::vector<Caster>& casters)
+    {
+        // Squared distance from the view axis to a frustum corner, per unit of depth
+        const f32 tanHalfFovX = 1.0f / cameraProj[0][0];
+        const f32 tanHalfFovY = 1.0f / cameraProj[1][1];
+        const f32 cornerScaleSqr = tanHalfFovX * tanHalfFovX + tanHalfFovY * tanHalfFovY;
+
+        const f32 cameraFar = cameraProj[3][2] / (1.0f - cameraProj[2][2]);
+        const f32 shadowFar = std::min(m_settings.distance, cameraFar);
+        const auto inverseView = glm::inverse(cameraView);
+
+        // Light direction points towards the light, the cascades look the way the light travels
+        const auto travelDir = -glm::normalize(glm::vec3(light.direction));
+        const auto up = std::abs(travelDir.y) > 0.99f ? glm::vec3(0.0f, 0.0f, 1.0f) : glm::vec3(0.0f, 1.0f, 0.0f);
+        const auto lightView = glm::lookAt(glm::vec3(0.0f), travelDir, up);
+
+        f32 splitNear = cameraNear;
+        for (u32 cascade = 0; cascade < CascadeCount; ++cascade)
+        {
+            const f32 t = f32(cascade + 1) / CascadeCount;
+            const f32 uniformSplit = cameraNear + (shadowFar - cameraNear) * t;
+            const f32 logSplit = cameraNear * std::pow(shadowFar / cameraNear, t);
+            const f32 splitFar = glm::mix(uniformSplit, logSplit, CascadeSplitLambda);
+            m_uniforms.cascadeSplits[static_cast<i32>(cascade)] = splitFar;
+
+            // Smallest sphere around the slice of the view frustum, which does not change size as the camera turns
+            f32 centerDepth = (splitNear + splitFar) * (1.0f + cornerScaleSqr) * 0.5f;
+            f32 radius;
+            if (centerDepth >= splitFar)
+            {
+                centerDepth = splitFar;
+                radius = splitFar * std::sqrt(cornerScaleSqr);
+            }
+            else
+            {
+                radius = std::sqrt((centerDepth - splitNear) * (centerDepth - splitNear) + splitNear * splitNear * cornerScaleSqr);
+            }
+            radius = std::ceil(radius * 16.0f) / 16.0f;
+
+            // Move the cascade in whole steps of texels, so it keeps matching its cached static map while the camera moves
+            const f32 halfSize = radius * (1.0f + CascadeSnapFraction);
+            const f32 texelSize = 2.0f * halfSize / f32(m_settings.cascadeResolution);
+            const f32 snapStep = std::max(std::floor(radius * CascadeSnapFraction / texelSize), 1.0f) * texelSize;
+
+            const auto worldCenter = glm::vec3(inverseView * glm::vec4(0.0f, 0.0f, centerDepth, 1.0f));
+            auto lightCenter = glm::vec3(lightView * glm::vec4(worldCenter, 1.0f));
+            lightCenter = glm::floor(lightCenter / snapStep) * snapStep;
+
+            // Extend towards the light so casters outside the view still shadow it
+            const auto cascadeProj = glm::ortho(lightCenter.x - halfSize,
+                                                lightCenter.x + halfSize,
+                                                lightCenter.y - halfSize,
+                                                lightCenter.y + halfSize,
+                                                lightCenter.z - halfSize - m_settings.distance,
+                                                lightCenter.z + halfSize);
+
+            m_uniforms.cascadeViewProj[cascade] = cascadeProj * lightView;
+            addView(eCascadeMap, cascade, cascadeProj, lightView, casters);
+
+            splitNear = splitFar;
+        }
+    }
+
+    void ShadowPass::addPointViews(const Light& light, const u32 pointIndex, const std::vector<Caster>& casters)
+    {
+        // Face order is +X, -X, +Y, -Y, +Z, -Z, which shaders rely on to pick a face
+        static const std::array<glm::vec3, PointFaceCount> faceDirs = {
+            glm::vec3(1, 0, 0), glm::vec3(-1, 0, 0), glm::vec3(0, 1, 0), glm::vec3(0, -1, 0), glm::vec3(0, 0, 1), glm::vec3(0, 0, -1)
+        };
+        static const std::array<glm::vec3, PointFaceCount> faceUps = {
+            glm::vec3(0, 1, 0), glm::vec3(0, 1, 0), glm::vec3(0, 0, -1), glm::vec3(0, 0, 1), glm::vec3(0, 1, 0), glm::vec3(0, 1, 0)
+        };
+
+        const auto faceProj = glm::perspective(glm::radians(90.0f), 1.0f, PointShadowNearPlane, light.range);
+        for (u32 face = 0; face < PointFaceCount; ++face)
+        {
+            const u32 layer = pointIndex * PointFaceCount + face;
+            const auto faceView = glm::lookAt(light.position, light.position + faceDirs[face], faceUps[face]);
+
+            m_uniforms.pointViewProj[layer] = faceProj * faceView;
+            addView(ePointMap, layer, faceProj, faceView, casters);
+        }
+    }
+
+    void ShadowPass::addView(
+        const MapType mapType, const u32 layer, const glm::mat4& proj, const glm::mat4& view, const std::vector<Caster>& casters)
+    {
+        const auto viewProj = proj * view;
+
+        // Cull, then split the casters while keeping their order, so ones sharing a mesh stay adjacent
+        Culling::cullBoxes(Frustum::fromMatrix(viewProj), m_casterBoxes, m_casterBoxVisibility);
+        m_casterVisibility.assign(casters.size(), 0);
+        for (const auto casterIndex : m_unboundedCasters)
+        {
+            m_casterVisibility[casterIndex] = 1;
+        }
+        for (size boxIndex = 0; boxIndex < m_casterBoxIndices.size(); ++boxIndex)
+        {
+            m_casterVisibility[m_casterBoxIndices[boxIndex]] = m_casterBoxVisibility[boxIndex];
+        }
+
+        m_staticCasters.clear();
+        m_dynamicCasters.clear();
+        u64 staticHash = 0;
+        for (u32 casterIndex = 0; casterIndex < casters.size(); ++casterIndex)
+        {
+            if (!m_casterVisibility[casterIndex])
+                continue;
+
+            if (casters[casterIndex].isStatic)
+            {
+                m_staticCasters.push_back(casterIndex);
+                // Order independent, so only the set of casters matters
+                staticHash += hashCaster(casters[casterIndex]);
+            }
+            else
+            {
+                m_dynamicCasters.push_back(casterIndex);
+            }
+        }
+
+        auto& shadowView = m_views.emplace_back();
+        shadowView.mapType = mapType;
+        shadowView.layer = layer;
+        shadowView.proj = proj;
+        shadowView.view = view;
+        shadowView.staticHash = staticHash;
+
+        const auto& cachedLayer = m_maps[mapType].cachedLayers[layer];
+        shadowView.isStaticDirty = cachedLayer.viewProj != viewProj || cachedLayer.staticHash != staticHash;
+
+        shadowView.firstStaticCommand = static_cast<u32>(m_commands.size());
+        if (shadowView.isStaticDirty)
+            addCommands(casters, m_staticCasters);
+        shadowView.staticCommandCount = static_cast<u32>(m_commands.size()) - shadowView.firstStaticCommand;
+
+        shadowView.firstDynamicCommand = static_cast<u32>(m_commands.size());
+        addCommands(casters, m_dynamicCasters);
+        shadowView.dynamicCommandCount = static_cast<u32>(m_commands.size()) - shadowView.firstDynamicCommand;
+    }
+
+    void ShadowPass::addCommands(const std::vector<Caster>& casters, const std::vector<u32>& casterIndices)
+    {
+        const size firstCommand = m_commands.size();
+        for (const auto casterIndex : casterIndices)
+        {
+            const auto& caster = casters[casterIndex];
+            const bool isSameRange = m_commands.size() > firstCommand && m_commands.back().mesh == caster.mesh &&
+                                     m_commands.back().submesh == caster.submesh && m_commands.back().lod == caster.lod;
+            if (isSameRange)
+                ++m_commands.back().instanceCount;
+            else
+                m_commands.push_back({ caster.mesh, 1, static_cast<u32>(m_instances.size()), caster.lod, caster.submesh });
+
+            m_instances.push_back(InstanceData::create(caster.transform, caster.mesh->getVertexEncoding()));
+        }
+    }
+
+    void ShadowPass::renderMap(const MapType mapType, const bool useMultiDrawIndirect)
+    {
+        auto& map = m_maps[mapType];
+        const u32 binding = mapType == eCascadeMap ? ShaderBindings::CascadeShadowMapTexture : ShaderBindings::PointShadowMapTexture;
+
+        const auto renderView = [&](const View& view, const u32 shadowMapId, const bool clear, const u32 firstCommand, const u32 commandCount)
+        {
+            m_renderer->beginShadowPass(shadowMapId, view.layer, clear);
+
+            const ShadowScene scene = { view.proj, view.view, glm::mat4(1.0f) };
+            const auto sceneRange = m_renderer->uploadFrameData(&scene, sizeof(ShadowScene));
+            m_renderer->bindFrameUniformBuffer(sceneRange, ShaderBindings::SceneUniformBuffer);
+
+            drawCommands(firstCommand, commandCount, useMultiDrawIndirect);
+            m_renderer->endShadowPass();
+        };
+
+        // Bring the static map up to date
+        bool hasDynamicCasters = false;
+        for (const auto& view : m_views)
+        {
+            if (view.mapType != mapType)
+                continue;
+
+            if (view.isStaticDirty)
+            {
+                renderView(view, map.staticId, true, view.firstStaticCommand, view.staticCommandCount);
+                map.cachedLayers[view.layer] = { view.proj * view.view, view.staticHash };
+                ++m_lastFrameCounts.viewsRendered;
+            }
+            else
+            {
+                ++m_lastFrameCounts.viewsCached;
+                if (view.dynamicCommandCount > 0)
+                    ++m_lastFrameCounts.viewsRendered;
+            }
+
+            hasDynamicCasters |= view.dynamicCommandCount > 0;
+        }
+
+        if (!hasDynamicCasters)
+        {
+            m_renderer->bindShadowMap(map.staticId, binding);
+            return;
+        }
+
+        // Composite the dynamic casters over a copy of the static map
+        m_renderer->copyShadowMap(map.staticId, map.dynamicId);
+        for (const auto& view : m_views)
+        {
+            if (view.mapType == mapType && view.dynamicCommandCount > 0)
+                renderView(view, map.dynamicId, false, view.firstDynamicCommand, view.dynamicCommandCount);
+        }
+        m_renderer->bindShadowMap(map.dynamicId, binding);
+    }
+
+    void ShadowPass::drawCommands(const u32 firstCommand, const u32 commandCount, const bool useMultiDrawIndirect)
+    {
+        if (commandCount == 0)
+            return;
+
+        if (useMultiDrawIndirect)
+        {
+            m_renderer->drawIndirect(&m_commands[firstCommand], commandCount);
+            return;
+        }
+
+        for (u32 i = firstCommand; i < firstCommand + commandCount; ++i)
+        {
+            m_renderer->bindMesh(m_commands[i].mesh, m_commands[i].lod, m_commands[i].submesh);
+            m_renderer->drawInstanced(m_commands[i].instanceCount, m_commands[i].firstInstance);
+        }
+    }
+}
@@ -3,26 +3,55 @@
 #include "pch.hpp"
 #include "rune/graphics/texture.hpp"
 
+#include "rune/macros.hpp"
 #include "rune/graphics/graphics.hpp"
 
+#include <cstring>
+
 namespace Rune
 {
     Texture::~Texture()
     {
+        GraphicsSystem::getInstance().getTextureStreamer().remove(this);
+
         auto* renderer = GraphicsSystem::getInstance().getRenderer();
         renderer->destroyTexture(m_internalId);
     }
 
-    void Texture::init(const i32 width, const i32 height, const TextureFormat format, const std::vector<u8>& data)
+    void Texture::init(const i32 width,
+                       const i32 height,
+                       const TextureFormat format,
+                       const u32 mipCount,
+                       const std::vector<u8>& data,
+                       const u32 importedMip)
     {
         m_width = width;
         m_height = height;
         m_format = format;
+        m_mipCount = mipCount;
+        m_requestedMip = mipCount;
+        m_importedMip = importedMip;
 
-        m_data = data;
+        // Room is kept for the mips still to be imported
+        const size importedOffset = getMipChainDataSize(m_format, static_cast<u32>(m_width), static_cast<u32>(m_height), m_importedMip);
+        m_data.resize(importedOffset + data.size());
+        std::memcpy(&m_data[importedOffset], data.data(), data.size());
+
+        auto& streamer = GraphicsSystem::getInstance().getTextureStreamer();
+        m_residentMip = streamer.getInitialResidentMip(static_cast<u32>(m_width), static_cast<u32>(m_height), m_mipCount);
+        m_residentMip = std::max(m_residentMip, m_importedMip);
+        m_finestLoadedMip = m_residentMip;
+        m_appliedResidentMip = m_residentMip;
 
         auto* renderer = GraphicsSystem::getInstance().getRenderer();
-        m_internalId = renderer->createTexture(m_width, m_height, m_format, m_data.data());
+        m_internalId = renderer->createTexture(m_width, m_height, m_format, m_mipCount);
+        renderer->setTextureResidentMip(m_internalId, m_residentMip);
+        for (u32 mip = m_residentMip; mip < m_mipCount; ++mip)
+        {
+            uploadMip(mip);
+        }
+
+        streamer.add(this);
     }
 
     auto Texture::getWidth() const -> i32
@@ -40,6 +69,109 @@ namespace Rune
         return m_format;
     }
 
+    auto Texture::getMipCount() const -> u32
+    {
+        return m_mipCount;
+    }
+
+    auto Texture::getResidentMip() const -> u32
+    {
+        return m_residentMip;
+    }
+
+    auto Texture::getResidentDataSize() const -> size
+    {
+        const auto width = static_cast<u32>(m_width);
+        const auto height = static_cast<u32>(m_height);
+        return getMipChainDataSize(m_format, width, height, m_mipCount) - getMipChainDataSize(m_format, width, height, m_residentMip);
+    }
+
+    auto Texture::getMipDataSize(const u32 mip) const -> size
+    {
+        const u32 mipWidth = getMipLevelSize(static_cast<u32>(m_width), mip);
+        const u32 mipHeight = getMipLevelSize(static_cast<u32>(m_height), mip);
+        return getTextureDataSize(m_format, mipWidth, mipHeight);
+    }
+
+    auto Texture::getFinestLoadedMip() const -> u32
+    {
+        return m_finestLoadedMip;
+    }
+
+    auto Texture::getImportedMip() const -> u32
+    {
+        return m_importedMip;
+    }
+
+    void Texture::setImportedMip(const u32 mip, const std::vector<u8>& data)
+    {
+        RUNE_ENG_ASSERT(mip + 1 == m_importedMip && data.size() == getMipDataSize(mip), "Texture mips must be imported in order");
+
+        const size dataOffset = getMipChainDataSize(m_format, static_cast<u32>(m_width), static_cast<u32>(m_height), mip);
+        std::memcpy(&m_data[dataOffset], data.data(), data.size());
+        m_importedMip = mip;
+    }
+
+    auto Texture::getLastUsedFrame() const -> u64
+    {
+        return m_lastUsedFrame;
+    }
+
+    void Texture::setLastUsedFrame(const u64 frameIndex)
+    {
+        m_lastUsedFrame = frameIndex;
+    }
+
+    void Texture::requestMip(const u32 mip)
+    {
+        m_requestedMip = std::min(m_requestedMip, mip);
+    }
+
+    auto Texture::getRequestedMip() const -> u32
+    {
+        return m_requestedMip;
+    }
+
+    void Texture::clearRequestedMip()
+    {
+        m_requestedMip = m_mipCount;
+    }
+
+    auto Texture::streamInMip() -> size
+    {
+        if (m_residentMip <= m_importedMip)
+            return 0;
+
+        const u32 mip = m_residentMip - 1;
+        m_residentMip = mip;
+        m_finestLoadedMip = std::min(m_finestLoadedMip, mip);
+        return getMipDataSize(mip);
+    }
+
+    auto Texture::evictMip() -> size
+    {
+        if (m_residentMip + 1 >= m_mipCount)
+            return 0;
+
+        const size freedSize = getMipDataSize(m_residentMip);
+        ++m_residentMip;
+        return freedSize;
+    }
+
+    void Texture::applyResidentMip()
+    {
+        if (m_residentMip == m_appliedResidentMip)
+            return;
+
+        // Mips the renderer already holds are kept when it reallocates, only finer ones need uploading
+        GraphicsSystem::getInstance().getRenderer()->setTextureResidentMip(m_internalId, m_residentMip);
+        for (u32 mip = m_residentMip; mip < m_appliedResidentMip; ++mip)
+        {
+            uploadMip(mip);
+        }
+        m_appliedResidentMip = m_residentMip;
+    }
+
     auto Texture::getData() const -> const std::vector<u8>&
     {
         return m_data;
@@ -49,4 +181,10 @@ namespace Rune
     {
         return m_internalId;
     }
+
+    void Texture::uploadMip(const u32 mip)
+    {
+        const size dataOffset = getMipChainDataSize(m_format, static_cast<u32>(m_width), static_cast<u32>(m_height), mip);
+        GraphicsSystem::getInstance().getRenderer()->uploadTextureMip(m_internalId, mip, &m_data[dataOffset]);
+    }
 }
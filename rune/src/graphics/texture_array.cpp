@@ -0,0 +1,59 @@
+// # Copyright  Stuart Millman <stu.millman15@gmail.com>
+
+#include "pch.hpp"
+#include "rune/graphics/texture_array.hpp"
+
+#include "rune/macros.hpp"
+#include "rune/graphics/graphics.hpp"
+#include "rune/graphics/texture.hpp"
+
+namespace Rune
+{
+    TextureArray::~TextureArray()
+    {
+        if (m_internalId != 0)
+            GraphicsSystem::getInstance().getRenderer()->destroyTextureArray(m_internalId);
+    }
+
+    void TextureArray::init(const std::vector<Texture*>& layers)
+    {
+        RUNE_ENG_ASSERT(!layers.empty() && layers.size() <= MaxLayerCount, "Texture array layer count out of range");
+
+        const auto& first = *layers.front();
+        const auto width = static_cast<u32>(first.getWidth());
+        const auto height = static_cast<u32>(first.getHeight());
+        m_layerCount = static_cast<u32>(layers.size());
+
+        auto* renderer = GraphicsSystem::getInstance().getRenderer();
+        m_internalId = renderer->createTextureArray(width, height, first.getFormat(), first.getMipCount(), m_layerCount);
+
+        for (u32 layer = 0; layer < m_layerCount; ++layer)
+        {
+            RUNE_ENG_ASSERT(isCompatible(first, *layers[layer]), "Texture array layers must match in size, format and mip count");
+
+            // Source textures keep every mip in memory, even those not resident
+            const auto& data = layers[layer]->getData();
+            for (u32 mip = 0; mip < first.getMipCount(); ++mip)
+            {
+                const size dataOffset = getMipChainDataSize(first.getFormat(), width, height, mip);
+                renderer->uploadTextureArrayMip(m_internalId, layer, mip, &data[dataOffset]);
+            }
+        }
+    }
+
+    bool TextureArray::isCompatible(const Texture& a, const Texture& b)
+    {
+        return a.getWidth() == b.getWidth() && a.getHeight() == b.getHeight() && a.getFormat() == b.getFormat() &&
+               a.getMipCount() == b.getMipCount();
+    }
+
+    auto TextureArray::getLayerCount() const -> u32
+    {
+        return m_layerCount;
+    }
+
+    auto TextureArray::getInternalId() const -> u32
+    {
+        return m_internalId;
+    }
+}
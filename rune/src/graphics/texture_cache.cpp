@@ -0,0 +1,84 @@
+// # Copyright  Stuart Millman <stu.millman15@gmail.com>
+
+#include "pch.hpp"
+#include "rune/graphics/texture_cache.hpp"
+
+#include "rune/macros.hpp"
+#include "rune/utility/mapped_file.hpp"
+
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+
+namespace Rune
+{
+    namespace
+    {
+        constexpr u32 TextureCacheMagic = 0x43584554;  // "TEXC"
+        /* Raise whenever mip filtering or block encoding changes, so textures encoded before are imported again */
+        constexpr u32 TextureCacheVersion = 1;
+
+        /* The file is the header, then the mip chain */
+        struct FileHeader
+        {
+            u32 magic;
+            u32 version;
+            u64 sourceHash;
+            u32 width;
+            u32 height;
+            u32 format;
+            u32 mipCount;
+            u64 dataSize;
+        };
+    }
+
+    auto TextureCache::getCacheFilename(const std::string& sourceFilename) -> std::string
+    {
+        // Appended rather than replacing the extension, so images differing only by extension do not share a file
+        return sourceFilename + ".texcache";
+    }
+
+    bool TextureCache::save(const std::string& filename, const u64 sourceHash, const EncodedTexture& texture)
+    {
+        std::ofstream file(filename, std::ios::binary | std::ios::trunc);
+        if (!file.is_open())
+        {
+            CORE_LOG_WARN("Failed to write texture cache '{}'", filename);
+            return false;
+        }
+
+        const FileHeader header{ TextureCacheMagic,
+                                 TextureCacheVersion,
+                                 sourceHash,
+                                 texture.width,
+                                 texture.height,
+                                 static_cast<u32>(texture.format),
+                                 texture.mipCount,
+                                 texture.data.size() };
+        file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        file.write(reinterpret_cast<const char*>(texture.data.data()), static_cast<std::streamsize>(texture.data.size()));
+        return file.good();
+    }
+
+    auto TextureCache::load(const std::string& filename, const u64 sourceHash) -> std::optional<EncodedTexture>
+    {
+        MappedFile file;
+        if (!file.open(filename) || file.getSize() < sizeof(FileHeader))
+            return std::nullopt;
+
+        FileHeader header;
+        std::memcpy(&header, file.getData(), sizeof(header));
+        if (header.magic != TextureCacheMagic || header.version != TextureCacheVersion || header.sourceHash != sourceHash)
+            return std::nullopt;
+
+        // Sizes are checked so a damaged file cannot read past the mapping
+        const auto format = static_cast<TextureFormat>(header.format);
+        if (!isCompressed(format) || header.mipCount == 0 || header.mipCount > getMipLevelCount(header.width, header.height) ||
+            header.dataSize != getMipChainDataSize(format, header.width, header.height, header.mipCount) ||
+            header.dataSize != file.getSize() - sizeof(header))
+            return std::nullopt;
+
+        const auto* data = file.getData() + sizeof(header);
+        return EncodedTexture{ header.width, header.height, format, header.mipCount, std::vector<u8>(data, data + header.dataSize) };
+    }
+}
@@ -0,0 +1,647 @@
+// # Copyright  Stuart Millman <stu.millman15@gmail.com>
+
+#include "pch.hpp"
+#include "rune/graphics/texture_compress.hpp"
+
+#include "rune/utility/thread_pool.hpp"
+
+#include <glm/common.hpp>
+#include <glm/geometric.hpp>
+#include <glm/vec3.hpp>
+#include <glm/vec4.hpp>
+#include <glm/ext/vector_uint4_sized.hpp>
+
+#include <algorithm>
+#include <array>
+#include <limits>
+
+namespace Rune
+{
+    namespace
+    {
+        constexpr u32 BlockTexelCount = 16;
+
+        /* Texels of one 4x4 block as RGBA */
+        using Block = std::array<glm::u8vec4, BlockTexelCount>;
+
+        /* Least squares endpoint refinement passes for colour blocks */
+        constexpr u32 ColorRefineIterations = 2;
+
+        auto fetchBlock(const u8* pixels, const u32 width, const u32 height, const u32 channels, const u32 blockX, const u32 blockY)
+            -> Block
+        {
+            Block block{};
+            for (u32 y = 0; y < 4; ++y)
+            {
+                const u32 pixelY = std::min(blockY * 4 + y, height - 1);
+                for (u32 x = 0; x < 4; ++x)
+                {
+                    const u32 pixelX = std::min(blockX * 4 + x, width - 1);
+                    const u8* pixel = &pixels[(static_cast<size>(pixelY) * width + pixelX) * channels];
+
+                    auto& texel = block[y * 4 + x];
+                    if (channels <= 2)
+                        texel = { pixel[0], pixel[0], pixel[0], channels == 2 ? pixel[1] : 255 };
+                    else
+                        texel = { pixel[0], pixel[1], pixel[2], channels == 4 ? pixel[3] : 255 };
+                }
+            }
+            return block;
+        }
+
+        auto packColor565(const glm::vec3& color) -> u16
+        {
+            const auto clamped = glm::clamp(color, 0.0f, 255.0f);
+            const auto r = static_cast<u16>(clamped.r * (31.0f / 255.0f) + 0.5f);
+            const auto g = static_cast<u16>(clamped.g * (63.0f / 255.0f) + 0.5f);
+            const auto b = static_cast<u16>(clamped.b * (31.0f / 255.0f) + 0.5f);
+            return static_cast<u16>((r << 11) | (g << 5) | b);
+        }
+
+        auto unpackColor565(const u16 packed) -> glm::vec3
+        {
+            const u32 r = (packed >> 11) & 31;
+            const u32 g = (packed >> 5) & 63;
+            const u32 b = packed & 31;
+            return { static_cast<f32>((r << 3) | (r >> 2)), static_cast<f32>((g << 2) | (g >> 4)), static_cast<f32>((b << 3) | (b >> 2)) };
+        }
+
+        auto getColorPalette(const u16 color0, const u16 color1) -> std::array<glm::vec3, 4>
+        {
+            const auto c0 = unpackColor565(color0);
+            const auto c1 = unpackColor565(color1);
+            return { c0, c1, (2.0f * c0 + c1) / 3.0f, (c0 + 2.0f * c1) / 3.0f };
+        }
+
+        /**
+         * @return 2bit palette index of every texel, texel 0 in the lowest bits.
+         */
+        auto findColorIndices(const std::array<glm::vec3, BlockTexelCount>& colors, const std::array<glm::vec3, 4>& palette) -> u32
+        {
+            u32 indices = 0;
+            for (u32 i = 0; i < BlockTexelCount; ++i)
+            {
+                u32 bestIndex = 0;
+                f32 bestDistance = std::numeric_limits<f32>::max();
+                for (u32 p = 0; p < 4; ++p)
+                {
+                    const auto delta = colors[i] - palette[p];
+                    const f32 distance = glm::dot(delta, delta);
+                    if (distance < bestDistance)
+                    {
+                        bestDistance = distance;
+                        bestIndex = p;
+                    }
+                }
+                indices |= bestIndex << (i * 2);
+            }
+            return indices;
+        }
+
+        /**
+         * BC1 colour block, always in 4 colour mode so it is also valid as the colour half of BC3.
+         * Endpoints start at the extremes along the principal axis of the colours, then are fitted to the chosen indices.
+         */
+        void encodeColorBlock(const Block& block, u8* out)
+        {
+            std::array<glm::vec3, BlockTexelCount> colors{};
+            glm::vec3 mean(0.0f);
+            for (u32 i = 0; i < BlockTexelCount; ++i)
+            {
+                colors[i] = glm::vec3(block[i]);
+                mean += colors[i];
+            }
+            mean /= static_cast<f32>(BlockTexelCount);
+
+            // Covariance, then its principal axis by power iteration
+            f32 xx = 0, xy = 0, xz = 0, yy = 0, yz = 0, zz = 0;
+            for (const auto& color : colors)
+            {
+                const auto d = color - mean;
+                xx += d.x * d.x;
+                xy += d.x * d.y;
+                xz += d.x * d.z;
+                yy += d.y * d.y;
+                yz += d.y * d.z;
+                zz += d.z * d.z;
+            }
+
+            glm::vec3 axis(1.0f);
+            for (u32 i = 0; i < 8; ++i)
+            {
+                const glm::vec3 next(xx * axis.x + xy * axis.y + xz * axis.z,
+                                     xy * axis.x + yy * axis.y + yz * axis.z,
+                                     xz * axis.x + yz * axis.y + zz * axis.z);
+                const f32 length = glm::length(next);
+                if (length < 1e-6f)
+                    break;
+                axis = next / length;
+            }
+
+            f32 minProjection = std::numeric_limits<f32>::max();
+            f32 maxProjection = std::numeric_limits<f32>::lowest();
+            for (const auto& color : colors)
+            {
+                const f32 projection = glm::dot(color - mean, axis);
+                minProjection = std::min(minProjection, projection);
+                maxProjection = std::max(maxProjection, projection);
+            }
+
+            glm::vec3 endpoint0 = mean + axis * maxProjection;
+            glm::vec3 endpoint1 = mean + axis * minProjection;
+
+            // Solve for the endpoints that best reproduce the texels with the indices they currently get
+            for (u32 iteration = 0; iteration < ColorRefineIterations; ++iteration)
+            {
+                const u32 indices = findColorIndices(colors, getColorPalette(packColor565(endpoint0), packColor565(endpoint1)));
+
+                constexpr std::array<f32, 4> IndexWeights = { 0.0f, 1.0f, 1.0f / 3.0f, 2.0f / 3.0f };
+                f32 aa = 0, ab = 0, bb = 0;
+                glm::vec3 ax(0.0f), bx(0.0f);
+                for (u32 i = 0; i < BlockTexelCount; ++i)
+                {
+                    const f32 b = IndexWeights[(indices >> (i * 2)) & 3];
+                    const f32 a = 1.0f - b;
+                    aa += a * a;
+                    ab += a * b;
+                    bb += b * b;
+                    ax += a * colors[i];
+                    bx += b * colors[i];
+                }
+
+                const f32 determinant = aa * bb - ab * ab;
+                if (std::abs(determinant) < 1e-6f)
+                    break;
+
+                endpoint0 = (ax * bb - bx * ab) / determinant;
+                endpoint1 = (bx * aa - ax * ab) / determinant;
+            }
+
+            u16 color0 = packColor565(endpoint0);
+            u16 color1 = packColor565(endpoint1);
+            if (color0 < color1)
+                std::swap(color0, color1);
+
+            // Equal endpoints would select 3 colour mode in BC1, where every index still decodes to the same colour
+            const u32 indices = color0 == color1 ? 0 : findColorIndices(colors, getColorPalette(color0, color1));
+
+            out[0] = static_cast<u8>(color0 & 0xFF);
+            out[1] = static_cast<u8>(color0 >> 8);
+            out[2] = static_cast<u8>(color1 & 0xFF);
+            out[3] = static_cast<u8>(color1 >> 8);
+            for (u32 i = 0; i < 4; ++i)
+            {
+                out[4 + i] = static_cast<u8>(indices >> (i * 8));
+            }
+        }
+
+        /**
+         * BC4 block of one channel, also the alpha half of BC3. Uses the 8 value mode between the block's extremes.
+         */
+        void encodeChannelBlock(const Block& block, const u32 channel, u8* out)
+        {
+            u8 minValue = 255;
+            u8 maxValue = 0;
+            for (const auto& texel : block)
+            {
+                minValue = std::min(minValue, texel[channel]);
+                maxValue = std::max(maxValue, texel[channel]);
+            }
+
+            out[0] = maxValue;
+            out[1] = minValue;
+
+            u64 indices = 0;
+            if (maxValue > minValue)
+            {
+                // Steps from the first endpoint (0) to the second (7), and the indices that select them
+                constexpr std::array<u64, 8> StepIndices = { 0, 2, 3, 4, 5, 6, 7, 1 };
+                const f32 stepScale = 7.0f / static_cast<f32>(maxValue - minValue);
+                for (u32 i = 0; i < BlockTexelCount; ++i)
+                {
+                    const auto step = static_cast<u32>(static_cast<f32>(maxValue - block[i][channel]) * stepScale + 0.5f);
+                    indices |= StepIndices[step] << (i * 3);
+                }
+            }
+
+            for (u32 i = 0; i < 6; ++i)
+            {
+                out[2 + i] = static_cast<u8>(indices >> (i * 8));
+            }
+        }
+
+        /* BC7 weights of 2bit and 4bit indices, out of 64 */
+        constexpr std::array<u32, 4> Bc7Weights2 = { 0, 21, 43, 64 };
+        constexpr std::array<u32, 16> Bc7Weights4 = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+
+        using BlockColors = std::array<glm::vec4, BlockTexelCount>;
+        using BlockIndices = std::array<u32, BlockTexelCount>;
+
+        auto interpolateBc7(const u32 value0, const u32 value1, const u32 weight) -> f32
+        {
+            return static_cast<f32>(((64 - weight) * value0 + weight * value1 + 32) >> 6);
+        }
+
+        /**
+         * @return Endpoints at the extremes of the colours along their principal axis.
+         */
+        auto findPrincipalEndpoints(const BlockColors& colors) -> std::array<glm::vec4, 2>
+        {
+            glm::vec4 mean(0.0f);
+            for (const auto& color : colors)
+            {
+                mean += color;
+            }
+            mean /= static_cast<f32>(BlockTexelCount);
+
+            // Covariance, then its principal axis by power iteration
+            std::array<glm::vec4, 4> covariance{};
+            for (const auto& color : colors)
+            {
+                const auto d = color - mean;
+                for (u32 row = 0; row < 4; ++row)
+                {
+                    covariance[row] += d[row] * d;
+                }
+            }
+
+            glm::vec4 axis(1.0f);
+            for (u32 i = 0; i < 8; ++i)
+            {
+                const glm::vec4 next(glm::dot(covariance[0], axis),
+                                     glm::dot(covariance[1], axis),
+                                     glm::dot(covariance[2], axis),
+                                     glm::dot(covariance[3], axis));
+                const f32 length = glm::length(next);
+                if (length < 1e-6f)
+                    break;
+                axis = next / length;
+            }
+
+            f32 minProjection = std::numeric_limits<f32>::max();
+            f32 maxProjection = std::numeric_limits<f32>::lowest();
+            for (const auto& color : colors)
+            {
+                const f32 projection = glm::dot(color - mean, axis);
+                minProjection = std::min(minProjection, projection);
+                maxProjection = std::max(maxProjection, projection);
+            }
+            return { mean + axis * minProjection, mean + axis * maxProjection };
+        }
+
+        /**
+         * @return Index of the nearest palette entry to every colour, adding their squared distances to the error.
+         */
+        template <size N>
+        auto findNearestIndices(const BlockColors& colors, const std::array<glm::vec4, N>& palette, f32& error) -> BlockIndices
+        {
+            BlockIndices indices{};
+            for (u32 i = 0; i < BlockTexelCount; ++i)
+            {
+                f32 bestDistance = std::numeric_limits<f32>::max();
+                for (u32 p = 0; p < N; ++p)
+                {
+                    const auto delta = colors[i] - palette[p];
+                    const f32 distance = glm::dot(delta, delta);
+                    if (distance < bestDistance)
+                    {
+                        bestDistance = distance;
+                        indices[i] = p;
+                    }
+                }
+                error += bestDistance;
+            }
+            return indices;
+        }
+
+        /**
+         * Solve for the endpoints that best reproduce the colours with the indices they currently get.
+         * @return False if the indices do not constrain both endpoints, leaving them unchanged.
+         */
+        template <size N>
+        auto refineEndpoints(const BlockColors& colors,
+                             const BlockIndices& indices,
+                             const std::array<u32, N>& weights,
+                             std::array<glm::vec4, 2>& endpoints) -> bool
+        {
+            f32 aa = 0, ab = 0, bb = 0;
+            glm::vec4 ax(0.0f), bx(0.0f);
+            for (u32 i = 0; i < BlockTexelCount; ++i)
+            {
+                const f32 b = static_cast<f32>(weights[indices[i]]) / 64.0f;
+                const f32 a = 1.0f - b;
+                aa += a * a;
+                ab += a * b;
+                bb += b * b;
+                ax += a * colors[i];
+                bx += b * colors[i];
+            }
+
+            const f32 determinant = aa * bb - ab * ab;
+            if (std::abs(determinant) < 1e-6f)
+                return false;
+
+            endpoints[0] = (ax * bb - bx * ab) / determinant;
+            endpoints[1] = (bx * aa - ax * ab) / determinant;
+            return true;
+        }
+
+        /**
+         * Swap the endpoints if needed for the first texel's index to have its top bit clear, as BC7 does not store it.
+         */
+        template <typename Endpoint>
+        void fixAnchorIndex(const u32 indexCount, Endpoint& endpoint0, Endpoint& endpoint1, BlockIndices& indices)
+        {
+            if (indices[0] < indexCount / 2)
+                return;
+
+            std::swap(endpoint0, endpoint1);
+            for (auto& index : indices)
+            {
+                index = indexCount - 1 - index;
+            }
+        }
+
+        /**
+         * Write the lowest bitCount bits of a value at a bit offset into a zeroed block, advancing the offset.
+         */
+        void writeBits(u8* out, u32& offset, const u32 value, const u32 bitCount)
+        {
+            for (u32 i = 0; i < bitCount; ++i, ++offset)
+            {
+                if (((value >> i) & 1) != 0)
+                    out[offset / 8] |= static_cast<u8>(1u << (offset % 8));
+            }
+        }
+
+        void writeBc7Indices(u8* out, u32& offset, const BlockIndices& indices, const u32 indexBits)
+        {
+            for (u32 i = 0; i < BlockTexelCount; ++i)
+            {
+                writeBits(out, offset, indices[i], i == 0 ? indexBits - 1 : indexBits);
+            }
+        }
+
+        /* BC7 mode 6 endpoint of 7bit channels, whose shared lowest bit (p-bit) makes them 8bit */
+        struct Bc7PBitEndpoint
+        {
+            glm::u8vec4 color;
+            u32 pBit;
+        };
+
+        /**
+         * @return Closest endpoint to the colour, with whichever p-bit gives it the least error.
+         */
+        auto quantizePBitEndpoint(const glm::vec4& color) -> Bc7PBitEndpoint
+        {
+            const auto clamped = glm::clamp(color, 0.0f, 255.0f);
+
+            Bc7PBitEndpoint bestEndpoint{};
+            f32 bestError = std::numeric_limits<f32>::max();
+            for (u32 pBit = 0; pBit < 2; ++pBit)
+            {
+                Bc7PBitEndpoint endpoint{ {}, pBit };
+                f32 error = 0.0f;
+                for (u32 c = 0; c < 4; ++c)
+                {
+                    const auto value = std::clamp(static_cast<i32>((clamped[c] - static_cast<f32>(pBit)) * 0.5f + 0.5f), 0, 127);
+                    endpoint.color[c] = static_cast<u8>(value);
+
+                    const f32 delta = static_cast<f32>((value << 1) | static_cast<i32>(pBit)) - clamped[c];
+                    error += delta * delta;
+                }
+                if (error < bestError)
+                {
+                    bestError = error;
+                    bestEndpoint = endpoint;
+                }
+            }
+            return bestEndpoint;
+        }
+
+        auto getPBitPalette(const Bc7PBitEndpoint& endpoint0, const Bc7PBitEndpoint& endpoint1) -> std::array<glm::vec4, 16>
+        {
+            std::array<glm::vec4, 16> palette{};
+            for (u32 i = 0; i < 16; ++i)
+            {
+                for (u32 c = 0; c < 4; ++c)
+                {
+                    const u32 value0 = (static_cast<u32>(endpoint0.color[c]) << 1) | endpoint0.pBit;
+                    const u32 value1 = (static_cast<u32>(endpoint1.color[c]) << 1) | endpoint1.pBit;
+                    palette[i][c] = interpolateBc7(value0, value1, Bc7Weights4[i]);
+                }
+            }
+            return palette;
+        }
+
+        /**
+         * BC7 mode 6, a single pair of RGBA endpoints with 16 steps between them. Suits alpha that changes with the colour.
+         * @return Squared error of the encoded block.
+         */
+        auto encodeBc7Mode6(const BlockColors& colors, u8* out) -> f32
+        {
+            auto endpoints = findPrincipalEndpoints(colors);
+            for (u32 iteration = 0; iteration < ColorRefineIterations; ++iteration)
+            {
+                f32 error = 0.0f;
+                const auto palette = getPBitPalette(quantizePBitEndpoint(endpoints[0]), quantizePBitEndpoint(endpoints[1]));
+                if (!refineEndpoints(colors, findNearestIndices(colors, palette, error), Bc7Weights4, endpoints))
+                    break;
+            }
+
+            auto endpoint0 = quantizePBitEndpoint(endpoints[0]);
+            auto endpoint1 = quantizePBitEndpoint(endpoints[1]);
+            f32 error = 0.0f;
+            auto indices = findNearestIndices(colors, getPBitPalette(endpoint0, endpoint1), error);
+            fixAnchorIndex(16, endpoint0, endpoint1, indices);
+
+            u32 offset = 0;
+            writeBits(out, offset, 1u << 6, 7);
+            for (u32 c = 0; c < 4; ++c)
+            {
+                writeBits(out, offset, endpoint0.color[c], 7);
+                writeBits(out, offset, endpoint1.color[c], 7);
+            }
+            writeBits(out, offset, endpoint0.pBit, 1);
+            writeBits(out, offset, endpoint1.pBit, 1);
+            writeBc7Indices(out, offset, indices, 4);
+            return error;
+        }
+
+        /**
+         * BC7 mode 5, RGB and alpha each with their own endpoints and 4 step indices. Suits alpha unrelated to the colour.
+         * @return Squared error of the encoded block.
+         */
+        auto encodeBc7Mode5(const BlockColors& colors, u8* out) -> f32
+        {
+            // Colour is fitted without alpha, 7bit endpoints expanded to 8bit by repeating their top bit
+            BlockColors rgbColors = colors;
+            for (auto& color : rgbColors)
+            {
+                color.a = 0.0f;
+            }
+
+            const auto quantizeColor = [](const glm::vec4& color)
+            {
+                const auto clamped = glm::clamp(glm::vec3(color), 0.0f, 255.0f);
+                return glm::u8vec3(clamped * (127.0f / 255.0f) + 0.5f);
+            };
+            const auto getColorPalette = [](const glm::u8vec3& color0, const glm::u8vec3& color1)
+            {
+                std::array<glm::vec4, 4> palette{};
+                for (u32 i = 0; i < 4; ++i)
+                {
+                    for (u32 c = 0; c < 3; ++c)
+                    {
+                        const u32 value0 = (static_cast<u32>(color0[c]) << 1) | (color0[c] >> 6);
+                        const u32 value1 = (static_cast<u32>(color1[c]) << 1) | (color1[c] >> 6);
+                        palette[i][c] = interpolateBc7(value0, value1, Bc7Weights2[i]);
+                    }
+                }
+                return palette;
+            };
+
+            auto endpoints = findPrincipalEndpoints(rgbColors);
+            for (u32 iteration = 0; iteration < ColorRefineIterations; ++iteration)
+            {
+                f32 error = 0.0f;
+                const auto palette = getColorPalette(quantizeColor(endpoints[0]), quantizeColor(endpoints[1]));
+                if (!refineEndpoints(rgbColors, findNearestIndices(rgbColors, palette, error), Bc7Weights2, endpoints))
+                    break;
+            }
+
+            auto color0 = quantizeColor(endpoints[0]);
+            auto color1 = quantizeColor(endpoints[1]);
+            f32 error = 0.0f;
+            auto colorIndices = findNearestIndices(rgbColors, getColorPalette(color0, color1), error);
+            fixAnchorIndex(4, color0, color1, colorIndices);
+
+            // Alpha endpoints are 8bit, so the block's extremes are exact
+            u8 alpha0 = 255;
+            u8 alpha1 = 0;
+            for (const auto& color : colors)
+            {
+                alpha0 = std::min(alpha0, static_cast<u8>(color.a));
+                alpha1 = std::max(alpha1, static_cast<u8>(color.a));
+            }
+
+            BlockColors alphas{};
+            std::array<glm::vec4, 4> alphaPalette{};
+            for (u32 i = 0; i < BlockTexelCount; ++i)
+            {
+                alphas[i].a = colors[i].a;
+            }
+            for (u32 i = 0; i < 4; ++i)
+            {
+                alphaPalette[i].a = interpolateBc7(alpha0, alpha1, Bc7Weights2[i]);
+            }
+            auto alphaIndices = findNearestIndices(alphas, alphaPalette, error);
+            fixAnchorIndex(4, alpha0, alpha1, alphaIndices);
+
+            u32 offset = 0;
+            writeBits(out, offset, 1u << 5, 6);
+            writeBits(out, offset, 0, 2);  // No channel rotation
+            for (u32 c = 0; c < 3; ++c)
+            {
+                writeBits(out, offset, color0[c], 7);
+                writeBits(out, offset, color1[c], 7);
+            }
+            writeBits(out, offset, alpha0, 8);
+            writeBits(out, offset, alpha1, 8);
+            writeBc7Indices(out, offset, colorIndices, 2);
+            writeBc7Indices(out, offset, alphaIndices, 2);
+            return error;
+        }
+
+        /**
+         * BC7 block in whichever of modes 5 and 6 reproduces it with less error. Both use the whole block as one subset.
+         */
+        void encodeBc7Block(const Block& block, u8* out)
+        {
+            BlockColors colors{};
+            for (u32 i = 0; i < BlockTexelCount; ++i)
+            {
+                colors[i] = glm::vec4(block[i]);
+            }
+
+            std::array<u8, 16> mode5Block{};
+            std::fill_n(out, 16, u8(0));
+            if (encodeBc7Mode5(colors, mode5Block.data()) < encodeBc7Mode6(colors, out))
+                std::copy(mode5Block.begin(), mode5Block.end(), out);
+        }
+
+        void encodeBlock(const Block& block, const TextureFormat format, u8* out)
+        {
+            switch (format)
+            {
+                case TextureFormat::eBC1: encodeColorBlock(block, out); break;
+                case TextureFormat::eBC3:
+                    encodeChannelBlock(block, 3, out);
+                    encodeColorBlock(block, out + 8);
+                    break;
+                case TextureFormat::eBC4: encodeChannelBlock(block, 0, out); break;
+                case TextureFormat::eBC5:
+                    encodeChannelBlock(block, 0, out);
+                    encodeChannelBlock(block, 1, out + 8);
+                    break;
+                case TextureFormat::eBC7: encodeBc7Block(block, out); break;
+                default: break;
+            }
+        }
+
+        void encodeBlockRow(const u8* pixels,
+                            const u32 width,
+                            const u32 height,
+                            const u32 channels,
+                            const TextureFormat format,
+                            const u32 blockY,
+                            u8* out)
+        {
+            const size blockSize = getTextureDataSize(format, 4, 4);
+            for (u32 blockX = 0; blockX * 4 < width; ++blockX)
+            {
+                encodeBlock(fetchBlock(pixels, width, height, channels, blockX, blockY), format, out + blockX * blockSize);
+            }
+        }
+    }
+
+    auto TextureCompress::chooseFormat(const TextureUsage usage, const u8* pixels, const u32 width, const u32 height, const u32 channels)
+        -> TextureFormat
+    {
+        switch (usage)
+        {
+            case TextureUsage::eNormal: return TextureFormat::eBC5;
+            case TextureUsage::eMask: return TextureFormat::eBC4;
+            case TextureUsage::eColor: break;
+        }
+
+        // Alpha only needs keeping if it is used
+        if (channels == 2 || channels == 4)
+        {
+            const size texelCount = static_cast<size>(width) * height;
+            for (size i = 0; i < texelCount; ++i)
+            {
+                if (pixels[i * channels + channels - 1] != 255)
+                    return TextureFormat::eBC7;
+            }
+        }
+        return TextureFormat::eBC1;
+    }
+
+    auto TextureCompress::compress(const u8* pixels,
+                                   const u32 width,
+                                   const u32 height,
+                                   const u32 channels,
+                                   const TextureFormat format,
+                                   ThreadPool& threadPool) -> std::vector<u8>
+    {
+        std::vector<u8> blocks(getTextureDataSize(format, width, height));
+        const size rowSize = getTextureDataSize(format, width, 4);
+
+        const u32 blockRowCount = (height + 3) / 4;
+        threadPool.parallelFor(blockRowCount,
+                               [&](const u32 blockY)
+                               { encodeBlockRow(pixels, width, height, channels, format, blockY, &blocks[blockY * rowSize]); });
+        return blocks;
+    }
+}
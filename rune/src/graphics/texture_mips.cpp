@@ -0,0 +1,223 @@
+// # Copyright  Stuart Millman <stu.millman15@gmail.com>
+
+#include "pch.hpp"
+#include "rune/graphics/texture_mips.hpp"
+
+#include "rune/utility/thread_pool.hpp"
+
+#include <array>
+#include <cmath>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+    #define RUNE_MIPS_SSE 1
+    #include <emmintrin.h>
+#endif
+
+namespace Rune
+{
+    namespace
+    {
+        /* Texels are filtered as 4 floats, whatever their channel count */
+        constexpr u32 FilterChannels = 4;
+
+        constexpr u32 LinearToSrgbTableSize = 4096;
+
+        struct ConversionTables
+        {
+            std::array<f32, 256> srgbToLinear;
+            std::array<u8, LinearToSrgbTableSize> linearToSrgb;
+        };
+
+        auto getConversionTables() -> const ConversionTables&
+        {
+            static const ConversionTables tables = []
+            {
+                ConversionTables newTables{};
+                for (u32 i = 0; i < 256; ++i)
+                {
+                    const f32 srgb = static_cast<f32>(i) / 255.0f;
+                    newTables.srgbToLinear[i] = srgb <= 0.04045f ? srgb / 12.92f : std::pow((srgb + 0.055f) / 1.055f, 2.4f);
+                }
+                for (u32 i = 0; i < LinearToSrgbTableSize; ++i)
+                {
+                    const f32 linear = static_cast<f32>(i) / static_cast<f32>(LinearToSrgbTableSize - 1);
+                    const f32 srgb = linear <= 0.0031308f ? linear * 12.92f : 1.055f * std::pow(linear, 1.0f / 2.4f) - 0.055f;
+                    newTables.linearToSrgb[i] = static_cast<u8>(srgb * 255.0f + 0.5f);
+                }
+                return newTables;
+            }();
+            return tables;
+        }
+
+        /**
+         * @return Number of channels holding colour or normal xyz, the rest are alpha.
+         */
+        auto getVectorChannelCount(const u32 channels) -> u32
+        {
+            return channels >= 3 ? 3 : 1;
+        }
+
+        auto toUnorm8(const f32 value) -> u8
+        {
+            return static_cast<u8>(std::clamp(value, 0.0f, 1.0f) * 255.0f + 0.5f);
+        }
+
+        /**
+         * Convert a row of 8bit texels to the space they are filtered in: linear colour, or normals in [-1, 1].
+         */
+        void decodeRow(const u8* texels, const u32 width, const u32 channels, const TextureUsage usage, f32* out)
+        {
+            const auto& tables = getConversionTables();
+            const u32 vectorChannels = getVectorChannelCount(channels);
+
+            for (u32 x = 0; x < width; ++x)
+            {
+                const u8* texel = &texels[static_cast<size>(x) * channels];
+                f32* decoded = &out[static_cast<size>(x) * FilterChannels];
+                for (u32 c = 0; c < FilterChannels; ++c)
+                {
+                    if (c >= channels)
+                        decoded[c] = 0.0f;
+                    else if (c < vectorChannels && usage == TextureUsage::eColor)
+                        decoded[c] = tables.srgbToLinear[texel[c]];
+                    else if (c < vectorChannels && usage == TextureUsage::eNormal)
+                        decoded[c] = static_cast<f32>(texel[c]) / 127.5f - 1.0f;
+                    else
+                        decoded[c] = static_cast<f32>(texel[c]) / 255.0f;
+                }
+            }
+        }
+
+        void encodeRow(f32* filtered, const u32 width, const u32 channels, const TextureUsage usage, u8* out)
+        {
+            const auto& tables = getConversionTables();
+            const u32 vectorChannels = getVectorChannelCount(channels);
+
+            for (u32 x = 0; x < width; ++x)
+            {
+                f32* texel = &filtered[static_cast<size>(x) * FilterChannels];
+                u8* encoded = &out[static_cast<size>(x) * channels];
+
+                // Averaging shortens normals, most where they disagree
+                if (usage == TextureUsage::eNormal && vectorChannels == 3)
+                {
+                    const f32 length = std::sqrt(texel[0] * texel[0] + texel[1] * texel[1] + texel[2] * texel[2]);
+                    if (length > 0.0f)
+                    {
+                        texel[0] /= length;
+                        texel[1] /= length;
+                        texel[2] /= length;
+                    }
+                }
+
+                for (u32 c = 0; c < channels; ++c)
+                {
+                    if (c < vectorChannels && usage == TextureUsage::eColor)
+                    {
+                        const auto index = static_cast<u32>(std::clamp(texel[c], 0.0f, 1.0f) * (LinearToSrgbTableSize - 1) + 0.5f);
+                        encoded[c] = tables.linearToSrgb[index];
+                    }
+                    else if (c < vectorChannels && usage == TextureUsage::eNormal)
+                        encoded[c] = toUnorm8(texel[c] * 0.5f + 0.5f);
+                    else
+                        encoded[c] = toUnorm8(texel[c]);
+                }
+            }
+        }
+
+        /**
+         * Add a decoded row into the accumulated rows, a whole texel at a time.
+         */
+        void accumulateRow(const f32* row, const u32 width, f32* accumulated)
+        {
+            for (size i = 0; i < static_cast<size>(width) * FilterChannels; i += FilterChannels)
+            {
+#if RUNE_MIPS_SSE
+                _mm_storeu_ps(&accumulated[i], _mm_add_ps(_mm_loadu_ps(&accumulated[i]), _mm_loadu_ps(&row[i])));
+#else
+                for (u32 c = 0; c < FilterChannels; ++c)
+                    accumulated[i + c] += row[i + c];
+#endif
+            }
+        }
+
+        /**
+         * Box filter accumulated rows horizontally. The last texel also covers the last column of odd widths.
+         */
+        void filterRow(const f32* accumulated, const u32 srcWidth, const u32 dstWidth, const f32 rowWeight, f32* out)
+        {
+            for (u32 x = 0; x < dstWidth; ++x)
+            {
+                const u32 first = std::min(x * 2, srcWidth - 1);
+                const u32 end = x + 1 == dstWidth ? srcWidth : std::min(x * 2 + 2, srcWidth);
+                const f32 weight = rowWeight / static_cast<f32>(end - first);
+
+#if RUNE_MIPS_SSE
+                __m128 sum = _mm_loadu_ps(&accumulated[static_cast<size>(first) * FilterChannels]);
+                for (u32 column = first + 1; column < end; ++column)
+                {
+                    sum = _mm_add_ps(sum, _mm_loadu_ps(&accumulated[static_cast<size>(column) * FilterChannels]));
+                }
+                _mm_storeu_ps(&out[static_cast<size>(x) * FilterChannels], _mm_mul_ps(sum, _mm_set1_ps(weight)));
+#else
+                for (u32 c = 0; c < FilterChannels; ++c)
+                {
+                    f32 sum = 0.0f;
+                    for (u32 column = first; column < end; ++column)
+                        sum += accumulated[static_cast<size>(column) * FilterChannels + c];
+                    out[static_cast<size>(x) * FilterChannels + c] = sum * weight;
+                }
+#endif
+            }
+        }
+
+        struct Level
+        {
+            const u8* texels;
+            u32 width;
+            u32 height;
+        };
+
+        void downsampleRow(const Level& src, const Level& dst, const u32 channels, const TextureUsage usage, const u32 dstY, u8* out)
+        {
+            const u32 firstRow = std::min(dstY * 2, src.height - 1);
+            const u32 endRow = dstY + 1 == dst.height ? src.height : std::min(dstY * 2 + 2, src.height);
+
+            std::vector<f32> decoded(static_cast<size>(src.width) * FilterChannels);
+            std::vector<f32> accumulated(static_cast<size>(src.width) * FilterChannels, 0.0f);
+            for (u32 row = firstRow; row < endRow; ++row)
+            {
+                decodeRow(&src.texels[static_cast<size>(row) * src.width * channels], src.width, channels, usage, decoded.data());
+                accumulateRow(decoded.data(), src.width, accumulated.data());
+            }
+
+            std::vector<f32> filtered(static_cast<size>(dst.width) * FilterChannels);
+            filterRow(accumulated.data(), src.width, dst.width, 1.0f / static_cast<f32>(endRow - firstRow), filtered.data());
+            encodeRow(filtered.data(), dst.width, channels, usage, out);
+        }
+    }
+
+    auto TextureMips::generate(
+        const u8* pixels, const u32 width, const u32 height, const u32 channels, const TextureUsage usage, ThreadPool& threadPool)
+        -> std::vector<std::vector<u8>>
+    {
+        const u32 levelCount = getMipLevelCount(width, height);
+
+        // Each level is filtered from the one above, so they must not move while the chain is built
+        std::vector<std::vector<u8>> levels;
+        levels.reserve(levelCount - 1);
+
+        Level src{ pixels, width, height };
+        for (u32 level = 1; level < levelCount; ++level)
+        {
+            const Level dst{ nullptr, getMipLevelSize(width, level), getMipLevelSize(height, level) };
+            auto& texels = levels.emplace_back(static_cast<size>(dst.width) * dst.height * channels);
+
+            const size rowSize = static_cast<size>(dst.width) * channels;
+            threadPool.parallelFor(dst.height, [&](const u32 y) { downsampleRow(src, dst, channels, usage, y, &texels[y * rowSize]); });
+
+            src = { texels.data(), dst.width, dst.height };
+        }
+        return levels;
+    }
+}
@@ -0,0 +1,317 @@
+// # Copyright  Stuart Millman <stu.millman15@gmail.com>
+
+#include "pch.hpp"
+#include "rune/graphics/texture_streamer.hpp"
+
+#include "rune/graphics/texture.hpp"
+#include "rune/graphics/texture_cache.hpp"
+#include "rune/graphics/texture_compress.hpp"
+#include "rune/graphics/material.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <functional>
+#include <iterator>
+
+namespace Rune
+{
+    TextureStreamer::~TextureStreamer()
+    {
+        cleanup();
+    }
+
+    auto TextureStreamer::getSettings() const -> const TextureStreamingSettings&
+    {
+        return m_settings;
+    }
+
+    void TextureStreamer::setSettings(const TextureStreamingSettings& settings)
+    {
+        m_settings = settings;
+    }
+
+    auto TextureStreamer::getInitialResidentMip(const u32 width, const u32 height, const u32 mipCount) const -> u32
+    {
+        if (!m_settings.enabled)
+            return 0;
+
+        u32 mip = 0;
+        while (mip + 1 < mipCount && std::max(getMipLevelSize(width, mip), getMipLevelSize(height, mip)) > m_settings.residentSize)
+            ++mip;
+        return mip;
+    }
+
+    void TextureStreamer::add(Texture* texture)
+    {
+        m_textures.push_back(texture);
+    }
+
+    void TextureStreamer::remove(Texture* texture)
+    {
+        std::erase(m_textures, texture);
+
+        std::lock_guard lock(m_importMutex);
+        std::erase_if(m_importJobs, [texture](const TextureImportJob& job) { return job.texture == texture; });
+        std::erase_if(m_importedMips, [texture](const ImportedMip& importedMip) { return importedMip.texture == texture; });
+        if (m_currentImport == texture)
+            m_isCurrentImportCancelled = true;
+    }
+
+    void TextureStreamer::addImport(TextureImportJob job)
+    {
+        {
+            std::lock_guard lock(m_importMutex);
+            m_importJobs.push_back(std::move(job));
+            m_isImportStopping = false;
+        }
+        m_importWakeCondition.notify_one();
+
+        if (!m_importThread.joinable())
+            m_importThread = std::thread(&TextureStreamer::importLoop, this);
+    }
+
+    void TextureStreamer::waitForImport(const Texture* texture)
+    {
+        {
+            std::unique_lock lock(m_importMutex);
+            m_importDoneCondition.wait(lock,
+                                       [this, texture]
+                                       {
+                                           return m_currentImport != texture &&
+                                                  std::none_of(m_importJobs.begin(),
+                                                               m_importJobs.end(),
+                                                               [texture](const TextureImportJob& job) { return job.texture == texture; });
+                                       });
+        }
+        handOverImportedMips(texture);
+    }
+
+    void TextureStreamer::cleanup()
+    {
+        {
+            std::lock_guard lock(m_importMutex);
+            m_isImportStopping = true;
+            m_importJobs.clear();
+        }
+        m_importWakeCondition.notify_all();
+
+        if (m_importThread.joinable())
+            m_importThread.join();
+        m_importedMips.clear();
+    }
+
+    void TextureStreamer::markUsed(const MaterialInst& materialInst, const u64 frameIndex)
+    {
+        for (const auto& slot : materialInst.getTextureSlots())
+        {
+            if (slot.texture != nullptr && !slot.isArray)
+                slot.texture->setLastUsedFrame(frameIndex);
+        }
+    }
+
+    void TextureStreamer::update()
+    {
+        m_lastFrameCounts = {};
+
+        handOverImportedMips(nullptr);
+
+        if (!m_settings.enabled)
+        {
+            for (auto* texture : m_textures)
+            {
+                while (texture->streamInMip() > 0)
+                    ++m_lastFrameCounts.mipsStreamed;
+                texture->applyResidentMip();
+                texture->clearRequestedMip();
+                m_lastFrameCounts.residentDataSize += texture->getResidentDataSize();
+            }
+            return;
+        }
+
+        m_residentDataSize = 0;
+        m_evictionCandidates.clear();
+        m_nextEvictionCandidate = 0;
+        for (auto* texture : m_textures)
+        {
+            m_residentDataSize += texture->getResidentDataSize();
+            if (texture->getResidentMip() < getKeptMip(*texture))
+                m_evictionCandidates.push_back(texture);
+        }
+
+        std::sort(m_evictionCandidates.begin(),
+                  m_evictionCandidates.end(),
+                  [](const Texture* a, const Texture* b) { return a->getLastUsedFrame() < b->getLastUsedFrame(); });
+
+        m_pendingTextures.clear();
+        for (auto* texture : m_textures)
+        {
+            if (getTargetMip(*texture) < texture->getResidentMip())
+                m_pendingTextures.push_back(texture);
+        }
+
+        // Furthest from what was requested first, as those look worst on screen
+        std::sort(m_pendingTextures.begin(),
+                  m_pendingTextures.end(),
+                  [](const Texture* a, const Texture* b)
+                  { return a->getResidentMip() - getTargetMip(*a) > b->getResidentMip() - getTargetMip(*b); });
+
+        // One level per texture per pass, so the budget is shared rather than spent on bringing one texture to full detail.
+        // At least one mip is uploaded each frame, even if it alone is over budget.
+        size bytesUploaded = 0;
+        bool hasPending = true;
+        while (hasPending && bytesUploaded < m_settings.uploadBudget)
+        {
+            hasPending = false;
+            for (auto* texture : m_pendingTextures)
+            {
+                if (bytesUploaded >= m_settings.uploadBudget)
+                    break;
+                if (getTargetMip(*texture) >= texture->getResidentMip())
+                    continue;
+
+                const u32 mip = texture->getResidentMip() - 1;
+                if (m_settings.memoryBudget > 0)
+                {
+                    const size mipDataSize = texture->getMipDataSize(mip);
+                    if (mipDataSize > m_settings.memoryBudget || !evictUntil(m_settings.memoryBudget - mipDataSize))
+                        continue;
+                }
+
+                if (mip >= texture->getFinestLoadedMip())
+                    ++m_lastFrameCounts.mipsReloaded;
+
+                const size uploadedSize = texture->streamInMip();
+                bytesUploaded += uploadedSize;
+                m_residentDataSize += uploadedSize;
+                ++m_lastFrameCounts.mipsStreamed;
+                hasPending |= getTargetMip(*texture) < texture->getResidentMip();
+            }
+        }
+
+        // The budget may have been lowered, or textures added over it
+        if (m_settings.memoryBudget > 0)
+            evictUntil(m_settings.memoryBudget);
+
+        for (auto* texture : m_pendingTextures)
+        {
+            if (texture->getRequestedMip() < texture->getResidentMip())
+                ++m_lastFrameCounts.texturesPending;
+        }
+
+        // Each texture changed by this frame's uploads and evictions is reallocated once, for its final resident mip
+        for (auto* texture : m_textures)
+        {
+            texture->applyResidentMip();
+            texture->clearRequestedMip();
+        }
+        m_lastFrameCounts.residentDataSize = m_residentDataSize;
+    }
+
+    auto TextureStreamer::getLastFrameCounts() const -> const FrameCounts&
+    {
+        return m_lastFrameCounts;
+    }
+
+    void TextureStreamer::importLoop()
+    {
+        while (true)
+        {
+            TextureImportJob job;
+            {
+                std::unique_lock lock(m_importMutex);
+                m_importWakeCondition.wait(lock, [this] { return m_isImportStopping || !m_importJobs.empty(); });
+                if (m_isImportStopping)
+                    return;
+
+                job = std::move(m_importJobs.front());
+                m_importJobs.pop_front();
+                m_currentImport = job.texture;
+                m_isCurrentImportCancelled = false;
+            }
+
+            importMips(job);
+
+            {
+                std::lock_guard lock(m_importMutex);
+                m_currentImport = nullptr;
+            }
+            m_importDoneCondition.notify_all();
+        }
+    }
+
+    void TextureStreamer::importMips(const TextureImportJob& job)
+    {
+        const size importedOffset = getMipChainDataSize(job.format, job.width, job.height, job.importedMip);
+        std::vector<u8> chainData(importedOffset);
+        chainData.insert(chainData.end(), job.importedData.begin(), job.importedData.end());
+
+        // Coarsest first, so the texture can stream each in as soon as it is ready
+        for (u32 mip = job.importedMip; mip-- > 0;)
+        {
+            const u8* pixels = mip == 0 ? job.pixels.data() : job.mipPixels[mip - 1].data();
+            auto blocks = TextureCompress::compress(pixels,
+                                                    getMipLevelSize(job.width, mip),
+                                                    getMipLevelSize(job.height, mip),
+                                                    job.channels,
+                                                    job.format,
+                                                    m_importThreadPool);
+
+            const size dataOffset = getMipChainDataSize(job.format, job.width, job.height, mip);
+            std::memcpy(&chainData[dataOffset], blocks.data(), blocks.size());
+
+            std::lock_guard lock(m_importMutex);
+            if (m_isCurrentImportCancelled || m_isImportStopping)
+                return;
+            m_importedMips.push_back({ job.texture, mip, std::move(blocks) });
+        }
+
+        TextureCache::save(job.cacheFilename, job.sourceHash, { job.width, job.height, job.format, job.mipCount, std::move(chainData) });
+    }
+
+    void TextureStreamer::handOverImportedMips(const Texture* texture)
+    {
+        std::vector<ImportedMip> importedMips;
+        {
+            std::lock_guard lock(m_importMutex);
+            const auto handOver = [texture](const ImportedMip& importedMip)
+            { return texture == nullptr || importedMip.texture == texture; };
+            const auto kept = std::stable_partition(m_importedMips.begin(), m_importedMips.end(), std::not_fn(handOver));
+            std::move(kept, m_importedMips.end(), std::back_inserter(importedMips));
+            m_importedMips.erase(kept, m_importedMips.end());
+        }
+
+        // Pushed in the order they were encoded, so each texture gets its mips coarsest first
+        for (auto& importedMip : importedMips)
+            importedMip.texture->setImportedMip(importedMip.mip, importedMip.data);
+    }
+
+    auto TextureStreamer::getTargetMip(const Texture& texture) -> u32
+    {
+        return std::max(texture.getRequestedMip(), texture.getImportedMip());
+    }
+
+    auto TextureStreamer::getKeptMip(const Texture& texture) const -> u32
+    {
+        const u32 initialMip =
+            getInitialResidentMip(static_cast<u32>(texture.getWidth()), static_cast<u32>(texture.getHeight()), texture.getMipCount());
+        return std::min(initialMip, texture.getRequestedMip());
+    }
+
+    bool TextureStreamer::evictUntil(const size targetSize)
+    {
+        // Each texture is evicted down to what it must keep before moving on to the next least recently used
+        while (m_residentDataSize > targetSize && m_nextEvictionCandidate < m_evictionCandidates.size())
+        {
+            auto* texture = m_evictionCandidates[m_nextEvictionCandidate];
+            if (texture->getResidentMip() >= getKeptMip(*texture))
+            {
+                ++m_nextEvictionCandidate;
+                continue;
+            }
+
+            m_residentDataSize -= texture->evictMip();
+            ++m_lastFrameCounts.mipsEvicted;
+        }
+        return m_residentDataSize <= targetSize;
+    }
+}
@@ -0,0 +1,124 @@
+// # Copyright  Stuart Millman <stu.millman15@gmail.com>
+
+#include "pch.hpp"
+#include "rune/graphics/vertex_quantize.hpp"
+
+#include <glm/common.hpp>
+#include <glm/geometric.hpp>
+#include <glm/gtc/packing.hpp>
+
+#include <algorithm>
+#include <limits>
+
+namespace Rune
+{
+    namespace
+    {
+        auto signNotZero(const glm::vec2& v) -> glm::vec2
+        {
+            return { v.x >= 0.0f ? 1.0f : -1.0f, v.y >= 0.0f ? 1.0f : -1.0f };
+        }
+
+        /**
+         * Map the unit sphere onto an octahedron, then fold its lower half over the upper (Cigolle et al. 2014).
+         */
+        auto encodeOctahedral(const glm::vec3& normal) -> glm::vec2
+        {
+            const f32 length = std::abs(normal.x) + std::abs(normal.y) + std::abs(normal.z);
+            if (length <= 0.0f)
+                return glm::vec2(0.0f);
+
+            glm::vec2 encoded = glm::vec2(normal) / length;
+            if (normal.z < 0.0f)
+                encoded = (1.0f - glm::abs(glm::vec2(encoded.y, encoded.x))) * signNotZero(encoded);
+            return encoded;
+        }
+
+        auto decodeOctahedral(const glm::vec2& encoded) -> glm::vec3
+        {
+            glm::vec3 normal(encoded, 1.0f - std::abs(encoded.x) - std::abs(encoded.y));
+            const f32 fold = std::max(-normal.z, 0.0f);
+            normal.x += normal.x >= 0.0f ? -fold : fold;
+            normal.y += normal.y >= 0.0f ? -fold : fold;
+            return glm::normalize(normal);
+        }
+    }
+
+    auto VertexQuantize::computeEncoding(const std::vector<Vertex>& vertices) -> VertexEncoding
+    {
+        VertexEncoding encoding{};
+        encoding.format = VertexFormat::eQuantized;
+        if (vertices.empty())
+            return encoding;
+
+        glm::vec3 min(std::numeric_limits<f32>::max());
+        glm::vec3 max(std::numeric_limits<f32>::lowest());
+        for (const auto& vertex : vertices)
+        {
+            min = glm::min(min, vertex.pos);
+            max = glm::max(max, vertex.pos);
+        }
+
+        encoding.positionOffset = min;
+        encoding.positionScale = max - min;
+        return encoding;
+    }
+
+    auto VertexQuantize::encode(const Vertex& vertex, const VertexEncoding& encoding) -> QuantizedVertex
+    {
+        QuantizedVertex quantized{};
+        for (i32 axis = 0; axis < 3; ++axis)
+        {
+            const f32 scale = encoding.positionScale[axis];
+            const f32 normalized = scale > 0.0f ? (vertex.pos[axis] - encoding.positionOffset[axis]) / scale : 0.0f;
+            quantized.pos[axis] = glm::packUnorm1x16(normalized);
+        }
+
+        quantized.uv[0] = glm::packHalf1x16(vertex.uv.x);
+        quantized.uv[1] = glm::packHalf1x16(vertex.uv.y);
+
+        const auto normal = encodeOctahedral(vertex.norm);
+        quantized.norm[0] = static_cast<i16>(glm::packSnorm1x16(normal.x));
+        quantized.norm[1] = static_cast<i16>(glm::packSnorm1x16(normal.y));
+        return quantized;
+    }
+
+    auto VertexQuantize::decode(const QuantizedVertex& vertex, const VertexEncoding& encoding) -> Vertex
+    {
+        Vertex decoded{};
+        for (i32 axis = 0; axis < 3; ++axis)
+        {
+            decoded.pos[axis] = encoding.positionOffset[axis] + glm::unpackUnorm1x16(vertex.pos[axis]) * encoding.positionScale[axis];
+        }
+
+        decoded.uv = { glm::unpackHalf1x16(vertex.uv[0]), glm::unpackHalf1x16(vertex.uv[1]) };
+
+        const glm::vec2 normal(glm::unpackSnorm1x16(static_cast<u16>(vertex.norm[0])),
+                               glm::unpackSnorm1x16(static_cast<u16>(vertex.norm[1])));
+        decoded.norm = decodeOctahedral(normal);
+        return decoded;
+    }
+
+    auto VertexQuantize::measureError(const std::vector<Vertex>& vertices, const VertexEncoding& encoding) -> QuantizationError
+    {
+        QuantizationError error{};
+        for (const auto& vertex : vertices)
+        {
+            const auto decoded = decode(encode(vertex, encoding), encoding);
+
+            const auto positionError = glm::abs(decoded.pos - vertex.pos);
+            error.position = std::max({ error.position, positionError.x, positionError.y, positionError.z });
+
+            const auto uvError = glm::abs(decoded.uv - vertex.uv);
+            error.uv = std::max({ error.uv, uvError.x, uvError.y });
+
+            const f32 normalLength = glm::length(vertex.norm);
+            if (normalLength > 0.0f)
+            {
+                const f32 cosAngle = std::clamp(glm::dot(decoded.norm, vertex.norm / normalLength), -1.0f, 1.0f);
+                error.normal = std::max(error.normal, std::acos(cosAngle));
+            }
+        }
+        return error;
+    }
+}
@@ -25,6 +25,7 @@
 #include <glm/ext/matrix_float4x4.hpp>
 #include <glm/ext/matrix_transform.hpp>
 
+#include <chrono>
 #include <filesystem>
 
 namespace Rune
@@ -33,6 +34,9 @@ namespace Rune
     {
         bool s_shouldStop = false;
 
+        /* When above zero, the game runs this many frames without a window using the null renderer, then exits */
+        i64 s_headlessFrames = 0;
+
         // Static engine systems
         // static WindowSystem s_windowSystem;
         // InputSystem& s_inputSystem = InputSystem::getInstance();
@@ -56,6 +60,61 @@ namespace Rune
         glm::vec3 cameraRot = { 0.0f, 0.0f, 0 };
         glm::mat4 viewMatrix;
 
+        void runHeadless(Game& game)
+        {
+            using Clock = std::chrono::high_resolution_clock;
+            using Milliseconds = std::chrono::duration<f64, std::milli>;
+
+            Milliseconds sysUpdateTime{};
+            Milliseconds updateTime{};
+            Milliseconds renderTime{};
+            f64 sortTime = 0.0;
+            f64 submitTime = 0.0;
+            u64 drawCalls = 0;
+            u64 triangles = 0;
+            u64 bytesUploaded = 0;
+
+            auto& graphics = GraphicsSystem::getInstance();
+
+            i64 frameCount = 0;
+            for (; frameCount < s_headlessFrames && !s_shouldStop; ++frameCount)
+            {
+                const auto sysUpdateStart = Clock::now();
+                game.sysUpdate();
+                const auto updateStart = Clock::now();
+                game.update();
+                const auto renderStart = Clock::now();
+                graphics.render();
+                const auto frameEnd = Clock::now();
+
+                sysUpdateTime += updateStart - sysUpdateStart;
+                updateTime += renderStart - updateStart;
+                renderTime += frameEnd - renderStart;
+                const auto& stats = graphics.getLastFrameStats();
+                sortTime += stats.sortTime;
+                submitTime += stats.submitTime;
+                drawCalls += stats.drawCalls;
+                triangles += stats.triangles;
+                bytesUploaded += stats.bytesUploaded;
+            }
+
+            if (frameCount == 0)
+                return;
+
+            const auto frames = static_cast<f64>(frameCount);
+            CORE_LOG_INFO("[Headless] Ran {} frames. Per frame: engine update {:.3f}ms, game update {:.3f}ms, render {:.3f}ms",
+                          frameCount,
+                          sysUpdateTime.count() / frames,
+                          updateTime.count() / frames,
+                          renderTime.count() / frames);
+            CORE_LOG_INFO("[Headless] Per frame: sort {:.3f}ms, submit {:.3f}ms, {:.1f} draws, {:.0f} triangles, {:.0f} bytes uploaded",
+                          sortTime / frames,
+                          submitTime / frames,
+                          drawCalls / frames,
+                          triangles / frames,
+                          bytesUploaded / frames);
+        }
+
     }  // namespace
 
     void Game::sysInit()
@@ -84,17 +143,62 @@ namespace Rune
         if (windowVSync)
             props.windowMode = static_cast<WindowMode>(windowMode->getInt());
 
+        auto headlessFrames = configInst.get("benchmark.headless_frames");
+        if (headlessFrames)
+            s_headlessFrames = headlessFrames->getInt();
+
         auto& windowInst = WindowSystem::getInstance();
         windowInst.init();
-        windowInst.createWindow(props);
+        if (s_headlessFrames <= 0)
+            windowInst.createWindow(props);
 
         auto& inputInst = InputSystem::getInstance();
         inputInst.init({ props.width, props.height });
 
         // TODO: Get rendering settings from config
         auto& graphicsInst = GraphicsSystem::getInstance();
-        graphicsInst.init(RenderingApi::eOpenGL);
+        graphicsInst.init(s_headlessFrames > 0 ? RenderingApi::eNull : RenderingApi::eOpenGL);
         graphicsInst.setWindow(&WindowSystem::getInstance());
+        auto multiDrawIndirect = configInst.get("rendering.multi_draw_indirect");
+        if (multiDrawIndirect)
+            graphicsInst.setMultiDrawIndirectEnabled(multiDrawIndirect->getInt());
+        if (auto programCacheDir = configInst.get("rendering.program_cache_dir"))
+            graphicsInst.getRenderer()->setProgramCacheDirectory(programCacheDir->getString());
+
+        ShadowSettings shadowSettings{};
+        if (auto shadowsEnabled = configInst.get("shadows.enabled"))
+            shadowSettings.enabled = shadowsEnabled->getInt();
+        if (auto cascadeResolution = configInst.get("shadows.cascade_resolution"))
+            shadowSettings.cascadeResolution = static_cast<u32>(cascadeResolution->getInt());
+        if (auto pointResolution = configInst.get("shadows.point_resolution"))
+            shadowSettings.pointResolution = static_cast<u32>(pointResolution->getInt());
+        if (auto shadowDistance = configInst.get("shadows.distance"))
+            shadowSettings.distance = static_cast<f32>(shadowDistance->getDouble());
+        graphicsInst.setShadowSettings(shadowSettings);
+
+        LodSettings lodSettings{};
+        if (auto lodEnabled = configInst.get("lod.enabled"))
+            lodSettings.enabled = lodEnabled->getInt();
+        if (auto maxPixelError = configInst.get("lod.max_pixel_error"))
+            lodSettings.maxPixelError = static_cast<f32>(maxPixelError->getDouble());
+        if (auto hysteresis = configInst.get("lod.hysteresis"))
+            lodSettings.hysteresis = static_cast<f32>(hysteresis->getDouble());
+        graphicsInst.setLodSettings(lodSettings);
+
+        TextureStreamingSettings streamingSettings{};
+        if (auto streamingEnabled = configInst.get("texture_streaming.enabled"))
+            streamingSettings.enabled = streamingEnabled->getInt();
+        if (auto residentSize = configInst.get("texture_streaming.resident_size"))
+            streamingSettings.residentSize = static_cast<u32>(residentSize->getInt());
+        if (auto uploadBudget = configInst.get("texture_streaming.upload_budget_kb"))
+            streamingSettings.uploadBudget = static_cast<size>(uploadBudget->getInt()) * 1024;
+        if (auto memoryBudget = configInst.get("texture_streaming.memory_budget_mb"))
+            streamingSettings.memoryBudget = static_cast<size>(memoryBudget->getInt()) * 1024 * 1024;
+        graphicsInst.getTextureStreamer().setSettings(streamingSettings);
+
+        auto renderStatsFile = configInst.get("benchmark.render_stats_file");
+        if (renderStatsFile && !renderStatsFile->getString().empty())
+            graphicsInst.startStatsCapture(renderStatsFile->getString());
 
         ScriptEngine::getInstance().init();
         AssetRegistry::getInstance().init();
@@ -120,6 +224,7 @@ namespace Rune
             auto matHandle = assetRegistry.add("mat_flat_color", CreateOwned<Material>());
             auto mat = assetRegistry.get<Material>(matHandle);
             mat->setShader(flatColorShader);
+            mat->setFloat("u_material.shininess", 32);
 
             surfaceMaterial = mat->createInstance();
             surfaceMaterial->setFloat4("u_material.diffuse", { 0.47f, 0.46f, 0.82f, 0.0f });
@@ -149,7 +254,12 @@ namespace Rune
         material = assetRegistry.get<Material>(matHandle);
         material->setShader(shader);
 
+        material->getDefaultInstance()->setFloat3("u_material.diffuse", { 1, 1, 1 });
+        material->getDefaultInstance()->setFloat("u_material.shininess", 32);
         material->getDefaultInstance()->setTexture("tex", texture);
+        // The shader samples its texture from an array, by the layer in the instance data. Arrays need every mip up front.
+        GraphicsSystem::getInstance().getTextureStreamer().waitForImport(texture);
+        material->packInstanceTextures();
         // MVP
         float aspect = static_cast<float>(props.width) / static_cast<float>(props.height);
         projMatrix = glm::perspective(glm::radians(60.0f), aspect, 0.1f, 1000.0f);
@@ -163,6 +273,10 @@ namespace Rune
         EventSystem::listen<EventWindowClose>([](const EventWindowClose& event) { Game::close(); });
 
         auto* scene = SceneManager::getInstance().getActiveScene();
+        auto depthPrePass = configInst.get("rendering.depth_prepass");
+        if (depthPrePass)
+            scene->setDepthPrePassEnabled(depthPrePass->getInt());
+
         auto entity = scene->createEntity();
         auto name = entity.getName();
         auto* transform = entity.add<Transform>();
@@ -287,17 +401,20 @@ namespace Rune
         Lighting lighting{};
         lighting.viewPos = { 0, 0, -5.0f, 1.0f };
         lighting.ambient = { 0.1f, 0.1f, 0.1f };
-        lighting.lightCount = 1;
-        // lighting.lights[0].position = { 5, 5, -3 };
-        lighting.lights[0].position = lightPos;
-        lighting.lights[0].isDirectional = false;
-        lighting.lights[0].direction = glm::normalize(glm::vec4{ 0, 0, -1, 1 });
-        lighting.lights[0].diffuseColor = { 1.0f, 1.0f, 1.0f, 1 };
-        lighting.lights[0].specularColor = { 1, 1, 1, 1 };
+        auto& light = lighting.lights.emplace_back();
+        // light.position = { 5, 5, -3 };
+        light.position = lightPos;
+        light.isDirectional = false;
+        light.direction = glm::normalize(glm::vec4{ 0, 0, -1, 1 });
+        light.diffuseColor = { 1.0f, 1.0f, 1.0f, 1 };
+        light.specularColor = { 1, 1, 1, 1 };
+        light.range = 25.0f;
+        lighting.shadowCastingLights.push_back(0);
 
         GraphicsSystem::getInstance().beginScene(projMatrix, viewMatrix, lighting);
 
-        GraphicsSystem::getInstance().addRenderable(glm::mat4(1.0f), testSceneMesh, surfaceMaterial);
+        // Never moves, so its shadows stay cached
+        GraphicsSystem::getInstance().addRenderable(glm::mat4(1.0f), testSceneMesh, surfaceMaterial, true);
 
         rotY += 5.0f * Time::getDeltaTime();
 
@@ -333,6 +450,12 @@ namespace Rune
 
     void Game::run()
     {
+        if (s_headlessFrames > 0)
+        {
+            runHeadless(*this);
+            return;
+        }
+
         while (!s_shouldStop)
         {
             sysUpdate();
@@ -0,0 +1,119 @@
+// # Copyright  Stuart Millman <stu.millman15@gmail.com>
+
+#include "pch.hpp"
+#include "rune/maths/bounds.hpp"
+
+#include <glm/common.hpp>
+#include <glm/geometric.hpp>
+#include <glm/matrix.hpp>
+
+namespace Rune
+{
+    bool AABB::isValid() const
+    {
+        return min.x <= max.x && min.y <= max.y && min.z <= max.z;
+    }
+
+    auto AABB::getCenter() const -> glm::vec3
+    {
+        return (min + max) * 0.5f;
+    }
+
+    auto AABB::getExtents() const -> glm::vec3
+    {
+        return (max - min) * 0.5f;
+    }
+
+    void AABB::expand(const glm::vec3& point)
+    {
+        min = glm::min(min, point);
+        max = glm::max(max, point);
+    }
+
+    void AABB::expand(const AABB& other)
+    {
+        min = glm::min(min, other.min);
+        max = glm::max(max, other.max);
+    }
+
+    auto AABB::transformed(const glm::mat4& transform) const -> AABB
+    {
+        // Transform the center and project the extents onto the transformed axes (Arvo)
+        const auto center = glm::vec3(transform * glm::vec4(getCenter(), 1.0f));
+        const auto extents = getExtents();
+
+        const glm::mat3 absBasis = { glm::abs(glm::vec3(transform[0])),
+                                     glm::abs(glm::vec3(transform[1])),
+                                     glm::abs(glm::vec3(transform[2])) };
+        const auto newExtents = absBasis * extents;
+
+        return { center - newExtents, center + newExtents };
+    }
+
+    auto Frustum::fromMatrix(const glm::mat4& viewProj) -> Frustum
+    {
+        // Gribb/Hartmann plane extraction. Rows of the matrix are combined.
+        const auto row0 = glm::vec4(viewProj[0][0], viewProj[1][0], viewProj[2][0], viewProj[3][0]);
+        const auto row1 = glm::vec4(viewProj[0][1], viewProj[1][1], viewProj[2][1], viewProj[3][1]);
+        const auto row2 = glm::vec4(viewProj[0][2], viewProj[1][2], viewProj[2][2], viewProj[3][2]);
+        const auto row3 = glm::vec4(viewProj[0][3], viewProj[1][3], viewProj[2][3], viewProj[3][3]);
+
+        Frustum frustum{};
+        frustum.planes[eLeft] = row3 + row0;
+        frustum.planes[eRight] = row3 - row0;
+        frustum.planes[eBottom] = row3 + row1;
+        frustum.planes[eTop] = row3 - row1;
+        frustum.planes[eNear] = row3 + row2;
+        frustum.planes[eFar] = row3 - row2;
+
+        for (auto& plane : frustum.planes)
+        {
+            plane /= glm::length(glm::vec3(plane));
+        }
+
+        return frustum;
+    }
+
+    bool Frustum::intersects(const AABB& box) const
+    {
+        const auto center = box.getCenter();
+        const auto extents = box.getExtents();
+
+        for (const auto& plane : planes)
+        {
+            const auto normal = glm::vec3(plane);
+            const f32 distance = glm::dot(normal, center) + plane.w;
+            const f32 radius = glm::dot(glm::abs(normal), extents);
+            if (distance + radius < 0.0f)
+                return false;
+        }
+
+        return true;
+    }
+
+    auto BoundsUtils::fromPoints(const glm::vec3* points, const size count, const size stride) -> Bounds
+    {
+        Bounds bounds{};
+
+        const auto* bytes = reinterpret_cast<const u8*>(points);
+        for (size i = 0; i < count; ++i)
+        {
+            bounds.box.expand(*reinterpret_cast<const glm::vec3*>(bytes + i * stride));
+        }
+
+        if (!bounds.box.isValid())
+            return bounds;
+
+        bounds.sphere.center = bounds.box.getCenter();
+
+        f32 radiusSqr = 0.0f;
+        for (size i = 0; i < count; ++i)
+        {
+            const auto offset = *reinterpret_cast<const glm::vec3*>(bytes + i * stride) - bounds.sphere.center;
+            radiusSqr = glm::max(radiusSqr, glm::dot(offset, offset));
+        }
+        bounds.sphere.radius = glm::sqrt(radiusSqr);
+
+        return bounds;
+    }
+}
@@ -0,0 +1,294 @@
+// # Copyright  Stuart Millman <stu.millman15@gmail.com>
+
+#include "pch.hpp"
+#include "rune/maths/culling.hpp"
+
+#include <bit>
+
+#if defined(__AVX__)
+    #define RUNE_CULLING_AVX 1
+    #include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+    #define RUNE_CULLING_SSE 1
+    #include <emmintrin.h>
+#endif
+
+namespace Rune
+{
+    namespace
+    {
+        auto cullBoxesScalar(const Frustum& frustum, const Culling::BoxBatch& boxes, const size first, std::vector<u8>& outVisible)
+            -> size
+        {
+            size visibleCount = 0;
+            for (size i = first; i < boxes.count(); ++i)
+            {
+                bool isVisible = true;
+                for (const auto& plane : frustum.planes)
+                {
+                    const f32 distance = plane.x * boxes.centerX[i] + plane.y * boxes.centerY[i] + plane.z * boxes.centerZ[i] + plane.w;
+                    const f32 radius =
+                        std::abs(plane.x) * boxes.extentX[i] + std::abs(plane.y) * boxes.extentY[i] + std::abs(plane.z) * boxes.extentZ[i];
+                    if (distance + radius < 0.0f)
+                    {
+                        isVisible = false;
+                        break;
+                    }
+                }
+
+                outVisible[i] = isVisible;
+                visibleCount += isVisible;
+            }
+            return visibleCount;
+        }
+
+        void overlapSphereScalar(const Culling::BoxBatch& boxes,
+                                 const size first,
+                                 const size end,
+                                 const BoundingSphere& sphere,
+                                 const size indexBase,
+                                 std::vector<u32>& outIndices)
+        {
+            const f32 radiusSqr = sphere.radius * sphere.radius;
+            for (size i = first; i < end; ++i)
+            {
+                // Distance from the sphere center to the box along each axis, 0 when inside the box's slab
+                const f32 dx = std::max(std::abs(sphere.center.x - boxes.centerX[i]) - boxes.extentX[i], 0.0f);
+                const f32 dy = std::max(std::abs(sphere.center.y - boxes.centerY[i]) - boxes.extentY[i], 0.0f);
+                const f32 dz = std::max(std::abs(sphere.center.z - boxes.centerZ[i]) - boxes.extentZ[i], 0.0f);
+                if (dx * dx + dy * dy + dz * dz <= radiusSqr)
+                    outIndices.push_back(static_cast<u32>(i - indexBase));
+            }
+        }
+
+#if RUNE_CULLING_AVX
+        constexpr size BatchWidth = 8;
+
+        auto cullBoxesSimd(const Frustum& frustum, const Culling::BoxBatch& boxes, std::vector<u8>& outVisible) -> size
+        {
+            const size simdCount = boxes.count() - boxes.count() % BatchWidth;
+            const __m256 signMask = _mm256_set1_ps(-0.0f);
+            const __m256 zero = _mm256_setzero_ps();
+
+            size visibleCount = 0;
+            for (size i = 0; i < simdCount; i += BatchWidth)
+            {
+                const __m256 cx = _mm256_loadu_ps(&boxes.centerX[i]);
+                const __m256 cy = _mm256_loadu_ps(&boxes.centerY[i]);
+                const __m256 cz = _mm256_loadu_ps(&boxes.centerZ[i]);
+                const __m256 ex = _mm256_loadu_ps(&boxes.extentX[i]);
+                const __m256 ey = _mm256_loadu_ps(&boxes.extentY[i]);
+                const __m256 ez = _mm256_loadu_ps(&boxes.extentZ[i]);
+
+                __m256 outside = zero;
+                for (const auto& plane : frustum.planes)
+                {
+                    const __m256 px = _mm256_set1_ps(plane.x);
+                    const __m256 py = _mm256_set1_ps(plane.y);
+                    const __m256 pz = _mm256_set1_ps(plane.z);
+
+                    __m256 distance = _mm256_add_ps(_mm256_mul_ps(px, cx), _mm256_set1_ps(plane.w));
+                    distance = _mm256_add_ps(distance, _mm256_mul_ps(py, cy));
+                    distance = _mm256_add_ps(distance, _mm256_mul_ps(pz, cz));
+
+                    __m256 radius = _mm256_mul_ps(_mm256_andnot_ps(signMask, px), ex);
+                    radius = _mm256_add_ps(radius, _mm256_mul_ps(_mm256_andnot_ps(signMask, py), ey));
+                    radius = _mm256_add_ps(radius, _mm256_mul_ps(_mm256_andnot_ps(signMask, pz), ez));
+
+                    outside = _mm256_or_ps(outside, _mm256_cmp_ps(_mm256_add_ps(distance, radius), zero, _CMP_LT_OQ));
+                }
+
+                const i32 outsideMask = _mm256_movemask_ps(outside);
+                for (size lane = 0; lane < BatchWidth; ++lane)
+                {
+                    const bool isVisible = ((outsideMask >> lane) & 1) == 0;
+                    outVisible[i + lane] = isVisible;
+                    visibleCount += isVisible;
+                }
+            }
+
+            return visibleCount + cullBoxesScalar(frustum, boxes, simdCount, outVisible);
+        }
+
+        void overlapSphereSimd(
+            const Culling::BoxBatch& boxes, const size first, const size count, const BoundingSphere& sphere, std::vector<u32>& outIndices)
+        {
+            const size simdEnd = first + count - count % BatchWidth;
+            const __m256 signMask = _mm256_set1_ps(-0.0f);
+            const __m256 zero = _mm256_setzero_ps();
+            const __m256 sx = _mm256_set1_ps(sphere.center.x);
+            const __m256 sy = _mm256_set1_ps(sphere.center.y);
+            const __m256 sz = _mm256_set1_ps(sphere.center.z);
+            const __m256 radiusSqr = _mm256_set1_ps(sphere.radius * sphere.radius);
+
+            for (size i = first; i < simdEnd; i += BatchWidth)
+            {
+                const __m256 dx = _mm256_max_ps(
+                    _mm256_sub_ps(_mm256_andnot_ps(signMask, _mm256_sub_ps(sx, _mm256_loadu_ps(&boxes.centerX[i]))),
+                                  _mm256_loadu_ps(&boxes.extentX[i])),
+                    zero);
+                const __m256 dy = _mm256_max_ps(
+                    _mm256_sub_ps(_mm256_andnot_ps(signMask, _mm256_sub_ps(sy, _mm256_loadu_ps(&boxes.centerY[i]))),
+                                  _mm256_loadu_ps(&boxes.extentY[i])),
+                    zero);
+                const __m256 dz = _mm256_max_ps(
+                    _mm256_sub_ps(_mm256_andnot_ps(signMask, _mm256_sub_ps(sz, _mm256_loadu_ps(&boxes.centerZ[i]))),
+                                  _mm256_loadu_ps(&boxes.extentZ[i])),
+                    zero);
+
+                __m256 distanceSqr = _mm256_mul_ps(dx, dx);
+                distanceSqr = _mm256_add_ps(distanceSqr, _mm256_mul_ps(dy, dy));
+                distanceSqr = _mm256_add_ps(distanceSqr, _mm256_mul_ps(dz, dz));
+
+                i32 overlapMask = _mm256_movemask_ps(_mm256_cmp_ps(distanceSqr, radiusSqr, _CMP_LE_OQ));
+                while (overlapMask != 0)
+                {
+                    const i32 lane = std::countr_zero(static_cast<u32>(overlapMask));
+                    outIndices.push_back(static_cast<u32>(i - first + lane));
+                    overlapMask &= overlapMask - 1;
+                }
+            }
+
+            overlapSphereScalar(boxes, simdEnd, first + count, sphere, first, outIndices);
+        }
+#elif RUNE_CULLING_SSE
+        constexpr size BatchWidth = 4;
+
+        auto cullBoxesSimd(const Frustum& frustum, const Culling::BoxBatch& boxes, std::vector<u8>& outVisible) -> size
+        {
+            const size simdCount = boxes.count() - boxes.count() % BatchWidth;
+            const __m128 signMask = _mm_set1_ps(-0.0f);
+            const __m128 zero = _mm_setzero_ps();
+
+            size visibleCount = 0;
+            for (size i = 0; i < simdCount; i += BatchWidth)
+            {
+                const __m128 cx = _mm_loadu_ps(&boxes.centerX[i]);
+                const __m128 cy = _mm_loadu_ps(&boxes.centerY[i]);
+                const __m128 cz = _mm_loadu_ps(&boxes.centerZ[i]);
+                const __m128 ex = _mm_loadu_ps(&boxes.extentX[i]);
+                const __m128 ey = _mm_loadu_ps(&boxes.extentY[i]);
+                const __m128 ez = _mm_loadu_ps(&boxes.extentZ[i]);
+
+                __m128 outside = zero;
+                for (const auto& plane : frustum.planes)
+                {
+                    const __m128 px = _mm_set1_ps(plane.x);
+                    const __m128 py = _mm_set1_ps(plane.y);
+                    const __m128 pz = _mm_set1_ps(plane.z);
+
+                    __m128 distance = _mm_add_ps(_mm_mul_ps(px, cx), _mm_set1_ps(plane.w));
+                    distance = _mm_add_ps(distance, _mm_mul_ps(py, cy));
+                    distance = _mm_add_ps(distance, _mm_mul_ps(pz, cz));
+
+                    __m128 radius = _mm_mul_ps(_mm_andnot_ps(signMask, px), ex);
+                    radius = _mm_add_ps(radius, _mm_mul_ps(_mm_andnot_ps(signMask, py), ey));
+                    radius = _mm_add_ps(radius, _mm_mul_ps(_mm_andnot_ps(signMask, pz), ez));
+
+                    outside = _mm_or_ps(outside, _mm_cmplt_ps(_mm_add_ps(distance, radius), zero));
+                }
+
+                const i32 outsideMask = _mm_movemask_ps(outside);
+                for (size lane = 0; lane < BatchWidth; ++lane)
+                {
+                    const bool isVisible = ((outsideMask >> lane) & 1) == 0;
+                    outVisible[i + lane] = isVisible;
+                    visibleCount += isVisible;
+                }
+            }
+
+            return visibleCount + cullBoxesScalar(frustum, boxes, simdCount, outVisible);
+        }
+
+        void overlapSphereSimd(
+            const Culling::BoxBatch& boxes, const size first, const size count, const BoundingSphere& sphere, std::vector<u32>& outIndices)
+        {
+            const size simdEnd = first + count - count % BatchWidth;
+            const __m128 signMask = _mm_set1_ps(-0.0f);
+            const __m128 zero = _mm_setzero_ps();
+            const __m128 sx = _mm_set1_ps(sphere.center.x);
+            const __m128 sy = _mm_set1_ps(sphere.center.y);
+            const __m128 sz = _mm_set1_ps(sphere.center.z);
+            const __m128 radiusSqr = _mm_set1_ps(sphere.radius * sphere.radius);
+
+            for (size i = first; i < simdEnd; i += BatchWidth)
+            {
+                const __m128 dx = _mm_max_ps(
+                    _mm_sub_ps(_mm_andnot_ps(signMask, _mm_sub_ps(sx, _mm_loadu_ps(&boxes.centerX[i]))), _mm_loadu_ps(&boxes.extentX[i])),
+                    zero);
+                const __m128 dy = _mm_max_ps(
+                    _mm_sub_ps(_mm_andnot_ps(signMask, _mm_sub_ps(sy, _mm_loadu_ps(&boxes.centerY[i]))), _mm_loadu_ps(&boxes.extentY[i])),
+                    zero);
+                const __m128 dz = _mm_max_ps(
+                    _mm_sub_ps(_mm_andnot_ps(signMask, _mm_sub_ps(sz, _mm_loadu_ps(&boxes.centerZ[i]))), _mm_loadu_ps(&boxes.extentZ[i])),
+                    zero);
+
+                __m128 distanceSqr = _mm_mul_ps(dx, dx);
+                distanceSqr = _mm_add_ps(distanceSqr, _mm_mul_ps(dy, dy));
+                distanceSqr = _mm_add_ps(distanceSqr, _mm_mul_ps(dz, dz));
+
+                i32 overlapMask = _mm_movemask_ps(_mm_cmple_ps(distanceSqr, radiusSqr));
+                while (overlapMask != 0)
+                {
+                    const i32 lane = std::countr_zero(static_cast<u32>(overlapMask));
+                    outIndices.push_back(static_cast<u32>(i - first + lane));
+                    overlapMask &= overlapMask - 1;
+                }
+            }
+
+            overlapSphereScalar(boxes, simdEnd, first + count, sphere, first, outIndices);
+        }
+#else
+        auto cullBoxesSimd(const Frustum& frustum, const Culling::BoxBatch& boxes, std::vector<u8>& outVisible) -> size
+        {
+            return cullBoxesScalar(frustum, boxes, 0, outVisible);
+        }
+
+        void overlapSphereSimd(
+            const Culling::BoxBatch& boxes, const size first, const size count, const BoundingSphere& sphere, std::vector<u32>& outIndices)
+        {
+            overlapSphereScalar(boxes, first, first + count, sphere, first, outIndices);
+        }
+#endif
+    }
+
+    void Culling::BoxBatch::clear()
+    {
+        centerX.clear();
+        centerY.clear();
+        centerZ.clear();
+        extentX.clear();
+        extentY.clear();
+        extentZ.clear();
+    }
+
+    void Culling::BoxBatch::add(const AABB& box)
+    {
+        const auto center = box.getCenter();
+        const auto extents = box.getExtents();
+
+        centerX.push_back(center.x);
+        centerY.push_back(center.y);
+        centerZ.push_back(center.z);
+        extentX.push_back(extents.x);
+        extentY.push_back(extents.y);
+        extentZ.push_back(extents.z);
+    }
+
+    auto Culling::BoxBatch::count() const -> size
+    {
+        return centerX.size();
+    }
+
+    auto Culling::cullBoxes(const Frustum& frustum, const BoxBatch& boxes, std::vector<u8>& outVisible) -> size
+    {
+        outVisible.resize(boxes.count());
+        return cullBoxesSimd(frustum, boxes, outVisible);
+    }
+
+    void Culling::overlapSphere(
+        const BoxBatch& boxes, const size first, const size count, const BoundingSphere& sphere, std::vector<u32>& outIndices)
+    {
+        overlapSphereSimd(boxes, first, count, sphere, outIndices);
+    }
+}
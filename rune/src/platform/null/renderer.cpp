@@ -0,0 +1,418 @@
+// # Copyright  Stuart Millman <stu.millman15@gmail.com>
+
+#include "pch.hpp"
+#include "renderer.hpp"
+
+#include "rune/macros.hpp"
+
+#include "rune/graphics/material.hpp"
+#include "rune/graphics/mesh.hpp"
+#include "rune/graphics/texture.hpp"
+#include "rune/graphics/texture_array.hpp"
+
+namespace Rune
+{
+    auto Renderer_Null::create() -> Owned<RendererBase>
+    {
+        return CreateOwned<Renderer_Null>();
+    }
+
+    void Renderer_Null::init()
+    {
+        CORE_LOG_INFO("Null renderer initialised. Nothing will be drawn.");
+    }
+
+    void Renderer_Null::cleanup()
+    {
+        m_commands.clear();
+        m_lastFrameCommands.clear();
+    }
+
+    void Renderer_Null::setWindow(WindowSystem* /*window*/) {}
+
+    void Renderer_Null::onFramebufferSize(const i32 /*width*/, const i32 /*height*/) {}
+
+    auto Renderer_Null::createBuffer(const size size, const void* data) -> u32
+    {
+        if (data != nullptr)
+            m_frameStats.bytesUploaded += size;
+
+        return m_bufferStorage.add({ size });
+    }
+
+    void Renderer_Null::destroyBuffer(const u32 id)
+    {
+        m_bufferStorage.remove(id);
+        resetBindings();
+    }
+
+    void Renderer_Null::updateBuffer(const u32 id, const size offset, const size size, const void* /*data*/)
+    {
+        auto& buffer = m_bufferStorage.get(id);
+        buffer.byteSize = std::max(buffer.byteSize, offset + size);
+
+        m_frameStats.bytesUploaded += size;
+        record(CommandType::eUpdateBuffer, id, static_cast<u32>(size), static_cast<u32>(offset));
+    }
+
+    void Renderer_Null::updateBufferRanges(const std::vector<BufferRangeUpdate>& ranges, const void* /*data*/, const size dataSize)
+    {
+        for (const auto& range : ranges)
+        {
+            auto& buffer = m_bufferStorage.get(range.bufferId);
+            buffer.byteSize = std::max<size>(buffer.byteSize, static_cast<size>(range.byteOffset) + range.byteSize);
+            record(CommandType::eUpdateBuffer, range.bufferId, range.byteSize, range.byteOffset);
+        }
+        m_frameStats.bytesUploaded += dataSize;
+    }
+
+    auto Renderer_Null::uploadFrameData(const void* /*data*/, const size size) -> FrameDataRange
+    {
+        const FrameDataRange range{ m_frameDataOffset, size };
+        m_frameDataOffset += size;
+
+        m_frameStats.bytesUploaded += size;
+        record(CommandType::eUploadFrameData, 0, static_cast<u32>(size), static_cast<u32>(range.byteOffset));
+        return range;
+    }
+
+    auto Renderer_Null::createMesh(const std::vector<Vertex>& vertices,
+                                   const std::vector<u32>& indices,
+                                   const IndexType indexType,
+                                   const VertexEncoding& encoding,
+                                   const MeshTopology topology) -> u32
+    {
+        m_frameStats.bytesUploaded += vertices.size() * getVertexSize(encoding.format) + indices.size() * getIndexSize(indexType);
+
+        return m_meshStorage.add(
+            { topology, indexType, encoding.format, static_cast<u32>(vertices.size()), static_cast<u32>(indices.size()) });
+    }
+
+    void Renderer_Null::destroyMesh(const u32 id)
+    {
+        m_meshStorage.remove(id);
+    }
+
+    void Renderer_Null::updateMeshVertices(const u32 id, const std::vector<Vertex>& vertices, const VertexEncoding& encoding)
+    {
+        m_meshStorage.get(id).vertexCount = static_cast<u32>(vertices.size());
+        m_meshStorage.get(id).vertexFormat = encoding.format;
+        m_frameStats.bytesUploaded += vertices.size() * getVertexSize(encoding.format);
+    }
+
+    void Renderer_Null::updateMeshIndices(const u32 id, const std::vector<u32>& indices, const IndexType indexType)
+    {
+        m_meshStorage.get(id).indexCount = static_cast<u32>(indices.size());
+        m_meshStorage.get(id).indexType = indexType;
+        m_frameStats.bytesUploaded += indices.size() * getIndexSize(indexType);
+    }
+
+    auto Renderer_Null::createMaterial(const std::vector<u8>& vertexCode, const std::vector<u8>& fragmentCode) -> u32
+    {
+        return m_materialStorage.add({ vertexCode.size() + fragmentCode.size() });
+    }
+
+    void Renderer_Null::destroyMaterial(const u32 id)
+    {
+        m_materialStorage.remove(id);
+        resetBindings();
+    }
+
+    void Renderer_Null::setProgramCacheDirectory(const std::string& /*directory*/) {}
+
+    auto Renderer_Null::createTexture(const u32 width, const u32 height, const TextureFormat format, const u32 mipCount) -> u32
+    {
+        return m_textureStorage.add({ width, height, format, mipCount, mipCount });
+    }
+
+    void Renderer_Null::destroyTexture(const u32 id)
+    {
+        m_textureStorage.remove(id);
+        resetBindings();
+    }
+
+    void Renderer_Null::uploadTextureMip(const u32 id, const u32 mip, const void* /*data*/)
+    {
+        const auto& texture = m_textureStorage.get(id);
+        const u32 mipWidth = getMipLevelSize(texture.width, mip);
+        const u32 mipHeight = getMipLevelSize(texture.height, mip);
+        m_frameStats.bytesUploaded += getTextureDataSize(texture.format, mipWidth, mipHeight);
+    }
+
+    void Renderer_Null::setTextureResidentMip(const u32 id, const u32 mip)
+    {
+        auto& texture = m_textureStorage.get(id);
+        if (mip == texture.residentMip)
+            return;
+        texture.residentMip = mip;
+
+        // Matches the OpenGL backend replacing the texture, which has to be bound again
+        for (auto& binding : m_boundTextures)
+        {
+            if (binding == Binding{ BoundKind::eTexture, id })
+                binding = {};
+        }
+        m_boundMaterialInst = nullptr;
+    }
+
+    auto Renderer_Null::createTextureArray(
+        const u32 width, const u32 height, const TextureFormat format, const u32 /*mipCount*/, const u32 layerCount) -> u32
+    {
+        return m_textureArrayStorage.add({ width, height, format, layerCount });
+    }
+
+    void Renderer_Null::destroyTextureArray(const u32 id)
+    {
+        m_textureArrayStorage.remove(id);
+        resetBindings();
+    }
+
+    void Renderer_Null::uploadTextureArrayMip(const u32 id, const u32 layer, const u32 mip, const void* /*data*/)
+    {
+        const auto& textureArray = m_textureArrayStorage.get(id);
+        RUNE_ENG_ASSERT(layer < textureArray.layerCount, "Texture array layer out of range");
+
+        const u32 mipWidth = getMipLevelSize(textureArray.width, mip);
+        const u32 mipHeight = getMipLevelSize(textureArray.height, mip);
+        m_frameStats.bytesUploaded += getTextureDataSize(textureArray.format, mipWidth, mipHeight);
+    }
+
+    void Renderer_Null::beginFrame()
+    {
+        // Matches the OpenGL backend binding its geometry VAO once per frame
+        ++m_frameStats.vaoBinds;
+
+        // Instances may have had their textures changed since the last frame
+        m_boundMaterialInst = nullptr;
+    }
+
+    void Renderer_Null::endFrame()
+    {
+        std::swap(m_lastFrameCommands, m_commands);
+        m_commands.clear();
+        m_frameDataOffset = 0;
+        m_boundMesh = nullptr;
+        resetBindings();
+
+        finishFrameStats();
+    }
+
+    void Renderer_Null::bindUniformBuffer(const u32 id, const u32 binding)
+    {
+        record(CommandType::eBindUniformBuffer, id, binding);
+        if (bind(m_boundUniformBuffers, binding, { BoundKind::eBuffer, id }))
+            ++m_frameStats.uniformBufferBinds;
+    }
+
+    void Renderer_Null::bindStorageBuffer(const u32 id, const u32 binding)
+    {
+        record(CommandType::eBindStorageBuffer, id, binding);
+        if (bind(m_boundStorageBuffers, binding, { BoundKind::eBuffer, id }))
+            ++m_frameStats.storageBufferBinds;
+    }
+
+    void Renderer_Null::bindFrameUniformBuffer(const FrameDataRange& range, const u32 binding)
+    {
+        record(CommandType::eBindFrameUniformBuffer, binding, static_cast<u32>(range.byteSize), static_cast<u32>(range.byteOffset));
+        if (bind(m_boundUniformBuffers, binding, { BoundKind::eFrameData, range.buffer, range.byteOffset, range.byteSize }))
+            ++m_frameStats.uniformBufferBinds;
+    }
+
+    void Renderer_Null::bindFrameStorageBuffer(const FrameDataRange& range, const u32 binding)
+    {
+        record(CommandType::eBindFrameStorageBuffer, binding, static_cast<u32>(range.byteSize), static_cast<u32>(range.byteOffset));
+        if (bind(m_boundStorageBuffers, binding, { BoundKind::eFrameData, range.buffer, range.byteOffset, range.byteSize }))
+            ++m_frameStats.storageBufferBinds;
+    }
+
+    void Renderer_Null::bindMaterial(MaterialInst* material)
+    {
+        if (m_boundMaterialInst == material)
+            return;
+
+        const auto program = material->getMaterial()->getId();
+        record(CommandType::eBindMaterial, program, material->getId());
+
+        if (program != m_boundProgram)
+        {
+            m_boundProgram = program;
+            ++m_frameStats.programBinds;
+        }
+
+        for (const auto& uniformBuffer : material->getUniformBuffers())
+        {
+            bindUniformBuffer(uniformBuffer.internalId, uniformBuffer.binding);
+        }
+
+        for (const auto& slot : material->getTextureSlots())
+        {
+            Binding texture;
+            if (slot.isArray)
+            {
+                if (slot.textureArray == nullptr)
+                    continue;
+                texture = { BoundKind::eTextureArray, slot.textureArray->getInternalId() };
+            }
+            else
+            {
+                if (slot.texture == nullptr)
+                    continue;
+                texture = { BoundKind::eTexture, slot.texture->getInternalId() };
+            }
+
+            if (bind(m_boundTextures, slot.binding, texture))
+                ++m_frameStats.textureBinds;
+        }
+
+        m_boundMaterialInst = material;
+    }
+
+    void Renderer_Null::bindMesh(Rune::Mesh* mesh, const u32 lod, const u32 submesh)
+    {
+        record(CommandType::eBindMesh, mesh->getId(), lod, submesh);
+        m_boundMesh = &m_meshStorage.get(mesh->getId());
+        m_boundIndexCount = static_cast<u32>(mesh->getIndexRange(lod, submesh).indexCount);
+    }
+
+    void Renderer_Null::draw()
+    {
+        record(CommandType::eDraw, 0, 1);
+
+        ++m_frameStats.drawCalls;
+        ++m_frameStats.instances;
+        if (m_boundMesh != nullptr)
+            m_frameStats.triangles += countTriangles(*m_boundMesh, m_boundIndexCount, 1);
+    }
+
+    void Renderer_Null::drawInstanced(const u32 instanceCount, const u32 firstInstance)
+    {
+        record(CommandType::eDrawInstanced, 0, instanceCount, firstInstance);
+
+        ++m_frameStats.drawCalls;
+        m_frameStats.instances += instanceCount;
+        if (m_boundMesh != nullptr)
+            m_frameStats.triangles += countTriangles(*m_boundMesh, m_boundIndexCount, instanceCount);
+    }
+
+    void Renderer_Null::drawIndirect(const DrawCommand* commands, const u32 count)
+    {
+        record(CommandType::eDrawIndirect, 0, count);
+
+        for (u32 i = 0; i < count; ++i)
+        {
+            const auto& mesh = m_meshStorage.get(commands[i].mesh->getId());
+
+            // Like the GPU renderers, a new call starts wherever the topology, index type or vertex format changes
+            if (i == 0)
+                ++m_frameStats.drawCalls;
+            else
+            {
+                const auto& previous = m_meshStorage.get(commands[i - 1].mesh->getId());
+                const bool isSameFormat = mesh.topology == previous.topology && mesh.indexType == previous.indexType &&
+                                          mesh.vertexFormat == previous.vertexFormat;
+                if (!isSameFormat)
+                    ++m_frameStats.drawCalls;
+            }
+
+            m_frameStats.instances += commands[i].instanceCount;
+            const auto indexCount = static_cast<u32>(commands[i].mesh->getIndexRange(commands[i].lod, commands[i].submesh).indexCount);
+            m_frameStats.triangles += countTriangles(mesh, indexCount, commands[i].instanceCount);
+        }
+    }
+
+    auto Renderer_Null::createShadowMap(const u32 resolution, const u32 layerCount) -> u32
+    {
+        return m_shadowMapStorage.add({ resolution, layerCount });
+    }
+
+    void Renderer_Null::destroyShadowMap(const u32 id)
+    {
+        m_shadowMapStorage.remove(id);
+        resetBindings();
+    }
+
+    void Renderer_Null::copyShadowMap(const u32 srcId, const u32 dstId)
+    {
+        record(CommandType::eCopyShadowMap, dstId, srcId);
+    }
+
+    void Renderer_Null::beginShadowPass(const u32 shadowMapId, const u32 layer, const bool clear)
+    {
+        RUNE_ENG_ASSERT(layer < m_shadowMapStorage.get(shadowMapId).layerCount, "Shadow map layer out of range!");
+        record(CommandType::eBeginShadowPass, shadowMapId, layer, clear);
+
+        // Matches the OpenGL backend switching to its depth program and position-only VAO
+        m_boundProgram = 0;
+        m_boundMaterialInst = nullptr;
+        ++m_frameStats.programBinds;
+        ++m_frameStats.vaoBinds;
+    }
+
+    void Renderer_Null::endShadowPass()
+    {
+        record(CommandType::eEndShadowPass, 0);
+        ++m_frameStats.vaoBinds;
+    }
+
+    void Renderer_Null::bindShadowMap(const u32 id, const u32 binding)
+    {
+        record(CommandType::eBindShadowMap, id, binding);
+        if (bind(m_boundTextures, binding, { BoundKind::eShadowMap, id }))
+            ++m_frameStats.textureBinds;
+    }
+
+    void Renderer_Null::beginDepthPrePass(const bool cullBackFaces)
+    {
+        record(CommandType::eBeginDepthPrePass, 0, cullBackFaces);
+
+        // Matches the OpenGL backend switching to its depth program and position-only VAO
+        m_boundProgram = 0;
+        m_boundMaterialInst = nullptr;
+        ++m_frameStats.programBinds;
+        ++m_frameStats.vaoBinds;
+    }
+
+    void Renderer_Null::endDepthPrePass()
+    {
+        record(CommandType::eEndDepthPrePass, 0);
+        ++m_frameStats.vaoBinds;
+    }
+
+    auto Renderer_Null::getLastFrameCommands() const -> const std::vector<Command>&
+    {
+        return m_lastFrameCommands;
+    }
+
+    void Renderer_Null::record(const CommandType type, const u32 id, const u32 arg0, const u32 arg1)
+    {
+        m_commands.push_back({ type, id, arg0, arg1 });
+    }
+
+    auto Renderer_Null::countTriangles(const Mesh& mesh, const u32 indexCount, const u32 instanceCount) -> u64
+    {
+        if (mesh.topology != MeshTopology::eTriangles)
+            return 0;
+
+        return static_cast<u64>(indexCount / 3) * instanceCount;
+    }
+
+    bool Renderer_Null::bind(std::vector<Binding>& bindings, const u32 binding, const Binding& value)
+    {
+        if (bindings.size() <= binding)
+            bindings.resize(binding + 1);
+
+        if (bindings[binding] == value)
+            return false;
+
+        bindings[binding] = value;
+        return true;
+    }
+
+    void Renderer_Null::resetBindings()
+    {
+        m_boundProgram = 0;
+        m_boundUniformBuffers.clear();
+        m_boundStorageBuffers.clear();
+        m_boundTextures.clear();
+    }
+}
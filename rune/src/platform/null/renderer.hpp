@@ -0,0 +1,216 @@
+// # Copyright  Stuart Millman <stu.millman15@gmail.com>
+
+#pragma once
+
+#include "rune/graphics/graphics.hpp"
+#include "rune/utility/storage.hpp"
+
+#include <vector>
+
+namespace Rune
+{
+    /**
+     * Renderer that never touches a GPU. Resources are tracked and the command stream of each frame is recorded,
+     * so engine-side CPU cost can be measured on machines without a graphics device.
+     */
+    class Renderer_Null : public RendererBase
+    {
+    public:
+        enum class CommandType : u8
+        {
+            eUpdateBuffer,
+            eUploadFrameData,
+            eBindUniformBuffer,
+            eBindStorageBuffer,
+            eBindFrameUniformBuffer,
+            eBindFrameStorageBuffer,
+            eBindMaterial,
+            eBindMesh,
+            eDraw,
+            eDrawInstanced,
+            eDrawIndirect,
+            eCopyShadowMap,
+            eBeginShadowPass,
+            eEndShadowPass,
+            eBindShadowMap,
+            eBeginDepthPrePass,
+            eEndDepthPrePass
+        };
+
+        struct Command
+        {
+            CommandType type;
+            u32 id;    // Resource/binding the command applies to
+            u32 arg0;  // eg. size, instance count, command count
+            u32 arg1;  // eg. offset, first instance
+        };
+
+    public:
+        static auto create() -> Owned<RendererBase>;
+
+        void init() override;
+        void cleanup() override;
+
+        void setWindow(WindowSystem* window) override;
+        void onFramebufferSize(i32 width, i32 height) override;
+
+        auto createBuffer(size size, const void* data) -> u32 override;
+        void destroyBuffer(u32 id) override;
+        void updateBuffer(u32 id, size offset, size size, const void* data) override;
+        void updateBufferRanges(const std::vector<BufferRangeUpdate>& ranges, const void* data, size dataSize) override;
+
+        auto uploadFrameData(const void* data, size size) -> FrameDataRange override;
+
+        auto createMesh(const std::vector<Vertex>& vertices,
+                        const std::vector<u32>& indices,
+                        IndexType indexType,
+                        const VertexEncoding& encoding,
+                        MeshTopology topology) -> u32 override;
+        void destroyMesh(u32 id) override;
+        void updateMeshVertices(u32 id, const std::vector<Vertex>& vertices, const VertexEncoding& encoding) override;
+        void updateMeshIndices(u32 id, const std::vector<u32>& indices, IndexType indexType) override;
+
+        auto createMaterial(const std::vector<u8>& vertexCode, const std::vector<u8>& fragmentCode) -> u32 override;
+        void destroyMaterial(u32 id) override;
+        void setProgramCacheDirectory(const std::string& directory) override;
+
+        auto createTexture(u32 width, u32 height, TextureFormat format, u32 mipCount) -> u32 override;
+        void destroyTexture(u32 id) override;
+        void uploadTextureMip(u32 id, u32 mip, const void* data) override;
+        void setTextureResidentMip(u32 id, u32 mip) override;
+
+        auto createTextureArray(u32 width, u32 height, TextureFormat format, u32 mipCount, u32 layerCount) -> u32 override;
+        void destroyTextureArray(u32 id) override;
+        void uploadTextureArrayMip(u32 id, u32 layer, u32 mip, const void* data) override;
+
+        void beginFrame() override;
+        void endFrame() override;
+
+        void bindUniformBuffer(u32 id, u32 binding) override;
+        void bindStorageBuffer(u32 id, u32 binding) override;
+        void bindFrameUniformBuffer(const FrameDataRange& range, u32 binding) override;
+        void bindFrameStorageBuffer(const FrameDataRange& range, u32 binding) override;
+        void bindMaterial(MaterialInst* material) override;
+        void bindMesh(Mesh* mesh, u32 lod, u32 submesh) override;
+
+        void draw() override;
+        void drawInstanced(u32 instanceCount, u32 firstInstance) override;
+        void drawIndirect(const DrawCommand* commands, u32 count) override;
+
+        auto createShadowMap(u32 resolution, u32 layerCount) -> u32 override;
+        void destroyShadowMap(u32 id) override;
+        void copyShadowMap(u32 srcId, u32 dstId) override;
+        void beginShadowPass(u32 shadowMapId, u32 layer, bool clear) override;
+        void endShadowPass() override;
+        void bindShadowMap(u32 id, u32 binding) override;
+
+        void beginDepthPrePass(bool cullBackFaces) override;
+        void endDepthPrePass() override;
+
+        /**
+         * @return Commands recorded between the last two calls to endFrame(). Stats are counted as if the commands had been
+         * issued to the OpenGL backend.
+         */
+        auto getLastFrameCommands() const -> const std::vector<Command>&;
+
+    private:
+        void record(CommandType type, u32 id, u32 arg0 = 0, u32 arg1 = 0);
+
+        struct Mesh;
+        static auto countTriangles(const Mesh& mesh, u32 indexCount, u32 instanceCount) -> u64;
+
+        /* What a binding point holds. Ids are only unique within a kind, as each has its own storage */
+        enum class BoundKind : u8
+        {
+            eNone,
+            eBuffer,
+            eFrameData,
+            eTexture,
+            eTextureArray,
+            eShadowMap
+        };
+
+        struct Binding
+        {
+            BoundKind kind = BoundKind::eNone;
+            u32 id = 0;
+            size byteOffset = 0;
+            size byteSize = 0;
+
+            bool operator==(const Binding& other) const = default;
+        };
+
+        /**
+         * @return True if the binding point held something else, so the OpenGL backend's state cache would issue the bind.
+         */
+        static bool bind(std::vector<Binding>& bindings, u32 binding, const Binding& value);
+
+        /**
+         * Forget what every binding point holds, where the OpenGL backend resets its state cache.
+         */
+        void resetBindings();
+
+    private:
+        struct Buffer
+        {
+            size byteSize;
+        };
+
+        struct Mesh
+        {
+            MeshTopology topology;
+            IndexType indexType;
+            VertexFormat vertexFormat;
+            u32 vertexCount;
+            u32 indexCount;
+        };
+
+        struct Material
+        {
+            size codeSize;
+        };
+
+        struct Texture
+        {
+            u32 width;
+            u32 height;
+            TextureFormat format;
+            u32 mipCount;
+            u32 residentMip;
+        };
+
+        struct TextureArray
+        {
+            u32 width;
+            u32 height;
+            TextureFormat format;
+            u32 layerCount;
+        };
+
+        struct ShadowMap
+        {
+            u32 resolution;
+            u32 layerCount;
+        };
+
+    private:
+        Storage<Buffer> m_bufferStorage;
+        Storage<Mesh> m_meshStorage;
+        Storage<Material> m_materialStorage;
+        Storage<Texture> m_textureStorage;
+        Storage<TextureArray> m_textureArrayStorage;
+        Storage<ShadowMap> m_shadowMapStorage;
+
+        std::vector<Command> m_commands;
+        std::vector<Command> m_lastFrameCommands;
+
+        Mesh* m_boundMesh = nullptr;
+        u32 m_boundIndexCount = 0;
+        u32 m_boundProgram = 0;
+        MaterialInst* m_boundMaterialInst = nullptr;
+        std::vector<Binding> m_boundUniformBuffers;
+        std::vector<Binding> m_boundStorageBuffers;
+        std::vector<Binding> m_boundTextures;
+        size m_frameDataOffset = 0;
+    };
+}
@@ -0,0 +1,418 @@
+// # Copyright  Stuart Millman <stu.millman15@gmail.com>
+
+#include "pch.hpp"
+#include "geometry_arena.hpp"
+
+#include "rune/macros.hpp"
+#include "rune/graphics/vertex_quantize.hpp"
+
+#include <algorithm>
+
+namespace Rune
+{
+    namespace
+    {
+        /* Compact once fragmented space is over this fraction of the used space */
+        constexpr f32 CompactionThreshold = 0.25f;
+
+        void copyBuffer(
+            const GLuint srcBuffer, const GLuint dstBuffer, const u32 srcElement, const u32 dstElement, const u32 count, const size stride)
+        {
+            if (count == 0)
+                return;
+
+            glCopyNamedBufferSubData(srcBuffer, dstBuffer, srcElement * stride, dstElement * stride, count * stride);
+        }
+
+        /* Vertex buffers are allocated in slots of one quantized vertex */
+        constexpr size VertexSlotSize = sizeof(QuantizedVertex);
+        constexpr size PositionSlotSize = getPositionSize(VertexFormat::eQuantized);
+        static_assert(getPositionSize(VertexFormat::eFull) == PositionSlotSize * (sizeof(Vertex) / VertexSlotSize),
+                      "Full vertices should take the same number of slots in both vertex buffers!");
+
+        auto getSlotsPerIndex(const IndexType indexType) -> u32
+        {
+            return static_cast<u32>(getIndexSize(indexType) / sizeof(u16));
+        }
+
+        auto getSlotsPerVertex(const VertexFormat format) -> u32
+        {
+            return static_cast<u32>(getVertexSize(format) / VertexSlotSize);
+        }
+
+        /**
+         * @return Number of slots to allocate for the elements, including room to align elements larger than a slot.
+         */
+        auto getSlotCount(const u32 slotsPerElement, const u32 count) -> u32
+        {
+            if (slotsPerElement == 1 || count == 0)
+                return count;
+
+            return count * slotsPerElement + slotsPerElement - 1;
+        }
+
+        /**
+         * @return First element of an allocation starting at the slot, in units of the element size.
+         */
+        auto getFirstElement(const u32 slotsPerElement, const u32 firstSlot) -> u32
+        {
+            return (firstSlot + slotsPerElement - 1) / slotsPerElement;
+        }
+    }
+
+    void GeometryArena_OpenGL::init(const u32 vertexCapacity, const u32 indexCapacity)
+    {
+        setupVaos(VertexFormat::eFull);
+        setupVaos(VertexFormat::eQuantized);
+
+        m_vertexAllocator.init(vertexCapacity);
+        m_indexAllocator.init(indexCapacity);
+        createVertexBuffer(vertexCapacity);
+        createIndexBuffer(indexCapacity);
+    }
+
+    void GeometryArena_OpenGL::cleanup()
+    {
+        glDeleteBuffers(1, &m_vertexBuffer);
+        glDeleteBuffers(1, &m_positionBuffer);
+        glDeleteBuffers(1, &m_indexBuffer);
+        glDeleteVertexArrays(static_cast<GLsizei>(m_vaos.size()), m_vaos.data());
+        glDeleteVertexArrays(static_cast<GLsizei>(m_positionVaos.size()), m_positionVaos.data());
+
+        m_allocations.clear();
+    }
+
+    auto GeometryArena_OpenGL::allocate(const std::vector<Vertex>& vertices,
+                                        const VertexEncoding& encoding,
+                                        const std::vector<u32>& indices,
+                                        const IndexType indexType) -> u32
+    {
+        // Ranges are allocated one at a time so that compaction while allocating keeps the ranges already allocated
+        const u32 id = m_nextAllocationId++;
+        const u32 slotsPerVertex = getSlotsPerVertex(encoding.format);
+        const u32 vertexSlotCount = getSlotCount(slotsPerVertex, static_cast<u32>(vertices.size()));
+        m_allocations[id].firstVertexSlot = allocateVertexSlots(vertexSlotCount);
+        m_allocations[id].vertexSlotCount = vertexSlotCount;
+        m_allocations[id].baseVertex = getFirstElement(slotsPerVertex, m_allocations[id].firstVertexSlot);
+        m_allocations[id].vertexCount = static_cast<u32>(vertices.size());
+        m_allocations[id].vertexFormat = encoding.format;
+
+        const u32 slotsPerIndex = getSlotsPerIndex(indexType);
+        const u32 indexSlotCount = getSlotCount(slotsPerIndex, static_cast<u32>(indices.size()));
+        m_allocations[id].firstIndexSlot = allocateIndexSlots(indexSlotCount);
+        m_allocations[id].indexSlotCount = indexSlotCount;
+        m_allocations[id].firstIndex = getFirstElement(slotsPerIndex, m_allocations[id].firstIndexSlot);
+        m_allocations[id].indexCount = static_cast<u32>(indices.size());
+        m_allocations[id].indexType = indexType;
+
+        const auto& allocation = m_allocations[id];
+        writeVertices(allocation, vertices, encoding);
+        writeIndices(allocation, indices);
+
+        return id;
+    }
+
+    void GeometryArena_OpenGL::free(const u32 id)
+    {
+        const auto it = m_allocations.find(id);
+        RUNE_ENG_ASSERT(it != m_allocations.end(), "Geometry allocation does not exist!");
+
+        m_vertexAllocator.free(it->second.firstVertexSlot, it->second.vertexSlotCount);
+        m_indexAllocator.free(it->second.firstIndexSlot, it->second.indexSlotCount);
+        m_allocations.erase(it);
+    }
+
+    void GeometryArena_OpenGL::updateVertices(const u32 id, const std::vector<Vertex>& vertices, const VertexEncoding& encoding)
+    {
+        auto& allocation = m_allocations.at(id);
+
+        const auto count = static_cast<u32>(vertices.size());
+        if (count != allocation.vertexCount || encoding.format != allocation.vertexFormat)
+        {
+            m_vertexAllocator.free(allocation.firstVertexSlot, allocation.vertexSlotCount);
+            allocation.vertexCount = 0;  // Nothing to keep if compacted while reallocating
+            allocation.vertexSlotCount = 0;
+
+            const u32 slotsPerVertex = getSlotsPerVertex(encoding.format);
+            const u32 slotCount = getSlotCount(slotsPerVertex, count);
+            allocation.firstVertexSlot = allocateVertexSlots(slotCount);
+            allocation.vertexSlotCount = slotCount;
+            allocation.baseVertex = getFirstElement(slotsPerVertex, allocation.firstVertexSlot);
+            allocation.vertexCount = count;
+            allocation.vertexFormat = encoding.format;
+        }
+
+        writeVertices(allocation, vertices, encoding);
+    }
+
+    void GeometryArena_OpenGL::updateIndices(const u32 id, const std::vector<u32>& indices, const IndexType indexType)
+    {
+        auto& allocation = m_allocations.at(id);
+
+        const auto count = static_cast<u32>(indices.size());
+        if (count != allocation.indexCount || indexType != allocation.indexType)
+        {
+            m_indexAllocator.free(allocation.firstIndexSlot, allocation.indexSlotCount);
+            allocation.indexCount = 0;  // Nothing to keep if compacted while reallocating
+            allocation.indexSlotCount = 0;
+
+            const u32 slotsPerIndex = getSlotsPerIndex(indexType);
+            const u32 slotCount = getSlotCount(slotsPerIndex, count);
+            allocation.firstIndexSlot = allocateIndexSlots(slotCount);
+            allocation.indexSlotCount = slotCount;
+            allocation.firstIndex = getFirstElement(slotsPerIndex, allocation.firstIndexSlot);
+            allocation.indexCount = count;
+            allocation.indexType = indexType;
+        }
+
+        writeIndices(allocation, indices);
+    }
+
+    auto GeometryArena_OpenGL::get(const u32 id) const -> const Allocation&
+    {
+        return m_allocations.at(id);
+    }
+
+    auto GeometryArena_OpenGL::getVao(const VertexFormat format) const -> GLuint
+    {
+        return m_vaos[static_cast<size>(format)];
+    }
+
+    auto GeometryArena_OpenGL::getPositionVao(const VertexFormat format) const -> GLuint
+    {
+        return m_positionVaos[static_cast<size>(format)];
+    }
+
+    void GeometryArena_OpenGL::compactIfFragmented()
+    {
+        const auto isFragmented = [](const RangeAllocator& allocator)
+        {
+            const auto fragmentedCount = static_cast<f32>(allocator.getFragmentedCount());
+            return fragmentedCount > 0 && fragmentedCount > static_cast<f32>(allocator.getUsedCount()) * CompactionThreshold;
+        };
+
+        if (isFragmented(m_vertexAllocator) || isFragmented(m_indexAllocator))
+            compact();
+    }
+
+    auto GeometryArena_OpenGL::allocateVertexSlots(const u32 count) -> u32
+    {
+        u32 firstSlot = 0;
+        if (m_vertexAllocator.allocate(count, firstSlot))
+            return firstSlot;
+
+        // Compacting only helps if the free space is enough once gathered together
+        if (m_vertexAllocator.getFreeCount() >= count)
+            compact();
+        else
+            growVertexBuffer(m_vertexAllocator.getUsedCount() + count);
+
+        const bool allocated = m_vertexAllocator.allocate(count, firstSlot);
+        RUNE_ENG_ASSERT(allocated, "Failed to allocate vertices from geometry arena!");
+        return firstSlot;
+    }
+
+    auto GeometryArena_OpenGL::allocateIndexSlots(const u32 count) -> u32
+    {
+        u32 firstSlot = 0;
+        if (m_indexAllocator.allocate(count, firstSlot))
+            return firstSlot;
+
+        if (m_indexAllocator.getFreeCount() >= count)
+            compact();
+        else
+            growIndexBuffer(m_indexAllocator.getUsedCount() + count);
+
+        const bool allocated = m_indexAllocator.allocate(count, firstSlot);
+        RUNE_ENG_ASSERT(allocated, "Failed to allocate indices from geometry arena!");
+        return firstSlot;
+    }
+
+    void GeometryArena_OpenGL::growVertexBuffer(const u32 minCapacity)
+    {
+        const u32 oldCapacity = m_vertexAllocator.getCapacity();
+        const u32 newCapacity = std::max(oldCapacity * 2, minCapacity);
+        CORE_LOG_INFO("Growing geometry arena vertex buffer to {} quantized vertex slots", newCapacity);
+
+        const GLuint oldBuffer = m_vertexBuffer;
+        const GLuint oldPositionBuffer = m_positionBuffer;
+        createVertexBuffer(newCapacity);
+        copyBuffer(oldBuffer, m_vertexBuffer, 0, 0, oldCapacity, VertexSlotSize);
+        copyBuffer(oldPositionBuffer, m_positionBuffer, 0, 0, oldCapacity, PositionSlotSize);
+        glDeleteBuffers(1, &oldBuffer);
+        glDeleteBuffers(1, &oldPositionBuffer);
+
+        m_vertexAllocator.grow(newCapacity);
+    }
+
+    void GeometryArena_OpenGL::growIndexBuffer(const u32 minCapacity)
+    {
+        const u32 oldCapacity = m_indexAllocator.getCapacity();
+        const u32 newCapacity = std::max(oldCapacity * 2, minCapacity);
+        CORE_LOG_INFO("Growing geometry arena index buffer to {} 16bit slots", newCapacity);
+
+        const GLuint oldBuffer = m_indexBuffer;
+        createIndexBuffer(newCapacity);
+        copyBuffer(oldBuffer, m_indexBuffer, 0, 0, oldCapacity, sizeof(u16));
+        glDeleteBuffers(1, &oldBuffer);
+
+        m_indexAllocator.grow(newCapacity);
+    }
+
+    void GeometryArena_OpenGL::compact()
+    {
+        // Copy into fresh buffers as ranges moving within the same buffer could overlap
+        const GLuint oldVertexBuffer = m_vertexBuffer;
+        const GLuint oldPositionBuffer = m_positionBuffer;
+        const GLuint oldIndexBuffer = m_indexBuffer;
+        createVertexBuffer(m_vertexAllocator.getCapacity());
+        createIndexBuffer(m_indexAllocator.getCapacity());
+
+        m_vertexAllocator.init(m_vertexAllocator.getCapacity());
+        m_indexAllocator.init(m_indexAllocator.getCapacity());
+
+        for (auto& [id, allocation] : m_allocations)
+        {
+            const auto format = allocation.vertexFormat;
+            u32 firstVertexSlot = 0;
+            m_vertexAllocator.allocate(allocation.vertexSlotCount, firstVertexSlot);
+            const u32 baseVertex = getFirstElement(getSlotsPerVertex(format), firstVertexSlot);
+            copyBuffer(
+                oldVertexBuffer, m_vertexBuffer, allocation.baseVertex, baseVertex, allocation.vertexCount, getVertexSize(format));
+            copyBuffer(
+                oldPositionBuffer, m_positionBuffer, allocation.baseVertex, baseVertex, allocation.vertexCount, getPositionSize(format));
+            allocation.firstVertexSlot = firstVertexSlot;
+            allocation.baseVertex = baseVertex;
+
+            u32 firstIndexSlot = 0;
+            m_indexAllocator.allocate(allocation.indexSlotCount, firstIndexSlot);
+            const u32 firstIndex = getFirstElement(getSlotsPerIndex(allocation.indexType), firstIndexSlot);
+            copyBuffer(oldIndexBuffer,
+                       m_indexBuffer,
+                       allocation.firstIndex,
+                       firstIndex,
+                       allocation.indexCount,
+                       getIndexSize(allocation.indexType));
+            allocation.firstIndexSlot = firstIndexSlot;
+            allocation.firstIndex = firstIndex;
+        }
+
+        glDeleteBuffers(1, &oldVertexBuffer);
+        glDeleteBuffers(1, &oldPositionBuffer);
+        glDeleteBuffers(1, &oldIndexBuffer);
+
+        CORE_LOG_INFO("Compacted geometry arena ({} vertex slots, {} 16bit index slots in use)",
+                      m_vertexAllocator.getUsedCount(),
+                      m_indexAllocator.getUsedCount());
+    }
+
+    void GeometryArena_OpenGL::createVertexBuffer(const u32 capacity)
+    {
+        glCreateBuffers(1, &m_vertexBuffer);
+        glNamedBufferData(m_vertexBuffer, static_cast<GLsizeiptr>(capacity) * VertexSlotSize, nullptr, GL_STATIC_DRAW);
+
+        glCreateBuffers(1, &m_positionBuffer);
+        glNamedBufferData(m_positionBuffer, static_cast<GLsizeiptr>(capacity) * PositionSlotSize, nullptr, GL_STATIC_DRAW);
+
+        // Every format reads the same buffers, with its own stride
+        for (const auto format : { VertexFormat::eFull, VertexFormat::eQuantized })
+        {
+            const auto index = static_cast<size>(format);
+            glVertexArrayVertexBuffer(m_vaos[index], 0, m_vertexBuffer, 0, static_cast<GLsizei>(getVertexSize(format)));
+            glVertexArrayVertexBuffer(m_positionVaos[index], 0, m_positionBuffer, 0, static_cast<GLsizei>(getPositionSize(format)));
+        }
+    }
+
+    void GeometryArena_OpenGL::createIndexBuffer(const u32 capacity)
+    {
+        glCreateBuffers(1, &m_indexBuffer);
+        glNamedBufferData(m_indexBuffer, static_cast<GLsizeiptr>(capacity) * sizeof(u16), nullptr, GL_STATIC_DRAW);
+        for (size i = 0; i < m_vaos.size(); ++i)
+        {
+            glVertexArrayElementBuffer(m_vaos[i], m_indexBuffer);
+            glVertexArrayElementBuffer(m_positionVaos[i], m_indexBuffer);
+        }
+    }
+
+    void GeometryArena_OpenGL::setupVaos(const VertexFormat format)
+    {
+        const auto index = static_cast<size>(format);
+        auto& vao = m_vaos[index];
+        auto& positionVao = m_positionVaos[index];
+        glCreateVertexArrays(1, &vao);
+        glCreateVertexArrays(1, &positionVao);
+
+        for (GLuint attrib = 0; attrib < 3; ++attrib)
+        {
+            glEnableVertexArrayAttrib(vao, attrib);
+            glVertexArrayAttribBinding(vao, attrib, 0);
+        }
+        glEnableVertexArrayAttrib(positionVao, 0);
+        glVertexArrayAttribBinding(positionVao, 0, 0);
+
+        if (format == VertexFormat::eFull)
+        {
+            glVertexArrayAttribFormat(vao, 0, 3, GL_FLOAT, GL_FALSE, offsetof(Vertex, pos));
+            glVertexArrayAttribFormat(vao, 1, 2, GL_FLOAT, GL_FALSE, offsetof(Vertex, uv));
+            glVertexArrayAttribFormat(vao, 2, 3, GL_FLOAT, GL_FALSE, offsetof(Vertex, norm));
+            glVertexArrayAttribFormat(positionVao, 0, 3, GL_FLOAT, GL_FALSE, 0);
+            return;
+        }
+
+        // Shaders decode positions with the per-instance bounds transform, and normals from their octahedral encoding
+        glVertexArrayAttribFormat(vao, 0, 3, GL_UNSIGNED_SHORT, GL_TRUE, offsetof(QuantizedVertex, pos));
+        glVertexArrayAttribFormat(vao, 1, 2, GL_HALF_FLOAT, GL_FALSE, offsetof(QuantizedVertex, uv));
+        glVertexArrayAttribFormat(vao, 2, 2, GL_SHORT, GL_TRUE, offsetof(QuantizedVertex, norm));
+        glVertexArrayAttribFormat(positionVao, 0, 3, GL_UNSIGNED_SHORT, GL_TRUE, 0);
+    }
+
+    void GeometryArena_OpenGL::writeVertices(const Allocation& allocation,
+                                             const std::vector<Vertex>& vertices,
+                                             const VertexEncoding& encoding)
+    {
+        const auto vertexSize = getVertexSize(allocation.vertexFormat);
+        const auto positionSize = getPositionSize(allocation.vertexFormat);
+
+        if (allocation.vertexFormat == VertexFormat::eFull)
+        {
+            glNamedBufferSubData(m_vertexBuffer, allocation.baseVertex * vertexSize, vertices.size() * vertexSize, vertices.data());
+
+            m_positionScratch.resize(vertices.size());
+            for (size i = 0; i < vertices.size(); ++i)
+            {
+                m_positionScratch[i] = vertices[i].pos;
+            }
+            glNamedBufferSubData(
+                m_positionBuffer, allocation.baseVertex * positionSize, vertices.size() * positionSize, m_positionScratch.data());
+            return;
+        }
+
+        m_quantizedScratch.resize(vertices.size());
+        m_quantizedPositionScratch.resize(vertices.size() * 3);
+        for (size i = 0; i < vertices.size(); ++i)
+        {
+            const auto& quantized = m_quantizedScratch[i] = VertexQuantize::encode(vertices[i], encoding);
+            std::copy(std::begin(quantized.pos), std::end(quantized.pos), m_quantizedPositionScratch.begin() + i * 3);
+        }
+        glNamedBufferSubData(m_vertexBuffer, allocation.baseVertex * vertexSize, vertices.size() * vertexSize, m_quantizedScratch.data());
+        glNamedBufferSubData(
+            m_positionBuffer, allocation.baseVertex * positionSize, vertices.size() * positionSize, m_quantizedPositionScratch.data());
+    }
+
+    void GeometryArena_OpenGL::writeIndices(const Allocation& allocation, const std::vector<u32>& indices)
+    {
+        if (allocation.indexType == IndexType::eU32)
+        {
+            glNamedBufferSubData(m_indexBuffer, allocation.firstIndex * sizeof(u32), indices.size() * sizeof(u32), indices.data());
+            return;
+        }
+
+        m_indexScratch.resize(indices.size());
+        for (size i = 0; i < indices.size(); ++i)
+        {
+            m_indexScratch[i] = static_cast<u16>(indices[i]);
+        }
+        glNamedBufferSubData(
+            m_indexBuffer, allocation.firstIndex * sizeof(u16), m_indexScratch.size() * sizeof(u16), m_indexScratch.data());
+    }
+}
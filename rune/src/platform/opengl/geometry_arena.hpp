@@ -0,0 +1,116 @@
+// # Copyright  Stuart Millman <stu.millman15@gmail.com>
+
+#pragma once
+
+#include "rune/defines.hpp"
+#include "rune/graphics/vertex.hpp"
+#include "rune/graphics/mesh.hpp"
+#include "rune/utility/range_allocator.hpp"
+
+#include <glad/glad.h>
+
+#include <array>
+#include <unordered_map>
+#include <vector>
+
+namespace Rune
+{
+    /**
+     * Vertex and index data for all meshes, sub-allocated from one vertex buffer and one index buffer that share a single VAO.
+     * Meshes are drawn using their baseVertex and firstIndex offsets, so switching mesh does not require binding GL objects.
+     *
+     * Positions are also kept in a separate tightly packed stream with its own VAO, for depth-only passes that would
+     * otherwise fetch whole vertices to read only their positions.
+     *
+     * The index buffer holds both 16bit and 32bit indices. It is allocated in 16bit slots, and 32bit allocations are aligned
+     * to 4 bytes, so each allocation's firstIndex is in units of its own index type.
+     *
+     * Vertices are stored the same way: the vertex buffers are allocated in slots of one quantized vertex, full vertices take
+     * two aligned slots, and each vertex format has its own VAOs over the shared buffers.
+     */
+    class GeometryArena_OpenGL
+    {
+    public:
+        struct Allocation
+        {
+            u32 baseVertex = 0;
+            u32 vertexCount = 0;
+            VertexFormat vertexFormat = VertexFormat::eFull;
+
+            /* Range taken from the vertex allocator, in quantized vertex slots. May start before baseVertex for alignment. */
+            u32 firstVertexSlot = 0;
+            u32 vertexSlotCount = 0;
+
+            u32 firstIndex = 0;
+            u32 indexCount = 0;
+            IndexType indexType = IndexType::eU16;
+
+            /* Range taken from the index allocator, in 16bit slots. May start before firstIndex for alignment. */
+            u32 firstIndexSlot = 0;
+            u32 indexSlotCount = 0;
+        };
+
+    public:
+        void init(u32 vertexCapacity, u32 indexCapacity);
+        void cleanup();
+
+        auto allocate(const std::vector<Vertex>& vertices,
+                      const VertexEncoding& encoding,
+                      const std::vector<u32>& indices,
+                      IndexType indexType) -> u32;
+        void free(u32 id);
+
+        void updateVertices(u32 id, const std::vector<Vertex>& vertices, const VertexEncoding& encoding);
+        void updateIndices(u32 id, const std::vector<u32>& indices, IndexType indexType);
+
+        auto get(u32 id) const -> const Allocation&;
+
+        auto getVao(VertexFormat format) const -> GLuint;
+        /**
+         * @return VAO with only the position stream at location 0. Uses the same baseVertex/firstIndex offsets as getVao().
+         */
+        auto getPositionVao(VertexFormat format) const -> GLuint;
+
+        /**
+         * Move all allocations together if enough space has been left between them by freed meshes.
+         * Allocations keep their ids, only their offsets change.
+         */
+        void compactIfFragmented();
+
+    private:
+        auto allocateVertexSlots(u32 count) -> u32;
+        auto allocateIndexSlots(u32 count) -> u32;
+
+        void growVertexBuffer(u32 minCapacity);
+        void growIndexBuffer(u32 minCapacity);
+        void compact();
+
+        void createVertexBuffer(u32 capacity);
+        void createIndexBuffer(u32 capacity);
+
+        void setupVaos(VertexFormat format);
+
+        void writeVertices(const Allocation& allocation, const std::vector<Vertex>& vertices, const VertexEncoding& encoding);
+        void writeIndices(const Allocation& allocation, const std::vector<u32>& indices);
+
+    private:
+        /* Indexed by VertexFormat */
+        std::array<GLuint, 2> m_vaos{};
+        std::array<GLuint, 2> m_positionVaos{};
+
+        GLuint m_vertexBuffer = 0;
+        GLuint m_positionBuffer = 0;
+        GLuint m_indexBuffer = 0;
+
+        std::vector<glm::vec3> m_positionScratch;
+        std::vector<QuantizedVertex> m_quantizedScratch;
+        std::vector<u16> m_quantizedPositionScratch;
+        std::vector<u16> m_indexScratch;
+
+        RangeAllocator m_vertexAllocator;
+        RangeAllocator m_indexAllocator;
+
+        std::unordered_map<u32, Allocation> m_allocations;
+        u32 m_nextAllocationId = 1;
+    };
+}
@@ -0,0 +1,182 @@
+// # Copyright  Stuart Millman <stu.millman15@gmail.com>
+
+#include "pch.hpp"
+#include "program_cache.hpp"
+
+#include "rune/macros.hpp"
+#include "rune/utility/hash.hpp"
+
+#include <spdlog/fmt/fmt.h>
+
+#include <fstream>
+
+namespace Rune
+{
+    namespace
+    {
+        constexpr u32 BinaryMagic = 0x50524E52;  // "RNRP"
+        constexpr u32 BinaryVersion = 1;
+
+        /* Written before the program binary in each cache file */
+        struct BinaryHeader
+        {
+            u32 magic;
+            u32 version;
+            u64 driverHash;
+            u64 key;
+            u32 binaryFormat;
+            u32 binarySize;
+        };
+
+        auto getString(const GLenum name) -> std::string
+        {
+            const auto* string = reinterpret_cast<const char*>(glGetString(name));
+            return string != nullptr ? string : "";
+        }
+    }
+
+    void ProgramCache_OpenGL::init()
+    {
+        // Binaries are only valid for the driver build that produced them, which the version string identifies
+        const auto driver = getString(GL_VENDOR) + '\n' + getString(GL_RENDERER) + '\n' + getString(GL_VERSION);
+        m_driverHash = Hash::fnv1a(driver.data(), driver.size());
+
+        GLint binaryFormatCount = 0;
+        glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &binaryFormatCount);
+        m_binariesSupported = binaryFormatCount > 0;
+        if (!m_binariesSupported)
+            CORE_LOG_WARN("Driver does not support program binaries, programs will not be cached on disk");
+    }
+
+    void ProgramCache_OpenGL::cleanup()
+    {
+        for (const auto& [program, entry] : m_programs)
+        {
+            glDeleteProgram(program);
+        }
+        m_programs.clear();
+        m_keyPrograms.clear();
+    }
+
+    void ProgramCache_OpenGL::setDirectory(const std::string& directory)
+    {
+        m_directory = directory;
+    }
+
+    auto ProgramCache_OpenGL::getKey(const std::vector<u8>& vertexCode, const std::vector<u8>& fragmentCode) -> u64
+    {
+        // Sizes keep the boundary between the stages, so code moving from one to the other changes the key
+        const u64 vertexCodeSize = vertexCode.size();
+        u64 key = Hash::fnv1a(&vertexCodeSize, sizeof(vertexCodeSize));
+        key = Hash::fnv1a(vertexCode.data(), vertexCode.size(), key);
+        key = Hash::fnv1a(fragmentCode.data(), fragmentCode.size(), key);
+
+        // Shaders are specialized with no constants, so there is nothing more to hash until materials can set them
+        return key;
+    }
+
+    auto ProgramCache_OpenGL::acquire(const u64 key) -> GLuint
+    {
+        const auto it = m_keyPrograms.find(key);
+        if (it == m_keyPrograms.end())
+            return 0;
+
+        ++m_programs[it->second].refCount;
+        return it->second;
+    }
+
+    auto ProgramCache_OpenGL::loadBinary(const u64 key) -> GLuint
+    {
+        if (!m_binariesSupported || m_directory.empty())
+            return 0;
+
+        std::ifstream file(getBinaryPath(key), std::ios::binary);
+        if (!file.is_open())
+            return 0;
+
+        BinaryHeader header{};
+        file.read(reinterpret_cast<char*>(&header), sizeof(header));
+        if (!file || header.magic != BinaryMagic || header.version != BinaryVersion || header.driverHash != m_driverHash ||
+            header.key != key)
+            return 0;
+
+        std::vector<u8> binary(header.binarySize);
+        file.read(reinterpret_cast<char*>(binary.data()), static_cast<std::streamsize>(binary.size()));
+        if (!file)
+            return 0;
+
+        // Drivers can still reject a binary from the same version, eg. when the hardware changed, so it must have linked
+        const GLuint program = glCreateProgram();
+        glProgramBinary(program, header.binaryFormat, binary.data(), static_cast<GLsizei>(binary.size()));
+
+        GLint linked = GL_FALSE;
+        glGetProgramiv(program, GL_LINK_STATUS, &linked);
+        if (linked != GL_TRUE)
+        {
+            glDeleteProgram(program);
+            return 0;
+        }
+
+        m_keyPrograms[key] = program;
+        m_programs[program] = { key, 1 };
+        return program;
+    }
+
+    void ProgramCache_OpenGL::add(const u64 key, const GLuint program)
+    {
+        RUNE_ENG_ASSERT(!m_keyPrograms.contains(key), "Program is already cached!");
+
+        m_keyPrograms[key] = program;
+        m_programs[program] = { key, 1 };
+
+        GLint linked = GL_FALSE;
+        glGetProgramiv(program, GL_LINK_STATUS, &linked);
+        if (linked == GL_TRUE && m_binariesSupported && !m_directory.empty())
+            saveBinary(key, program);
+    }
+
+    void ProgramCache_OpenGL::release(const GLuint program)
+    {
+        const auto it = m_programs.find(program);
+        RUNE_ENG_ASSERT(it != m_programs.end(), "Program is not cached!");
+
+        if (--it->second.refCount > 0)
+            return;
+
+        m_keyPrograms.erase(it->second.key);
+        m_programs.erase(it);
+        glDeleteProgram(program);
+    }
+
+    void ProgramCache_OpenGL::saveBinary(const u64 key, const GLuint program) const
+    {
+        GLint binarySize = 0;
+        glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &binarySize);
+        if (binarySize <= 0)
+            return;
+
+        std::vector<u8> binary(static_cast<size>(binarySize));
+        GLenum binaryFormat = 0;
+        glGetProgramBinary(program, binarySize, nullptr, &binaryFormat, binary.data());
+
+        std::error_code error;
+        std::filesystem::create_directories(m_directory, error);
+
+        const auto path = getBinaryPath(key);
+        std::ofstream file(path, std::ios::binary | std::ios::trunc);
+        if (!file.is_open())
+        {
+            CORE_LOG_WARN("Failed to write program binary '{}'", path.string());
+            return;
+        }
+
+        const BinaryHeader header{ BinaryMagic, BinaryVersion, m_driverHash, key, binaryFormat, static_cast<u32>(binarySize) };
+        file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        file.write(reinterpret_cast<const char*>(binary.data()), static_cast<std::streamsize>(binary.size()));
+    }
+
+    auto ProgramCache_OpenGL::getBinaryPath(const u64 key) const -> std::filesystem::path
+    {
+        return std::filesystem::path(m_directory) / fmt::format("{:016x}.bin", key);
+    }
+}
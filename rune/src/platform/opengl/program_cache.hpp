@@ -0,0 +1,79 @@
+// # Copyright  Stuart Millman <stu.millman15@gmail.com>
+
+#pragma once
+
+#include "rune/defines.hpp"
+
+#include <glad/glad.h>
+
+#include <filesystem>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace Rune
+{
+    /**
+     * Shares linked programs between materials created from the same shaders, and saves their binaries to disk so later runs
+     * can load them rather than compile the SPIR-V again. Binaries are only loaded by the driver that saved them.
+     */
+    class ProgramCache_OpenGL
+    {
+    public:
+        /**
+         * Identify the driver binaries must come from. Call once GL is loaded.
+         */
+        void init();
+        /**
+         * Delete every program, whether released or not.
+         */
+        void cleanup();
+
+        /**
+         * @param directory Binaries are saved to and loaded from here. Empty keeps programs in memory only.
+         */
+        void setDirectory(const std::string& directory);
+
+        /**
+         * @return Key of the program linked from the shaders, including the specialization constants they are linked with.
+         */
+        static auto getKey(const std::vector<u8>& vertexCode, const std::vector<u8>& fragmentCode) -> u64;
+
+        /**
+         * @return Program already in use with the key, shared with the caller until it releases it. 0 if there is none.
+         */
+        auto acquire(u64 key) -> GLuint;
+        /**
+         * Create a program from the binary saved for the key, held by the caller until it releases it.
+         * @return 0 if no binary was saved by this driver, or the driver rejects it.
+         */
+        auto loadBinary(u64 key) -> GLuint;
+        /**
+         * Share a program just linked for the key, held by the caller until it releases it. Its binary is saved if it linked.
+         * The program must have been linked with GL_PROGRAM_BINARY_RETRIEVABLE_HINT set for the binary to be saved.
+         */
+        void add(u64 key, GLuint program);
+        /**
+         * Deletes the program once every holder has released it.
+         */
+        void release(GLuint program);
+
+    private:
+        void saveBinary(u64 key, GLuint program) const;
+        auto getBinaryPath(u64 key) const -> std::filesystem::path;
+
+    private:
+        struct Entry
+        {
+            u64 key;
+            u32 refCount;
+        };
+
+        std::unordered_map<u64, GLuint> m_keyPrograms;
+        std::unordered_map<GLuint, Entry> m_programs;
+
+        std::string m_directory;
+        u64 m_driverHash = 0;  // Of the vendor, renderer and version strings
+        bool m_binariesSupported = false;
+    };
+}
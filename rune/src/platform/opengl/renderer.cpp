@@ -5,6 +5,8 @@
 
 #include "rune/macros.hpp"
 #include "rune/graphics/material.hpp"
+#include "rune/graphics/mesh.hpp"
+#include "rune/graphics/texture_array.hpp"
 
 #include <glad/glad.h>
 #include <GLFW/glfw3.h>
@@ -15,6 +17,61 @@ namespace Rune
 {
     namespace
     {
+        /* Initial size of each frame's region in the frame ring buffer. Grows if a frame uses more. */
+        constexpr size FrameRingBufferRegionSize = 4 * 1024 * 1024;
+
+        /* Initial capacity of the geometry arena, vertices in quantized vertex slots. Grows if more is needed. */
+        constexpr u32 GeometryArenaVertexCapacity = 512 * 1024;
+        constexpr u32 GeometryArenaIndexCapacity = 1024 * 1024;
+
+        /* Slope-scaled depth bias applied while rendering shadow maps, to avoid shadow acne */
+        constexpr f32 ShadowSlopeBias = 2.0f;
+        constexpr f32 ShadowConstantBias = 4.0f;
+
+        /* Pushes depth pre-pass values back by a few ulps, so main pass fragments still pass LEQUAL if their depth differs slightly */
+        constexpr f32 DepthPrePassSlopeBias = 1.0f;
+        constexpr f32 DepthPrePassConstantBias = 4.0f;
+
+        /*
+         * Depth-only passes need nothing but positions, read with the same scene and instance bindings as materials.
+         * Positions are transformed with the same expressions as material vertex shaders, and gl_Position is declared invariant here and
+         * in every material vertex shader. Invariance is only guaranteed between programs from the same compiler though, and this one
+         * is compiled from GLSL while materials are SPIR-V, so the depth pre-pass also applies a small polygon offset (see
+         * DepthPrePassSlopeBias). That offset is what the main pass relies on to pass LEQUAL against pre-pass depth.
+         */
+        constexpr const char* DepthVertexSource = R"(#version 460 core
+layout (location = 0) in vec3 a_pos;
+
+invariant gl_Position;
+
+layout(std140, binding = 0) uniform Scene
+{
+    mat4 projMatrix;
+    mat4 viewMatrix;
+    mat4 worldMatrix;
+} u_scene;
+
+struct Instance
+{
+    mat4 worldMatrix;
+    vec4 positionScale;
+    vec4 positionOffset;
+};
+
+layout(std430, binding = 4) readonly buffer Instances
+{
+    Instance instances[];
+} u_instances;
+
+void main()
+{
+    Instance instance = u_instances.instances[gl_BaseInstance + gl_InstanceID];
+    vec3 pos = instance.positionOffset.xyz + a_pos * instance.positionScale.xyz;
+    vec3 worldPos = vec3(instance.worldMatrix * vec4(pos, 1.0));
+    gl_Position = u_scene.projMatrix * u_scene.viewMatrix * vec4(worldPos, 1.0);
+}
+)";
+
         void checkForShaderError(const u32 shader)
         {
             int success;
@@ -93,6 +150,10 @@ namespace Rune
         }
 #endif
 
+        /* From EXT_texture_compression_s3tc, which the loader is not generated with */
+        constexpr GLint CompressedRgbS3tcDxt1 = 0x83F0;
+        constexpr GLint CompressedRgbaS3tcDxt5 = 0x83F3;
+
         auto toGLInternalTextureFormat(const TextureFormat format) -> GLint
         {
             switch (format)
@@ -100,6 +161,11 @@ namespace Rune
                 case TextureFormat::eR: return GL_R8;
                 case TextureFormat::eRGB: return GL_RGB8;
                 case TextureFormat::eRGBA: return GL_RGBA8;
+                case TextureFormat::eBC1: return CompressedRgbS3tcDxt1;
+                case TextureFormat::eBC3: return CompressedRgbaS3tcDxt5;
+                case TextureFormat::eBC4: return GL_COMPRESSED_RED_RGTC1;
+                case TextureFormat::eBC5: return GL_COMPRESSED_RG_RGTC2;
+                case TextureFormat::eBC7: return GL_COMPRESSED_RGBA_BPTC_UNORM;
                 case TextureFormat::eUnknown: return 0;
             }
             return 0;
@@ -112,6 +178,11 @@ namespace Rune
                 case TextureFormat::eR: return GL_RED;
                 case TextureFormat::eRGB: return GL_RGB;
                 case TextureFormat::eRGBA: return GL_RGBA;
+                case TextureFormat::eBC1:
+                case TextureFormat::eBC3:
+                case TextureFormat::eBC4:
+                case TextureFormat::eBC5:
+                case TextureFormat::eBC7:
                 case TextureFormat::eUnknown: return 0;
             }
             return 0;
@@ -127,6 +198,33 @@ namespace Rune
             }
             return GL_NONE;
         }
+
+        auto toGLIndexType(const IndexType indexType) -> GLenum
+        {
+            return indexType == IndexType::eU32 ? GL_UNSIGNED_INT : GL_UNSIGNED_SHORT;
+        }
+
+        auto getIndexOffset(const IndexType indexType, const u32 firstIndex) -> const void*
+        {
+            return reinterpret_cast<const void*>(static_cast<uintptr_t>(firstIndex) * getIndexSize(indexType));
+        }
+
+        auto countTriangles(const GLenum topology, const u32 indexCount, const u32 instanceCount) -> u64
+        {
+            if (topology != GL_TRIANGLES)
+                return 0;
+
+            return static_cast<u64>(indexCount / 3) * instanceCount;
+        }
+
+        auto compileShader(const GLenum type, const char* source) -> GLuint
+        {
+            GLuint shader = glCreateShader(type);
+            glShaderSource(shader, 1, &source, nullptr);
+            glCompileShader(shader);
+            checkForShaderError(shader);
+            return shader;
+        }
     }
 
     auto Renderer_OpenGL::create() -> Owned<RendererBase>
@@ -148,11 +246,41 @@ namespace Rune
         glDebugMessageCallback(openglMessageCallback, nullptr);
 #endif
 
-        glEnable(GL_DEPTH_TEST);
+        m_stateCache.reset();
+        m_stateCache.setDepthTest(true);
+
+        // Less-or-equal so draws pass against the depth a depth pre-pass laid down for them
+        glDepthFunc(GL_LEQUAL);
+
+        // Translucent materials enable blending, always with straight alpha
+        glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+
+        // Shadow passes render to their own framebuffer, so remember the window's size to restore it after
+        GLint viewport[4];
+        glGetIntegerv(GL_VIEWPORT, viewport);
+        m_framebufferSize = { viewport[2], viewport[3] };
+
+        // Without a fragment shader only depth is written, which is all depth-only passes need
+        GLuint depthVertShader = compileShader(GL_VERTEX_SHADER, DepthVertexSource);
+        m_depthProgram = glCreateProgram();
+        glAttachShader(m_depthProgram, depthVertShader);
+        glLinkProgram(m_depthProgram);
+        checkForProgramError(m_depthProgram);
+        glDeleteShader(depthVertShader);
+
+        m_geometryArena.init(GeometryArenaVertexCapacity, GeometryArenaIndexCapacity);
+        m_frameRingBuffer.init(FrameRingBufferRegionSize);
+        m_programCache.init();
     }
 
     void Renderer_OpenGL::cleanup()
     {
+        glDeleteProgram(m_depthProgram);
+        m_depthProgram = 0;
+
+        m_frameRingBuffer.cleanup();
+        m_geometryArena.cleanup();
+        m_programCache.cleanup();
         // TODO: Destroy resources
     }
 
@@ -160,6 +288,7 @@ namespace Rune
 
     void Renderer_OpenGL::onFramebufferSize(const i32 width, const i32 height)
     {
+        m_framebufferSize = { width, height };
         glViewport(0, 0, width, height);
     }
 
@@ -170,6 +299,8 @@ namespace Rune
 
         glCreateBuffers(1, &buffer.buffer);
         glNamedBufferData(buffer.buffer, size, data, GL_STATIC_DRAW);
+        if (data != nullptr)
+            m_frameStats.bytesUploaded += size;
 
         return m_bufferStorage.add(buffer);
     }
@@ -179,48 +310,67 @@ namespace Rune
         auto& buffer = m_bufferStorage.get(id);
         glDeleteBuffers(1, &buffer.buffer);
 
+        // GL may hand the name out again, so cached bindings referencing it can no longer be trusted
+        m_stateCache.reset();
+
         m_bufferStorage.remove(id);
     }
 
-    void Renderer_OpenGL::updateBuffer(const u32 id, size offset, size size, const void* data)
+    void Renderer_OpenGL::updateBuffer(const u32 id, const size offset, const size size, const void* data)
     {
         auto& buffer = m_bufferStorage.get(id);
 
-        glNamedBufferData(buffer.buffer, size, data, GL_STATIC_DRAW);
+        if (offset + size <= static_cast<std::size_t>(buffer.size))
+        {
+            glNamedBufferSubData(buffer.buffer, offset, size, data);
+        }
+        else
+        {
+            // Buffer has to grow, which means reallocating its storage
+            RUNE_ENG_ASSERT(offset == 0, "Can only grow a buffer when updating it from the start!");
+            glNamedBufferData(buffer.buffer, size, data, GL_STATIC_DRAW);
+            buffer.size = size;
+        }
+        m_frameStats.bytesUploaded += size;
     }
 
-    auto Renderer_OpenGL::createMesh(const std::vector<Vertex>& vertices, const std::vector<u16>& indices, const MeshTopology topology)
-        -> u32
+    void Renderer_OpenGL::updateBufferRanges(const std::vector<BufferRangeUpdate>& ranges, const void* data, const size dataSize)
     {
-        Mesh mesh{};
-
-        mesh.topology = toGLTopology(topology);
-        mesh.indexCount = indices.size();
-
-        glCreateVertexArrays(1, &mesh.vao);
-
-        mesh.indexBuffer = createBuffer(indices.size() * sizeof(u16), indices.data());
-        mesh.vertexBuffer = createBuffer(vertices.size() * sizeof(Vertex), vertices.data());
-
-        auto& ibo = m_bufferStorage.get(mesh.indexBuffer);
-        auto& vbo = m_bufferStorage.get(mesh.vertexBuffer);
+        if (ranges.empty())
+            return;
 
-        // Assign buffers to Vertex Buffer Object
-        glVertexArrayElementBuffer(mesh.vao, ibo.buffer);
-        glVertexArrayVertexBuffer(mesh.vao, 0, vbo.buffer, 0, sizeof(Vertex));
+        // Staged through the frame ring buffer in one write, then copied into place on the GPU
+        const auto staging = m_frameRingBuffer.write(data, dataSize);
+        for (const auto& range : ranges)
+        {
+            const auto& buffer = m_bufferStorage.get(range.bufferId);
+            RUNE_ENG_ASSERT(static_cast<size>(range.byteOffset) + range.byteSize <= static_cast<size>(buffer.size),
+                            "Buffer range update overflow!");
+            glCopyNamedBufferSubData(
+                staging.buffer, buffer.buffer, staging.byteOffset + range.dataOffset, range.byteOffset, range.byteSize);
+        }
+        m_frameStats.bytesUploaded += dataSize;
+    }
 
-        // Setup attributes
-        glEnableVertexArrayAttrib(mesh.vao, 0);
-        glVertexArrayAttribBinding(mesh.vao, 0, 0);
-        glVertexArrayAttribFormat(mesh.vao, 0, 3, GL_FLOAT, GL_FALSE, offsetof(Vertex, pos));
+    auto Renderer_OpenGL::uploadFrameData(const void* data, const size size) -> FrameDataRange
+    {
+        m_frameStats.bytesUploaded += size;
+        const auto allocation = m_frameRingBuffer.write(data, size);
+        return { allocation.byteOffset, size, allocation.buffer };
+    }
 
-        glEnableVertexArrayAttrib(mesh.vao, 1);
-        glVertexArrayAttribBinding(mesh.vao, 1, 0);
-        glVertexArrayAttribFormat(mesh.vao, 1, 2, GL_FLOAT, GL_FALSE, offsetof(Vertex, uv));
+    auto Renderer_OpenGL::createMesh(const std::vector<Vertex>& vertices,
+                                     const std::vector<u32>& indices,
+                                     const IndexType indexType,
+                                     const VertexEncoding& encoding,
+                                     const MeshTopology topology) -> u32
+    {
+        Mesh mesh{};
 
-        glEnableVertexArrayAttrib(mesh.vao, 2);
-        glVertexArrayAttribBinding(mesh.vao, 2, 0);
-        glVertexArrayAttribFormat(mesh.vao, 2, 3, GL_FLOAT, GL_FALSE, offsetof(Vertex, norm));
+        mesh.topology = toGLTopology(topology);
+        mesh.geometry = m_geometryArena.allocate(vertices, encoding, indices, indexType);
+        m_frameStats.bytesUploaded += vertices.size() * (getVertexSize(encoding.format) + getPositionSize(encoding.format)) +
+                                      indices.size() * getIndexSize(indexType);
 
         return m_meshStorage.add(mesh);
     }
@@ -228,30 +378,48 @@ namespace Rune
     void Renderer_OpenGL::destroyMesh(const u32 id)
     {
         auto& mesh = m_meshStorage.get(id);
+        m_geometryArena.free(mesh.geometry);
 
-        destroyBuffer(mesh.vertexBuffer);
-        destroyBuffer(mesh.indexBuffer);
+        if (m_boundMesh == &mesh)
+            m_boundMesh = nullptr;
 
-        glDeleteVertexArrays(1, &mesh.vao);
         m_meshStorage.remove(id);
     }
 
-    void Renderer_OpenGL::updateMeshVertices(const u32 id, const std::vector<Vertex>& vertices)
+    void Renderer_OpenGL::updateMeshVertices(const u32 id, const std::vector<Vertex>& vertices, const VertexEncoding& encoding)
     {
         auto& mesh = m_meshStorage.get(id);
-        updateBuffer(mesh.vertexBuffer, 0, sizeof(Vertex) * vertices.size(), vertices.data());
+        m_geometryArena.updateVertices(mesh.geometry, vertices, encoding);
+        m_frameStats.bytesUploaded += vertices.size() * (getVertexSize(encoding.format) + getPositionSize(encoding.format));
     }
 
-    void Renderer_OpenGL::updateMeshIndices(const u32 id, const std::vector<u16>& indices)
+    void Renderer_OpenGL::updateMeshIndices(const u32 id, const std::vector<u32>& indices, const IndexType indexType)
     {
         auto& mesh = m_meshStorage.get(id);
-        updateBuffer(mesh.indexBuffer, 0, sizeof(u16) * indices.size(), indices.data());
+        m_geometryArena.updateIndices(mesh.geometry, indices, indexType);
+        m_frameStats.bytesUploaded += indices.size() * getIndexSize(indexType);
     }
 
     auto Renderer_OpenGL::createMaterial(const std::vector<u8>& vertexCode, const std::vector<u8>& fragmentCode) -> u32
     {
         Material material{};
 
+        // Materials with the same shaders share a program, and programs linked by an earlier run are loaded from disk
+        const u64 programKey = ProgramCache_OpenGL::getKey(vertexCode, fragmentCode);
+        material.program = m_programCache.acquire(programKey);
+        if (material.program != 0)
+        {
+            ++m_frameStats.programCacheHits;
+            return m_materialStorage.add(material);
+        }
+
+        material.program = m_programCache.loadBinary(programKey);
+        if (material.program != 0)
+        {
+            ++m_frameStats.programBinaryLoads;
+            return m_materialStorage.add(material);
+        }
+
         GLuint vertShader = glCreateShader(GL_VERTEX_SHADER);
         glShaderBinary(1, &vertShader, GL_SHADER_BINARY_FORMAT_SPIR_V, vertexCode.data(), vertexCode.size() * sizeof(u8));
         glSpecializeShader(vertShader, "main", 0, nullptr, nullptr);
@@ -263,6 +431,7 @@ namespace Rune
         checkForShaderError(fragShader);
 
         material.program = glCreateProgram();
+        glProgramParameteri(material.program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
         glAttachShader(material.program, vertShader);
         glAttachShader(material.program, fragShader);
         glLinkProgram(material.program);
@@ -271,6 +440,12 @@ namespace Rune
         glDeleteShader(vertShader);
         glDeleteShader(fragShader);
 
+        m_programCache.add(programKey, material.program);
+        ++m_frameStats.programCacheMisses;
+
+        // Samplers take their texture unit from the layout binding in the SPIR-V when the program is linked,
+        // so unlike GLSL programs nothing needs assigning per bind.
+
         return m_materialStorage.add(material);
     }
 
@@ -278,64 +453,247 @@ namespace Rune
     {
         auto& material = m_materialStorage.get(id);
 
-        glDeleteProgram(material.program);
+        m_programCache.release(material.program);
+        m_stateCache.reset();
 
         m_materialStorage.remove(id);
     }
 
-    auto Renderer_OpenGL::createTexture(const u32 width, const u32 height, const TextureFormat format, const void* data) -> u32
+    void Renderer_OpenGL::setProgramCacheDirectory(const std::string& directory)
     {
-        Texture texture{};
+        m_programCache.setDirectory(directory);
+    }
 
-        glCreateTextures(GL_TEXTURE_2D, 1, &texture.texture);
+    auto Renderer_OpenGL::createTexture(const u32 width, const u32 height, const TextureFormat format, const u32 mipCount) -> u32
+    {
+        // Storage is only created once mips are made resident
+        return m_textureStorage.add({ 0, width, height, format, mipCount, mipCount });
+    }
 
-        glTextureParameteri(texture.texture, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-        glTextureParameteri(texture.texture, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-        glTextureParameteri(texture.texture, GL_TEXTURE_WRAP_S, GL_REPEAT);
-        glTextureParameteri(texture.texture, GL_TEXTURE_WRAP_T, GL_REPEAT);
+    void Renderer_OpenGL::destroyTexture(const u32 id)
+    {
+        auto& texture = m_textureStorage.get(id);
+        glDeleteTextures(1, &texture.texture);
+        m_stateCache.reset();
 
-        auto internalFormat = toGLInternalTextureFormat(format);
-        auto dataFormat = toGLTextureFormat(format);
+        m_textureStorage.remove(id);
+    }
 
-        glTextureStorage2D(texture.texture, 1, internalFormat, width, height);
-        glTextureSubImage2D(texture.texture, 0, 0, 0, width, height, dataFormat, GL_UNSIGNED_BYTE, data);
+    void Renderer_OpenGL::uploadTextureMip(const u32 id, const u32 mip, const void* data)
+    {
+        const auto& texture = m_textureStorage.get(id);
+        RUNE_ENG_ASSERT(mip >= texture.residentMip, "Texture mip is not resident");
 
-        glGenerateTextureMipmap(texture.texture);
+        const u32 mipWidth = getMipLevelSize(texture.width, mip);
+        const u32 mipHeight = getMipLevelSize(texture.height, mip);
+        const auto dataSize = getTextureDataSize(texture.format, mipWidth, mipHeight);
+        const auto level = static_cast<GLint>(mip - texture.residentMip);
 
-        return m_textureStorage.add(texture);
+        // Mips were built at import, the driver cannot generate them for block compressed formats
+        if (isCompressed(texture.format))
+        {
+            glCompressedTextureSubImage2D(texture.texture,
+                                          level,
+                                          0,
+                                          0,
+                                          mipWidth,
+                                          mipHeight,
+                                          toGLInternalTextureFormat(texture.format),
+                                          static_cast<GLsizei>(dataSize),
+                                          data);
+        }
+        else
+        {
+            // Rows of small mips are tightly packed, not 4 byte aligned
+            glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+            const auto dataFormat = toGLTextureFormat(texture.format);
+            glTextureSubImage2D(texture.texture, level, 0, 0, mipWidth, mipHeight, dataFormat, GL_UNSIGNED_BYTE, data);
+            glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+        }
+        m_frameStats.bytesUploaded += dataSize;
     }
 
-    void Renderer_OpenGL::destroyTexture(const u32 id)
+    void Renderer_OpenGL::setTextureResidentMip(const u32 id, const u32 mip)
     {
         auto& texture = m_textureStorage.get(id);
+        if (mip == texture.residentMip)
+            return;
+
+        // Immutable storage cannot shrink or grow, so a new texture holding only the resident mips replaces it
+        GLuint newTexture;
+        glCreateTextures(GL_TEXTURE_2D, 1, &newTexture);
+
+        const u32 levelCount = texture.mipCount - mip;
+        glTextureParameteri(newTexture, GL_TEXTURE_MIN_FILTER, levelCount > 1 ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR);
+        glTextureParameteri(newTexture, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glTextureParameteri(newTexture, GL_TEXTURE_WRAP_S, GL_REPEAT);
+        glTextureParameteri(newTexture, GL_TEXTURE_WRAP_T, GL_REPEAT);
+        glTextureStorage2D(newTexture,
+                           static_cast<GLsizei>(levelCount),
+                           toGLInternalTextureFormat(texture.format),
+                           getMipLevelSize(texture.width, mip),
+                           getMipLevelSize(texture.height, mip));
+
+        // Mips resident in both are copied on the GPU rather than uploaded again
+        for (u32 copyMip = std::max(mip, texture.residentMip); copyMip < texture.mipCount; ++copyMip)
+        {
+            glCopyImageSubData(texture.texture,
+                               GL_TEXTURE_2D,
+                               static_cast<GLint>(copyMip - texture.residentMip),
+                               0,
+                               0,
+                               0,
+                               newTexture,
+                               GL_TEXTURE_2D,
+                               static_cast<GLint>(copyMip - mip),
+                               0,
+                               0,
+                               0,
+                               getMipLevelSize(texture.width, copyMip),
+                               getMipLevelSize(texture.height, copyMip),
+                               1);
+        }
+
         glDeleteTextures(1, &texture.texture);
+        m_stateCache.forgetTexture(texture.texture);
+        texture.texture = newTexture;
+        texture.residentMip = mip;
 
-        m_textureStorage.remove(id);
+        // The bound material instance may sample the old texture, so it must bind its textures again
+        m_boundMaterialInst = nullptr;
+    }
+
+    auto Renderer_OpenGL::createTextureArray(
+        const u32 width, const u32 height, const TextureFormat format, const u32 mipCount, const u32 layerCount) -> u32
+    {
+        GLuint texture;
+        glCreateTextures(GL_TEXTURE_2D_ARRAY, 1, &texture);
+        glTextureParameteri(texture, GL_TEXTURE_MIN_FILTER, mipCount > 1 ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR);
+        glTextureParameteri(texture, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glTextureParameteri(texture, GL_TEXTURE_WRAP_S, GL_REPEAT);
+        glTextureParameteri(texture, GL_TEXTURE_WRAP_T, GL_REPEAT);
+        glTextureStorage3D(texture,
+                           static_cast<GLsizei>(mipCount),
+                           toGLInternalTextureFormat(format),
+                           static_cast<GLsizei>(width),
+                           static_cast<GLsizei>(height),
+                           static_cast<GLsizei>(layerCount));
+
+        return m_textureArrayStorage.add({ texture, width, height, format });
+    }
+
+    void Renderer_OpenGL::destroyTextureArray(const u32 id)
+    {
+        auto& textureArray = m_textureArrayStorage.get(id);
+        glDeleteTextures(1, &textureArray.texture);
+        m_stateCache.reset();
+
+        m_textureArrayStorage.remove(id);
+    }
+
+    void Renderer_OpenGL::uploadTextureArrayMip(const u32 id, const u32 layer, const u32 mip, const void* data)
+    {
+        const auto& textureArray = m_textureArrayStorage.get(id);
+
+        const u32 mipWidth = getMipLevelSize(textureArray.width, mip);
+        const u32 mipHeight = getMipLevelSize(textureArray.height, mip);
+        const auto dataSize = getTextureDataSize(textureArray.format, mipWidth, mipHeight);
+        const auto level = static_cast<GLint>(mip);
+        const auto zOffset = static_cast<GLint>(layer);
+
+        if (isCompressed(textureArray.format))
+        {
+            glCompressedTextureSubImage3D(textureArray.texture,
+                                          level,
+                                          0,
+                                          0,
+                                          zOffset,
+                                          mipWidth,
+                                          mipHeight,
+                                          1,
+                                          toGLInternalTextureFormat(textureArray.format),
+                                          static_cast<GLsizei>(dataSize),
+                                          data);
+        }
+        else
+        {
+            glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+            const auto dataFormat = toGLTextureFormat(textureArray.format);
+            glTextureSubImage3D(textureArray.texture, level, 0, 0, zOffset, mipWidth, mipHeight, 1, dataFormat, GL_UNSIGNED_BYTE, data);
+            glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+        }
+        m_frameStats.bytesUploaded += dataSize;
     }
 
     void Renderer_OpenGL::beginFrame()
     {
+        // A translucent draw at the end of the last frame leaves depth writes off, which would stop the clear
+        m_stateCache.setDepthWrite(true);
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
         glClearColor(0.3912f, 0.5843f, 0.9294f, 1.0f);  // Cornflower Blue
+
+        // Instances may have had their textures changed since the last frame
+        m_boundMaterialInst = nullptr;
+
+        // Compact between frames so mesh offsets stay fixed while drawing
+        m_geometryArena.compactIfFragmented();
+
+        // Every mesh lives in the geometry arena, so its VAOs (one per vertex format) are the only ones ever bound
+        bindGeometryVao(VertexFormat::eFull);
     }
 
-    void Renderer_OpenGL::endFrame() {}
+    void Renderer_OpenGL::endFrame()
+    {
+        m_frameRingBuffer.nextFrame();
+
+        // Ring buffers replaced by a larger one may have been deleted, and GL can hand their names out again
+        m_stateCache.reset();
+
+        m_frameStats.redundantCallsSkipped = m_stateCache.takeSkippedCount();
+        finishFrameStats();
+    }
 
     void Renderer_OpenGL::bindUniformBuffer(const u32 id, const u32 binding)
     {
         auto& buffer = m_bufferStorage.get(id);
-        glBindBufferBase(GL_UNIFORM_BUFFER, binding, buffer.buffer);
+        if (m_stateCache.bindBufferBase(GL_UNIFORM_BUFFER, binding, buffer.buffer))
+            ++m_frameStats.uniformBufferBinds;
+    }
+
+    void Renderer_OpenGL::bindStorageBuffer(const u32 id, const u32 binding)
+    {
+        auto& buffer = m_bufferStorage.get(id);
+        if (m_stateCache.bindBufferBase(GL_SHADER_STORAGE_BUFFER, binding, buffer.buffer))
+            ++m_frameStats.storageBufferBinds;
+    }
+
+    void Renderer_OpenGL::bindFrameUniformBuffer(const FrameDataRange& range, const u32 binding)
+    {
+        if (m_stateCache.bindBufferRange(GL_UNIFORM_BUFFER, binding, range.buffer, range.byteOffset, range.byteSize))
+            ++m_frameStats.uniformBufferBinds;
+    }
+
+    void Renderer_OpenGL::bindFrameStorageBuffer(const FrameDataRange& range, const u32 binding)
+    {
+        if (m_stateCache.bindBufferRange(GL_SHADER_STORAGE_BUFFER, binding, range.buffer, range.byteOffset, range.byteSize))
+            ++m_frameStats.storageBufferBinds;
     }
 
     void Renderer_OpenGL::bindMaterial(MaterialInst* material)
     {
-        auto& internalMaterial = m_materialStorage.get(material->getMaterial()->getId());
-        if (m_boundMaterial == &internalMaterial)
+        if (m_boundMaterialInst == material)
             return;
 
-        glUseProgram(internalMaterial.program);
+        const auto* baseMaterial = material->getMaterial();
+        auto& internalMaterial = m_materialStorage.get(baseMaterial->getId());
+        if (m_stateCache.useProgram(internalMaterial.program))
+            ++m_frameStats.programBinds;
 
-        // TODO: Set state
+        // Fixed function state
+        m_stateCache.setDepthTest(baseMaterial->isDepthTested());
+        m_stateCache.setDepthWrite(!baseMaterial->isTranslucent());
+        m_stateCache.setCullFace(!baseMaterial->isDoubleSided());
+        m_stateCache.setBlend(baseMaterial->isTranslucent());
 
         // Uniform Buffers
         for (const auto& uniformBuffer : material->getUniformBuffers())
@@ -346,31 +704,285 @@ namespace Rune
         // Textures
         for (const auto& slot : material->getTextureSlots())
         {
-            auto& texture = m_textureStorage.get(slot.texture->getInternalId());
-            glBindTextureUnit(slot.binding, texture.texture);
-            glUniform1i(glGetUniformLocation(internalMaterial.program, slot.name.c_str()), slot.binding);
+            // Sampler units are fixed by the binding in the SPIR-V, so only the texture needs binding
+            GLuint texture;
+            if (slot.isArray)
+            {
+                // Arrays only exist once the material has packed its instances' textures
+                if (slot.textureArray == nullptr)
+                    continue;
+                texture = m_textureArrayStorage.get(slot.textureArray->getInternalId()).texture;
+            }
+            else
+                texture = m_textureStorage.get(slot.texture->getInternalId()).texture;
+
+            if (m_stateCache.bindTextureUnit(slot.binding, texture))
+                ++m_frameStats.textureBinds;
         }
 
         m_boundMaterial = &internalMaterial;
+        m_boundMaterialInst = material;
     }
 
-    void Renderer_OpenGL::bindMesh(Rune::Mesh* mesh)
+    void Renderer_OpenGL::bindMesh(Rune::Mesh* mesh, const u32 lod, const u32 submesh)
     {
         auto& internalMesh = m_meshStorage.get(mesh->getId());
-        if (m_boundMesh == &internalMesh)
-            return;
-
-        glBindVertexArray(internalMesh.vao);
-
         m_boundMesh = &internalMesh;
+        bindGeometryVao(m_geometryArena.get(internalMesh.geometry).vertexFormat);
+
+        const auto range = mesh->getIndexRange(lod, submesh);
+        m_boundFirstIndex = static_cast<u32>(range.firstIndex);
+        m_boundIndexCount = static_cast<u32>(range.indexCount);
     }
 
     void Renderer_OpenGL::draw()
     {
-        RUNE_ENG_ASSERT(m_boundMaterial != nullptr, "No material bound!");
+        RUNE_ENG_ASSERT(m_boundMaterial != nullptr || m_isDepthOnlyPass, "No material bound!");
+        RUNE_ENG_ASSERT(m_boundMesh != nullptr, "No mesh bound!");
+
+        const auto& geometry = m_geometryArena.get(m_boundMesh->geometry);
+        const auto* indexOffset = getIndexOffset(geometry.indexType, geometry.firstIndex + m_boundFirstIndex);
+        glDrawElementsBaseVertex(
+            m_boundMesh->topology, m_boundIndexCount, toGLIndexType(geometry.indexType), indexOffset, geometry.baseVertex);
+
+        ++m_frameStats.drawCalls;
+        ++m_frameStats.instances;
+        m_frameStats.triangles += countTriangles(m_boundMesh->topology, m_boundIndexCount, 1);
+    }
+
+    void Renderer_OpenGL::drawInstanced(const u32 instanceCount, const u32 firstInstance)
+    {
+        RUNE_ENG_ASSERT(m_boundMaterial != nullptr || m_isDepthOnlyPass, "No material bound!");
         RUNE_ENG_ASSERT(m_boundMesh != nullptr, "No mesh bound!");
 
-        glDrawElements(m_boundMesh->topology, m_boundMesh->indexCount, GL_UNSIGNED_SHORT, nullptr);
+        const auto& geometry = m_geometryArena.get(m_boundMesh->geometry);
+        const auto* indexOffset = getIndexOffset(geometry.indexType, geometry.firstIndex + m_boundFirstIndex);
+
+        // The base instance offsets gl_BaseInstance so the shader can index into the instance buffer
+        glDrawElementsInstancedBaseVertexBaseInstance(m_boundMesh->topology,
+                                                      m_boundIndexCount,
+                                                      toGLIndexType(geometry.indexType),
+                                                      indexOffset,
+                                                      instanceCount,
+                                                      geometry.baseVertex,
+                                                      firstInstance);
+
+        ++m_frameStats.drawCalls;
+        m_frameStats.instances += instanceCount;
+        m_frameStats.triangles += countTriangles(m_boundMesh->topology, m_boundIndexCount, instanceCount);
+    }
+
+    void Renderer_OpenGL::drawIndirect(const DrawCommand* commands, const u32 count)
+    {
+        RUNE_ENG_ASSERT(m_boundMaterial != nullptr || m_isDepthOnlyPass, "No material bound!");
+        if (count == 0)
+            return;
+
+        m_indirectCommands.resize(count);
+        m_indirectCommandFormats.resize(count);
+        for (u32 i = 0; i < count; ++i)
+        {
+            const auto& mesh = m_meshStorage.get(commands[i].mesh->getId());
+            const auto& geometry = m_geometryArena.get(mesh.geometry);
+            const auto range = commands[i].mesh->getIndexRange(commands[i].lod, commands[i].submesh);
+            m_indirectCommandFormats[i] = { mesh.topology, toGLIndexType(geometry.indexType), geometry.vertexFormat };
+
+            auto& indirectCommand = m_indirectCommands[i];
+            indirectCommand.count = static_cast<u32>(range.indexCount);
+            indirectCommand.instanceCount = commands[i].instanceCount;
+            indirectCommand.firstIndex = geometry.firstIndex + static_cast<u32>(range.firstIndex);
+            indirectCommand.baseVertex = static_cast<GLint>(geometry.baseVertex);
+            indirectCommand.baseInstance = commands[i].firstInstance;
+
+            m_frameStats.instances += commands[i].instanceCount;
+            m_frameStats.triangles += countTriangles(mesh.topology, indirectCommand.count, commands[i].instanceCount);
+        }
+
+        const auto commandsRange = uploadFrameData(m_indirectCommands.data(), count * sizeof(DrawElementsIndirectCommand));
+
+        m_stateCache.bindBuffer(GL_DRAW_INDIRECT_BUFFER, commandsRange.buffer);
+
+        // One multi-draw per run of commands sharing a topology, index type and vertex format
+        for (u32 runStart = 0; runStart < count;)
+        {
+            const auto& format = m_indirectCommandFormats[runStart];
+            u32 runEnd = runStart + 1;
+            while (runEnd < count && m_indirectCommandFormats[runEnd].topology == format.topology &&
+                   m_indirectCommandFormats[runEnd].indexType == format.indexType &&
+                   m_indirectCommandFormats[runEnd].vertexFormat == format.vertexFormat)
+                ++runEnd;
+
+            bindGeometryVao(format.vertexFormat);
+
+            const auto byteOffset = commandsRange.byteOffset + runStart * sizeof(DrawElementsIndirectCommand);
+            glMultiDrawElementsIndirect(
+                format.topology, format.indexType, reinterpret_cast<const void*>(static_cast<uintptr_t>(byteOffset)), runEnd - runStart, 0);
+            ++m_frameStats.drawCalls;
+
+            runStart = runEnd;
+        }
+
+        // Meshes are not bound by indirect draws
+        m_boundMesh = nullptr;
+    }
+
+    auto Renderer_OpenGL::createShadowMap(const u32 resolution, const u32 layerCount) -> u32
+    {
+        ShadowMap shadowMap{};
+        shadowMap.resolution = resolution;
+        shadowMap.layerCount = layerCount;
+
+        glCreateTextures(GL_TEXTURE_2D_ARRAY, 1, &shadowMap.texture);
+        glTextureStorage3D(shadowMap.texture, 1, GL_DEPTH_COMPONENT32F, resolution, resolution, layerCount);
+
+        // Hardware depth comparison with bilinear filtering gives 2x2 PCF for free
+        glTextureParameteri(shadowMap.texture, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTextureParameteri(shadowMap.texture, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glTextureParameteri(shadowMap.texture, GL_TEXTURE_COMPARE_MODE, GL_COMPARE_REF_TO_TEXTURE);
+        glTextureParameteri(shadowMap.texture, GL_TEXTURE_COMPARE_FUNC, GL_LEQUAL);
+
+        // Anything outside the map is unshadowed
+        const f32 borderColor[] = { 1.0f, 1.0f, 1.0f, 1.0f };
+        glTextureParameteri(shadowMap.texture, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_BORDER);
+        glTextureParameteri(shadowMap.texture, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_BORDER);
+        glTextureParameterfv(shadowMap.texture, GL_TEXTURE_BORDER_COLOR, borderColor);
+
+        glCreateFramebuffers(1, &shadowMap.framebuffer);
+        glNamedFramebufferDrawBuffer(shadowMap.framebuffer, GL_NONE);
+        glNamedFramebufferReadBuffer(shadowMap.framebuffer, GL_NONE);
+
+        // Start cleared, so layers that are never rendered do not shadow anything. Clears respect the depth mask.
+        m_stateCache.setDepthWrite(true);
+        for (u32 layer = 0; layer < layerCount; ++layer)
+        {
+            const f32 clearDepth = 1.0f;
+            glNamedFramebufferTextureLayer(shadowMap.framebuffer, GL_DEPTH_ATTACHMENT, shadowMap.texture, 0, static_cast<GLint>(layer));
+            glClearNamedFramebufferfv(shadowMap.framebuffer, GL_DEPTH, 0, &clearDepth);
+        }
+
+        return m_shadowMapStorage.add(shadowMap);
+    }
+
+    void Renderer_OpenGL::destroyShadowMap(const u32 id)
+    {
+        auto& shadowMap = m_shadowMapStorage.get(id);
+        glDeleteFramebuffers(1, &shadowMap.framebuffer);
+        glDeleteTextures(1, &shadowMap.texture);
+        m_stateCache.reset();
+
+        m_shadowMapStorage.remove(id);
+    }
+
+    void Renderer_OpenGL::copyShadowMap(const u32 srcId, const u32 dstId)
+    {
+        const auto& src = m_shadowMapStorage.get(srcId);
+        const auto& dst = m_shadowMapStorage.get(dstId);
+        RUNE_ENG_ASSERT(src.resolution == dst.resolution && src.layerCount == dst.layerCount, "Shadow maps must match to be copied!");
+
+        const auto res = static_cast<GLsizei>(src.resolution);
+        glCopyImageSubData(src.texture,
+                           GL_TEXTURE_2D_ARRAY,
+                           0,
+                           0,
+                           0,
+                           0,
+                           dst.texture,
+                           GL_TEXTURE_2D_ARRAY,
+                           0,
+                           0,
+                           0,
+                           0,
+                           res,
+                           res,
+                           static_cast<GLsizei>(src.layerCount));
+    }
+
+    void Renderer_OpenGL::beginShadowPass(const u32 shadowMapId, const u32 layer, const bool clear)
+    {
+        const auto& shadowMap = m_shadowMapStorage.get(shadowMapId);
+        RUNE_ENG_ASSERT(layer < shadowMap.layerCount, "Shadow map layer out of range!");
+
+        glNamedFramebufferTextureLayer(shadowMap.framebuffer, GL_DEPTH_ATTACHMENT, shadowMap.texture, 0, static_cast<GLint>(layer));
+        glBindFramebuffer(GL_FRAMEBUFFER, shadowMap.framebuffer);
+        glViewport(0, 0, static_cast<GLsizei>(shadowMap.resolution), static_cast<GLsizei>(shadowMap.resolution));
+
+        bindDepthOnlyState(false);
+
+        glEnable(GL_POLYGON_OFFSET_FILL);
+        glPolygonOffset(ShadowSlopeBias, ShadowConstantBias);
+
+        if (clear)
+        {
+            const f32 clearDepth = 1.0f;
+            glClearNamedFramebufferfv(shadowMap.framebuffer, GL_DEPTH, 0, &clearDepth);
+        }
+
+    }
+
+    void Renderer_OpenGL::endShadowPass()
+    {
+        glDisable(GL_POLYGON_OFFSET_FILL);
+
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+        glViewport(0, 0, m_framebufferSize.x, m_framebufferSize.y);
+
+        unbindDepthOnlyState();
+    }
+
+    void Renderer_OpenGL::bindShadowMap(const u32 id, const u32 binding)
+    {
+        const auto& shadowMap = m_shadowMapStorage.get(id);
+        if (m_stateCache.bindTextureUnit(binding, shadowMap.texture))
+            ++m_frameStats.textureBinds;
+    }
+
+    void Renderer_OpenGL::beginDepthPrePass(const bool cullBackFaces)
+    {
+        bindDepthOnlyState(cullBackFaces);
+        glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+
+        glEnable(GL_POLYGON_OFFSET_FILL);
+        glPolygonOffset(DepthPrePassSlopeBias, DepthPrePassConstantBias);
+    }
+
+    void Renderer_OpenGL::endDepthPrePass()
+    {
+        glDisable(GL_POLYGON_OFFSET_FILL);
+
+        glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+        unbindDepthOnlyState();
+    }
+
+    void Renderer_OpenGL::bindDepthOnlyState(const bool cullBackFaces)
+    {
+        if (m_stateCache.useProgram(m_depthProgram))
+            ++m_frameStats.programBinds;
+
+        m_stateCache.setDepthTest(true);
+        m_stateCache.setDepthWrite(true);
+        m_stateCache.setCullFace(cullBackFaces);
+        m_stateCache.setBlend(false);
+
+        // The next material bind must switch back from the depth program
+        m_isDepthOnlyPass = true;
+        m_boundMaterial = nullptr;
+        m_boundMaterialInst = nullptr;
+
+        bindGeometryVao(VertexFormat::eFull);
+    }
+
+    void Renderer_OpenGL::unbindDepthOnlyState()
+    {
+        m_isDepthOnlyPass = false;
+
+        bindGeometryVao(VertexFormat::eFull);
+    }
+
+    void Renderer_OpenGL::bindGeometryVao(const VertexFormat format)
+    {
+        const GLuint vao = m_isDepthOnlyPass ? m_geometryArena.getPositionVao(format) : m_geometryArena.getVao(format);
+        if (m_stateCache.bindVertexArray(vao))
+            ++m_frameStats.vaoBinds;
     }
 
     /*void Renderer_OpenGL::uniformChanged(const MaterialInst* materialInst, const u32 bufferIndex, const u32 offset, const u32 size)
@@ -4,6 +4,10 @@
 
 #include "rune/graphics/graphics.hpp"
 #include "rune/utility/storage.hpp"
+#include "ring_buffer.hpp"
+#include "geometry_arena.hpp"
+#include "state_cache.hpp"
+#include "program_cache.hpp"
 
 #include <glad/glad.h>
 
@@ -28,26 +32,62 @@ namespace Rune
         auto createBuffer(size size, const void* data) -> u32 override;
         void destroyBuffer(u32 id) override;
         void updateBuffer(u32 id, size offset, size size, const void* data) override;
+        void updateBufferRanges(const std::vector<BufferRangeUpdate>& ranges, const void* data, size dataSize) override;
 
-        auto createMesh(const std::vector<Vertex>& vertices, const std::vector<u16>& indices, MeshTopology topology) -> u32 override;
+        auto uploadFrameData(const void* data, size size) -> FrameDataRange override;
+
+        auto createMesh(const std::vector<Vertex>& vertices,
+                        const std::vector<u32>& indices,
+                        IndexType indexType,
+                        const VertexEncoding& encoding,
+                        MeshTopology topology) -> u32 override;
         void destroyMesh(u32 id) override;
-        void updateMeshVertices(u32 id, const std::vector<Vertex>& vertices) override;
-        void updateMeshIndices(u32 id, const std::vector<u16>& indices) override;
+        void updateMeshVertices(u32 id, const std::vector<Vertex>& vertices, const VertexEncoding& encoding) override;
+        void updateMeshIndices(u32 id, const std::vector<u32>& indices, IndexType indexType) override;
 
         auto createMaterial(const std::vector<u8>& vertexCode, const std::vector<u8>& fragmentCode) -> u32 override;
         void destroyMaterial(u32 id) override;
+        void setProgramCacheDirectory(const std::string& directory) override;
 
-        auto createTexture(u32 width, u32 height, TextureFormat format, const void* data) -> u32 override;
+        auto createTexture(u32 width, u32 height, TextureFormat format, u32 mipCount) -> u32 override;
         void destroyTexture(u32 id) override;
+        void uploadTextureMip(u32 id, u32 mip, const void* data) override;
+        void setTextureResidentMip(u32 id, u32 mip) override;
+
+        auto createTextureArray(u32 width, u32 height, TextureFormat format, u32 mipCount, u32 layerCount) -> u32 override;
+        void destroyTextureArray(u32 id) override;
+        void uploadTextureArrayMip(u32 id, u32 layer, u32 mip, const void* data) override;
 
         void beginFrame() override;
         void endFrame() override;
 
         void bindUniformBuffer(u32 id, u32 binding) override;
+        void bindStorageBuffer(u32 id, u32 binding) override;
+        void bindFrameUniformBuffer(const FrameDataRange& range, u32 binding) override;
+        void bindFrameStorageBuffer(const FrameDataRange& range, u32 binding) override;
         void bindMaterial(MaterialInst* material) override;
-        void bindMesh(Mesh* mesh) override;
+        void bindMesh(Mesh* mesh, u32 lod, u32 submesh) override;
 
         void draw() override;
+        void drawInstanced(u32 instanceCount, u32 firstInstance) override;
+        void drawIndirect(const DrawCommand* commands, u32 count) override;
+
+        auto createShadowMap(u32 resolution, u32 layerCount) -> u32 override;
+        void destroyShadowMap(u32 id) override;
+        void copyShadowMap(u32 srcId, u32 dstId) override;
+        void beginShadowPass(u32 shadowMapId, u32 layer, bool clear) override;
+        void endShadowPass() override;
+        void bindShadowMap(u32 id, u32 binding) override;
+
+        void beginDepthPrePass(bool cullBackFaces) override;
+        void endDepthPrePass() override;
+
+    private:
+        /* Switch to the depth program and position-only geometry for shadow and depth pre-passes */
+        void bindDepthOnlyState(bool cullBackFaces);
+        void unbindDepthOnlyState();
+        /* Bind the arena VAO reading the format, position-only during depth-only passes */
+        void bindGeometryVao(VertexFormat format);
 
     private:
         struct Buffer
@@ -60,23 +100,56 @@ namespace Rune
         struct Mesh
         {
             GLenum topology;
-            GLuint vao;
-            u32 indexBuffer;
-            u32 vertexBuffer;
-            GLsizei indexCount;
+            u32 geometry;  // Allocation in the geometry arena
         };
 
         struct Material
         {
             GLuint program;
-
-            bool depthTest;
-            bool doubleSided;
         };
 
         struct Texture
+        {
+            GLuint texture;  // Only holds the resident mips, its level 0 is residentMip
+            u32 width;
+            u32 height;
+            TextureFormat format;
+            u32 mipCount;
+            u32 residentMip;
+        };
+
+        struct TextureArray
+        {
+            GLuint texture;
+            u32 width;
+            u32 height;
+            TextureFormat format;
+        };
+
+        struct ShadowMap
         {
             GLuint texture;
+            GLuint framebuffer;
+            u32 resolution;
+            u32 layerCount;
+        };
+
+        /* Layout defined by GL for glMultiDrawElementsIndirect */
+        struct DrawElementsIndirectCommand
+        {
+            GLuint count;
+            GLuint instanceCount;
+            GLuint firstIndex;
+            GLint baseVertex;
+            GLuint baseInstance;
+        };
+
+        /* Commands can only share a multi-draw call if these match */
+        struct DrawCommandFormat
+        {
+            GLenum topology;
+            GLenum indexType;
+            VertexFormat vertexFormat;
         };
 
     private:
@@ -84,8 +157,26 @@ namespace Rune
         Storage<Mesh> m_meshStorage;
         Storage<Material> m_materialStorage;
         Storage<Texture> m_textureStorage;
+        Storage<TextureArray> m_textureArrayStorage;
+        Storage<ShadowMap> m_shadowMapStorage;
+
+        /* Depth-only program used by shadow passes and the depth pre-pass in place of a material */
+        GLuint m_depthProgram = 0;
+        bool m_isDepthOnlyPass = false;
+        glm::ivec2 m_framebufferSize{};
 
         Material* m_boundMaterial = nullptr;
+        MaterialInst* m_boundMaterialInst = nullptr;
         Mesh* m_boundMesh = nullptr;
+        /* Index range of the bound LOD and submesh, relative to the mesh's first index */
+        u32 m_boundFirstIndex = 0;
+        u32 m_boundIndexCount = 0;
+
+        StateCache_OpenGL m_stateCache;
+        ProgramCache_OpenGL m_programCache;
+        GeometryArena_OpenGL m_geometryArena;
+        RingBuffer_OpenGL m_frameRingBuffer;
+        std::vector<DrawElementsIndirectCommand> m_indirectCommands;
+        std::vector<DrawCommandFormat> m_indirectCommandFormats;
     };
 }
@@ -0,0 +1,183 @@
+// # Copyright  Stuart Millman <stu.millman15@gmail.com>
+
+#include "pch.hpp"
+#include "ring_buffer.hpp"
+
+#include "rune/macros.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+namespace Rune
+{
+    namespace
+    {
+        auto alignUp(const size value, const size alignment) -> size
+        {
+            return (value + alignment - 1) / alignment * alignment;
+        }
+    }
+
+    void RingBuffer_OpenGL::init(const size regionSize)
+    {
+        GLint uniformAlignment = 0;
+        glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &uniformAlignment);
+        GLint storageAlignment = 0;
+        glGetIntegerv(GL_SHADER_STORAGE_BUFFER_OFFSET_ALIGNMENT, &storageAlignment);
+        m_alignment = std::max<size>({ 16, static_cast<size>(uniformAlignment), static_cast<size>(storageAlignment) });
+
+        createStorage(regionSize);
+    }
+
+    void RingBuffer_OpenGL::cleanup()
+    {
+        releaseRetiredBuffers(true);
+        destroyStorage();
+    }
+
+    auto RingBuffer_OpenGL::write(const void* data, const size dataSize) -> Allocation
+    {
+        RUNE_ENG_ASSERT(m_buffer != 0, "Ring buffer has not been initialised!");
+
+        if (m_regionNeedsWait)
+        {
+            waitForRegion(m_regionIndex);
+            m_regionNeedsWait = false;
+        }
+
+        auto offset = alignUp(m_regionOffset, m_alignment);
+        if (offset + dataSize > m_regionSize)
+        {
+            // Ranges written earlier this frame may still be bound, so the region can never wrap
+            grow(dataSize);
+            offset = 0;
+        }
+
+        const size bufferOffset = m_regionIndex * m_regionSize + offset;
+        std::memcpy(m_mappedData + bufferOffset, data, dataSize);
+        m_regionOffset = offset + dataSize;
+
+        return { m_buffer, bufferOffset };
+    }
+
+    void RingBuffer_OpenGL::nextFrame()
+    {
+        if (m_fences[m_regionIndex] != nullptr)
+            glDeleteSync(m_fences[m_regionIndex]);
+        m_fences[m_regionIndex] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+
+        for (auto& retired : m_retiredBuffers)
+        {
+            if (retired.fence == nullptr)
+                retired.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        }
+        releaseRetiredBuffers(false);
+
+        m_regionIndex = (m_regionIndex + 1) % FramesInFlight;
+        m_regionOffset = 0;
+        m_regionNeedsWait = true;
+    }
+
+    void RingBuffer_OpenGL::createStorage(const size regionSize)
+    {
+        m_regionSize = alignUp(regionSize, m_alignment);
+
+        constexpr GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+        const auto bufferSize = static_cast<GLsizeiptr>(m_regionSize * FramesInFlight);
+
+        glCreateBuffers(1, &m_buffer);
+        glNamedBufferStorage(m_buffer, bufferSize, nullptr, flags);
+        m_mappedData = static_cast<u8*>(glMapNamedBufferRange(m_buffer, 0, bufferSize, flags));
+        RUNE_ENG_ASSERT(m_mappedData != nullptr, "Failed to map frame ring buffer!");
+
+        m_regionIndex = 0;
+        m_regionOffset = 0;
+        m_regionNeedsWait = false;
+    }
+
+    void RingBuffer_OpenGL::destroyStorage()
+    {
+        destroyFences();
+
+        if (m_buffer != 0)
+        {
+            glUnmapNamedBuffer(m_buffer);
+            glDeleteBuffers(1, &m_buffer);
+        }
+        m_buffer = 0;
+        m_mappedData = nullptr;
+    }
+
+    void RingBuffer_OpenGL::destroyFences()
+    {
+        for (auto& fence : m_fences)
+        {
+            if (fence != nullptr)
+                glDeleteSync(fence);
+            fence = nullptr;
+        }
+    }
+
+    void RingBuffer_OpenGL::grow(const size minRegionSize)
+    {
+        const auto newRegionSize = std::max(m_regionSize * 2, alignUp(minRegionSize, m_alignment));
+        CORE_LOG_WARN("Frame ring buffer region is full ({} bytes), growing to {} bytes", m_regionSize, newRegionSize);
+
+        // The rest of the frame goes to a new buffer. The old one is still referenced by this frame's earlier ranges and by the
+        // frames in flight, which are all covered by the fence placed on it at the end of this frame.
+        m_retiredBuffers.push_back({ m_buffer, nullptr });
+        m_buffer = 0;
+        m_mappedData = nullptr;
+        destroyFences();
+
+        createStorage(newRegionSize);
+    }
+
+    void RingBuffer_OpenGL::releaseRetiredBuffers(const bool releaseAll)
+    {
+        // At shutdown GL defers deleting a buffer until the commands using it have finished
+        std::erase_if(m_retiredBuffers,
+                      [releaseAll](RetiredBuffer& retired)
+                      {
+                          if (retired.fence != nullptr)
+                          {
+                              const auto result = glClientWaitSync(retired.fence, 0, 0);
+                              if (result != GL_ALREADY_SIGNALED && result != GL_CONDITION_SATISFIED && !releaseAll)
+                                  return false;
+                              glDeleteSync(retired.fence);
+                          }
+
+                          glUnmapNamedBuffer(retired.buffer);
+                          glDeleteBuffers(1, &retired.buffer);
+                          return true;
+                      });
+    }
+
+    void RingBuffer_OpenGL::waitForRegion(const u32 regionIndex)
+    {
+        auto& fence = m_fences[regionIndex];
+        if (fence == nullptr)
+            return;
+
+        // Flush after the first timeout so the fence is guaranteed to signal
+        GLbitfield waitFlags = 0;
+        constexpr GLuint64 timeout = 1'000'000;  // 1ms
+        while (true)
+        {
+            const auto result = glClientWaitSync(fence, waitFlags, timeout);
+            if (result == GL_ALREADY_SIGNALED || result == GL_CONDITION_SATISFIED)
+                break;
+
+            if (result == GL_WAIT_FAILED)
+            {
+                CORE_LOG_ERROR("Failed to wait on frame ring buffer fence!");
+                break;
+            }
+
+            waitFlags = GL_SYNC_FLUSH_COMMANDS_BIT;
+        }
+
+        glDeleteSync(fence);
+        fence = nullptr;
+    }
+}
@@ -0,0 +1,76 @@
+// # Copyright  Stuart Millman <stu.millman15@gmail.com>
+
+#pragma once
+
+#include "rune/defines.hpp"
+
+#include <glad/glad.h>
+
+#include <array>
+#include <vector>
+
+namespace Rune
+{
+    /**
+     * Persistently mapped buffer that per-frame data is written into linearly.
+     * It is split into one region per frame in flight, each guarded by a fence so the CPU never overwrites data the GPU may still be
+     * reading.
+     * A frame that outgrows its region continues in a new, larger buffer. The old one is kept alive until the GPU is done with it.
+     */
+    class RingBuffer_OpenGL
+    {
+    public:
+        static constexpr u32 FramesInFlight = 3;
+
+        struct Allocation
+        {
+            GLuint buffer = 0;
+            size byteOffset = 0;
+        };
+
+    public:
+        void init(size regionSize);
+        void cleanup();
+
+        /**
+         * Copy data into the current frame's region.
+         * @return Buffer the data was written to and its offset within it, aligned so it can be bound as a uniform or storage buffer
+         * range. Earlier allocations of the frame stay valid if the buffer is replaced.
+         */
+        auto write(const void* data, size dataSize) -> Allocation;
+
+        /**
+         * Fence the current region and move on to the next one.
+         */
+        void nextFrame();
+
+    private:
+        void createStorage(size regionSize);
+        void destroyStorage();
+        void destroyFences();
+
+        void grow(size minRegionSize);
+        void releaseRetiredBuffers(bool releaseAll);
+
+        void waitForRegion(u32 regionIndex);
+
+    private:
+        GLuint m_buffer = 0;
+        u8* m_mappedData = nullptr;
+
+        size m_regionSize = 0;
+        size m_alignment = 0;
+
+        u32 m_regionIndex = 0;
+        size m_regionOffset = 0;
+        bool m_regionNeedsWait = false;
+        std::array<GLsync, FramesInFlight> m_fences{};
+
+        struct RetiredBuffer
+        {
+            GLuint buffer = 0;
+            GLsync fence = nullptr;  // Placed at the end of the frame the buffer was replaced in
+        };
+        std::vector<RetiredBuffer> m_retiredBuffers;
+    };
+}
@@ -21,7 +21,7 @@ namespace Rune
             case SPV_REFLECT_DESCRIPTOR_TYPE_UNIFORM_TEXEL_BUFFER: break;
             case SPV_REFLECT_DESCRIPTOR_TYPE_STORAGE_TEXEL_BUFFER: break;
             case SPV_REFLECT_DESCRIPTOR_TYPE_UNIFORM_BUFFER: return BindingType::eUniformBuffer;
-            case SPV_REFLECT_DESCRIPTOR_TYPE_STORAGE_BUFFER: break;
+            case SPV_REFLECT_DESCRIPTOR_TYPE_STORAGE_BUFFER: return BindingType::eStorageBuffer;
             case SPV_REFLECT_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC: break;
             case SPV_REFLECT_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC: break;
             case SPV_REFLECT_DESCRIPTOR_TYPE_INPUT_ATTACHMENT: break;
@@ -67,6 +67,8 @@ namespace Rune
                 binding.binding = reflectedBinding->binding;
                 binding.name = reflectedBinding->name;
                 binding.type = toUniformType(reflectedBinding->descriptor_type);
+                if (binding.type == BindingType::eTexture && reflectedBinding->image.arrayed != 0)
+                    binding.type = BindingType::eTextureArray;
 
                 binding.bufferSize = reflectedBinding->block.size;
 
@@ -79,6 +81,7 @@ namespace Rune
 
                     auto& member = binding.bufferMembers[memberIndex];
                     member.name = reflectedMember.name;
+                    member.id = ShaderReflection::getMemberId(binding.name, member.name);
                     member.byteOffset = reflectedMember.offset;
                     member.byteSize = reflectedMember.size;
                 }
@@ -0,0 +1,192 @@
+// # Copyright  Stuart Millman <stu.millman15@gmail.com>
+
+#include "pch.hpp"
+#include "state_cache.hpp"
+
+namespace Rune
+{
+    namespace
+    {
+        /* Never a valid GL object name, so compares unequal to anything actually bound */
+        constexpr GLuint UnknownObject = ~0u;
+    }
+
+    void StateCache_OpenGL::reset()
+    {
+        m_program = UnknownObject;
+        m_vao = UnknownObject;
+        m_drawIndirectBuffer = UnknownObject;
+        m_textureUnits.clear();
+        m_uniformBuffers.clear();
+        m_storageBuffers.clear();
+
+        m_depthTest = Toggle::eUnknown;
+        m_depthWrite = Toggle::eUnknown;
+        m_cullFace = Toggle::eUnknown;
+        m_blend = Toggle::eUnknown;
+    }
+
+    void StateCache_OpenGL::forgetTexture(const GLuint texture)
+    {
+        for (auto& unitTexture : m_textureUnits)
+        {
+            if (unitTexture == texture)
+                unitTexture = UnknownObject;
+        }
+    }
+
+    bool StateCache_OpenGL::useProgram(const GLuint program)
+    {
+        if (m_program == program)
+        {
+            ++m_skippedCount;
+            return false;
+        }
+
+        glUseProgram(program);
+        m_program = program;
+        return true;
+    }
+
+    bool StateCache_OpenGL::bindVertexArray(const GLuint vao)
+    {
+        if (m_vao == vao)
+        {
+            ++m_skippedCount;
+            return false;
+        }
+
+        glBindVertexArray(vao);
+        m_vao = vao;
+        return true;
+    }
+
+    bool StateCache_OpenGL::bindTextureUnit(const u32 unit, const GLuint texture)
+    {
+        if (m_textureUnits.size() <= unit)
+            m_textureUnits.resize(unit + 1, UnknownObject);
+
+        if (m_textureUnits[unit] == texture)
+        {
+            ++m_skippedCount;
+            return false;
+        }
+
+        glBindTextureUnit(unit, texture);
+        m_textureUnits[unit] = texture;
+        return true;
+    }
+
+    bool StateCache_OpenGL::bindBuffer(const GLenum target, const GLuint buffer)
+    {
+        // Only the indirect buffer is bound outside of DSA calls
+        if (target == GL_DRAW_INDIRECT_BUFFER)
+        {
+            if (m_drawIndirectBuffer == buffer)
+            {
+                ++m_skippedCount;
+                return false;
+            }
+            m_drawIndirectBuffer = buffer;
+        }
+
+        glBindBuffer(target, buffer);
+        return true;
+    }
+
+    bool StateCache_OpenGL::bindBufferBase(const GLenum target, const u32 binding, const GLuint buffer)
+    {
+        auto& bindings = getIndexedBindings(target);
+        if (!bindIndexedBuffer(bindings, binding, { buffer, 0, 0 }))
+            return false;
+
+        glBindBufferBase(target, binding, buffer);
+        return true;
+    }
+
+    bool StateCache_OpenGL::bindBufferRange(
+        const GLenum target, const u32 binding, const GLuint buffer, const GLintptr offset, const GLsizeiptr size)
+    {
+        auto& bindings = getIndexedBindings(target);
+        if (!bindIndexedBuffer(bindings, binding, { buffer, offset, size }))
+            return false;
+
+        glBindBufferRange(target, binding, buffer, offset, size);
+        return true;
+    }
+
+    bool StateCache_OpenGL::setDepthTest(const bool enabled)
+    {
+        return setCapability(GL_DEPTH_TEST, m_depthTest, enabled);
+    }
+
+    bool StateCache_OpenGL::setDepthWrite(const bool enabled)
+    {
+        const auto state = enabled ? Toggle::eEnabled : Toggle::eDisabled;
+        if (m_depthWrite == state)
+        {
+            ++m_skippedCount;
+            return false;
+        }
+
+        glDepthMask(enabled ? GL_TRUE : GL_FALSE);
+        m_depthWrite = state;
+        return true;
+    }
+
+    bool StateCache_OpenGL::setCullFace(const bool enabled)
+    {
+        return setCapability(GL_CULL_FACE, m_cullFace, enabled);
+    }
+
+    bool StateCache_OpenGL::setBlend(const bool enabled)
+    {
+        return setCapability(GL_BLEND, m_blend, enabled);
+    }
+
+    auto StateCache_OpenGL::takeSkippedCount() -> u32
+    {
+        const auto skippedCount = m_skippedCount;
+        m_skippedCount = 0;
+        return skippedCount;
+    }
+
+    bool StateCache_OpenGL::setCapability(const GLenum capability, Toggle& state, const bool enabled)
+    {
+        const auto newState = enabled ? Toggle::eEnabled : Toggle::eDisabled;
+        if (state == newState)
+        {
+            ++m_skippedCount;
+            return false;
+        }
+
+        if (enabled)
+            glEnable(capability);
+        else
+            glDisable(capability);
+
+        state = newState;
+        return true;
+    }
+
+    bool StateCache_OpenGL::bindIndexedBuffer(std::vector<BufferBinding>& bindings, const u32 binding, const BufferBinding& value)
+    {
+        if (bindings.size() <= binding)
+            bindings.resize(binding + 1, { UnknownObject, 0, 0 });
+
+        auto& current = bindings[binding];
+        if (current.buffer == value.buffer && current.offset == value.offset && current.size == value.size)
+        {
+            ++m_skippedCount;
+            return false;
+        }
+
+        current = value;
+        return true;
+    }
+
+    auto StateCache_OpenGL::getIndexedBindings(const GLenum target) -> std::vector<BufferBinding>&
+    {
+        return target == GL_SHADER_STORAGE_BUFFER ? m_storageBuffers : m_uniformBuffers;
+    }
+}
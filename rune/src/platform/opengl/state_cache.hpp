@@ -0,0 +1,81 @@
+// # Copyright  Stuart Millman <stu.millman15@gmail.com>
+
+#pragma once
+
+#include "rune/defines.hpp"
+
+#include <glad/glad.h>
+
+#include <vector>
+
+namespace Rune
+{
+    /**
+     * Shadow copy of the GL binding and pipeline state, used to skip calls that would not change anything.
+     * State changed without going through the cache must be followed by a reset().
+     */
+    class StateCache_OpenGL
+    {
+    public:
+        /**
+         * Forget all known state, so the next call of each kind is always issued.
+         */
+        void reset();
+        /**
+         * Forget the units a texture is bound to, once it is deleted and GL may hand its name out again.
+         */
+        void forgetTexture(GLuint texture);
+
+        /* Each returns true if the GL call was issued */
+        bool useProgram(GLuint program);
+        bool bindVertexArray(GLuint vao);
+        bool bindTextureUnit(u32 unit, GLuint texture);
+        bool bindBuffer(GLenum target, GLuint buffer);
+        bool bindBufferBase(GLenum target, u32 binding, GLuint buffer);
+        bool bindBufferRange(GLenum target, u32 binding, GLuint buffer, GLintptr offset, GLsizeiptr size);
+
+        bool setDepthTest(bool enabled);
+        bool setDepthWrite(bool enabled);
+        bool setCullFace(bool enabled);
+        bool setBlend(bool enabled);
+
+        /**
+         * @return Number of calls skipped since the last call, which resets the count.
+         */
+        auto takeSkippedCount() -> u32;
+
+    private:
+        struct BufferBinding
+        {
+            GLuint buffer;
+            GLintptr offset;
+            GLsizeiptr size;
+        };
+
+        enum class Toggle : u8
+        {
+            eUnknown,
+            eDisabled,
+            eEnabled
+        };
+
+        bool setCapability(GLenum capability, Toggle& state, bool enabled);
+        bool bindIndexedBuffer(std::vector<BufferBinding>& bindings, u32 binding, const BufferBinding& value);
+        auto getIndexedBindings(GLenum target) -> std::vector<BufferBinding>&;
+
+    private:
+        GLuint m_program{};
+        GLuint m_vao{};
+        GLuint m_drawIndirectBuffer{};
+        std::vector<GLuint> m_textureUnits;
+        std::vector<BufferBinding> m_uniformBuffers;
+        std::vector<BufferBinding> m_storageBuffers;
+
+        Toggle m_depthTest = Toggle::eUnknown;
+        Toggle m_depthWrite = Toggle::eUnknown;
+        Toggle m_cullFace = Toggle::eUnknown;
+        Toggle m_blend = Toggle::eUnknown;
+
+        u32 m_skippedCount = 0;
+    };
+}
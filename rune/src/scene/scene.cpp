@@ -28,17 +28,33 @@ namespace Rune
             }
         }
 
+        GraphicsSystem::getInstance().setDepthPrePassEnabled(m_depthPrePassEnabled);
+
         {
             auto view = m_registry.view<Transform, MeshRenderer>();
             for (const auto& entity : view)
             {
                 auto [transform, renderer] = view.get(entity);
 
-                GraphicsSystem::getInstance().addRenderable(transform.getTransform(), renderer.mesh, renderer.material);
+                auto& graphics = GraphicsSystem::getInstance();
+                if (renderer.submeshMaterials.empty())
+                    graphics.addRenderable(transform.getTransform(), renderer.mesh, renderer.material, false, &renderer.lod);
+                else
+                    graphics.addRenderable(transform.getTransform(), renderer.mesh, renderer.submeshMaterials, false, &renderer.lod);
             }
         }
     }
 
+    bool Scene::isDepthPrePassEnabled() const
+    {
+        return m_depthPrePassEnabled;
+    }
+
+    void Scene::setDepthPrePassEnabled(const bool enabled)
+    {
+        m_depthPrePassEnabled = enabled;
+    }
+
     auto Scene::getRegistry() -> entt::registry&
     {
         return m_registry;
@@ -4,6 +4,7 @@
 #include "rune/scripting/script_glue.hpp"
 
 #include "rune/macros.hpp"
+#include "rune/graphics/graphics.hpp"
 #include "rune/input/input.hpp"
 #include "rune/scene/components.hpp"
 #include "rune/scene/entity.hpp"
@@ -62,6 +63,11 @@ namespace Rune
         return InputSystem::getInstance().isKeyHeld(key);
     }
 
+    static void Graphics_GetLastFrameStats(RenderStats* outStats)
+    {
+        *outStats = GraphicsSystem::getInstance().getLastFrameStats();
+    }
+
     void ScriptGlue::registerFunctions()
     {
         RUNE_ADD_INTERNAL_CALL(NativeLog);
@@ -70,5 +76,6 @@ namespace Rune
         RUNE_ADD_INTERNAL_CALL(Entity_GetTranslation);
         RUNE_ADD_INTERNAL_CALL(Entity_SetTranslation);
         RUNE_ADD_INTERNAL_CALL(Input_IsKeyHeld);
+        RUNE_ADD_INTERNAL_CALL(Graphics_GetLastFrameStats);
     }
 }
@@ -0,0 +1,139 @@
+// # Copyright  Stuart Millman <stu.millman15@gmail.com>
+
+#include "pch.hpp"
+#include "rune/utility/range_allocator.hpp"
+
+#include "rune/macros.hpp"
+
+namespace Rune
+{
+    void RangeAllocator::init(const u32 capacity)
+    {
+        m_capacity = capacity;
+        m_usedCount = 0;
+        m_freeByOffset.clear();
+        m_freeByCount.clear();
+
+        if (capacity > 0)
+            addFreeRange(0, capacity);
+    }
+
+    bool RangeAllocator::allocate(const u32 count, u32& outOffset)
+    {
+        if (count == 0)
+        {
+            outOffset = 0;
+            return true;
+        }
+
+        // Smallest free range that fits
+        const auto bestIt = m_freeByCount.lower_bound(count);
+        if (bestIt == m_freeByCount.end())
+            return false;
+
+        const u32 rangeOffset = bestIt->second;
+        const u32 rangeCount = bestIt->first;
+        removeFreeRange(m_freeByOffset.find(rangeOffset));
+
+        if (rangeCount > count)
+            addFreeRange(rangeOffset + count, rangeCount - count);
+
+        m_usedCount += count;
+        outOffset = rangeOffset;
+        return true;
+    }
+
+    void RangeAllocator::free(u32 offset, u32 count)
+    {
+        if (count == 0)
+            return;
+
+        RUNE_ENG_ASSERT(offset + count <= m_capacity, "Freed range is outside of the allocator!");
+        m_usedCount -= count;
+
+        // Merge with the following range
+        auto nextIt = m_freeByOffset.find(offset + count);
+        if (nextIt != m_freeByOffset.end())
+        {
+            count += nextIt->second;
+            removeFreeRange(nextIt);
+        }
+
+        // Merge with the preceding range
+        auto prevIt = m_freeByOffset.lower_bound(offset);
+        if (prevIt != m_freeByOffset.begin())
+        {
+            --prevIt;
+            if (prevIt->first + prevIt->second == offset)
+            {
+                offset = prevIt->first;
+                count += prevIt->second;
+                removeFreeRange(prevIt);
+            }
+        }
+
+        addFreeRange(offset, count);
+    }
+
+    void RangeAllocator::grow(const u32 newCapacity)
+    {
+        if (newCapacity <= m_capacity)
+            return;
+
+        const u32 oldCapacity = m_capacity;
+        m_capacity = newCapacity;
+
+        // Counted as used so that free() can merge the new space with a free range at the old end
+        m_usedCount += newCapacity - oldCapacity;
+        free(oldCapacity, newCapacity - oldCapacity);
+    }
+
+    auto RangeAllocator::getCapacity() const -> u32
+    {
+        return m_capacity;
+    }
+
+    auto RangeAllocator::getUsedCount() const -> u32
+    {
+        return m_usedCount;
+    }
+
+    auto RangeAllocator::getFreeCount() const -> u32
+    {
+        return m_capacity - m_usedCount;
+    }
+
+    auto RangeAllocator::getFragmentedCount() const -> u32
+    {
+        u32 tailCount = 0;
+        if (!m_freeByOffset.empty())
+        {
+            const auto& [lastOffset, lastCount] = *m_freeByOffset.rbegin();
+            if (lastOffset + lastCount == m_capacity)
+                tailCount = lastCount;
+        }
+
+        return getFreeCount() - tailCount;
+    }
+
+    void RangeAllocator::addFreeRange(const u32 offset, const u32 count)
+    {
+        m_freeByOffset.emplace(offset, count);
+        m_freeByCount.emplace(count, offset);
+    }
+
+    void RangeAllocator::removeFreeRange(const std::map<u32, u32>::iterator it)
+    {
+        auto [first, last] = m_freeByCount.equal_range(it->second);
+        for (; first != last; ++first)
+        {
+            if (first->second == it->first)
+            {
+                m_freeByCount.erase(first);
+                break;
+            }
+        }
+
+        m_freeByOffset.erase(it);
+    }
+}
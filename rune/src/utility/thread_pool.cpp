@@ -0,0 +1,118 @@
+// # Copyright  Stuart Millman <stu.millman15@gmail.com>
+
+#include "pch.hpp"
+#include "rune/utility/thread_pool.hpp"
+
+namespace Rune
+{
+    ThreadPool::~ThreadPool()
+    {
+        cleanup();
+    }
+
+    void ThreadPool::init(u32 workerCount)
+    {
+        cleanup();
+
+        if (workerCount == 0)
+        {
+            const u32 hardwareThreads = std::thread::hardware_concurrency();
+            workerCount = hardwareThreads > 1 ? hardwareThreads - 1 : 0;
+        }
+
+        m_isStopping = false;
+        m_workers.reserve(workerCount);
+        for (u32 i = 0; i < workerCount; ++i)
+        {
+            m_workers.emplace_back(&ThreadPool::workerLoop, this);
+        }
+    }
+
+    void ThreadPool::cleanup()
+    {
+        {
+            std::lock_guard lock(m_mutex);
+            m_isStopping = true;
+        }
+        m_wakeCondition.notify_all();
+
+        for (auto& worker : m_workers)
+        {
+            worker.join();
+        }
+        m_workers.clear();
+    }
+
+    void ThreadPool::parallelFor(const u32 count, const std::function<void(u32)>& func)
+    {
+        if (count == 0)
+            return;
+
+        // Not worth waking the workers for a single index
+        if (m_workers.empty() || count == 1)
+        {
+            for (u32 i = 0; i < count; ++i)
+            {
+                func(i);
+            }
+            return;
+        }
+
+        {
+            std::lock_guard lock(m_mutex);
+            m_job = &func;
+            m_jobCount = count;
+            m_nextIndex = 0;
+            m_busyWorkers = static_cast<u32>(m_workers.size());
+            ++m_jobGeneration;
+        }
+        m_wakeCondition.notify_all();
+
+        runJob();
+
+        std::unique_lock lock(m_mutex);
+        m_doneCondition.wait(lock, [this] { return m_busyWorkers == 0; });
+        m_job = nullptr;
+    }
+
+    auto ThreadPool::getThreadCount() const -> u32
+    {
+        return static_cast<u32>(m_workers.size()) + 1;
+    }
+
+    void ThreadPool::workerLoop()
+    {
+        u64 lastGeneration = 0;
+        while (true)
+        {
+            {
+                std::unique_lock lock(m_mutex);
+                m_wakeCondition.wait(lock, [&] { return m_isStopping || m_jobGeneration != lastGeneration; });
+                if (m_isStopping)
+                    return;
+
+                lastGeneration = m_jobGeneration;
+            }
+
+            runJob();
+
+            {
+                std::lock_guard lock(m_mutex);
+                --m_busyWorkers;
+            }
+            m_doneCondition.notify_one();
+        }
+    }
+
+    void ThreadPool::runJob()
+    {
+        while (true)
+        {
+            const u32 index = m_nextIndex.fetch_add(1);
+            if (index >= m_jobCount)
+                break;
+
+            (*m_job)(index);
+        }
+    }
+}
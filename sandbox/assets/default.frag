@@ -3,6 +3,7 @@
 layout(location = 0) in vec3 in_fragPos;
 layout(location = 1) in vec2 in_uv;
 layout(location = 2) in vec3 in_norm;
+layout(location = 3) flat in float in_textureLayer;
 
 layout (location = 0) out vec4 out_fragColor;
 
@@ -15,28 +16,70 @@ struct Light
 	float constant;
 	float linear;
 	float quadratic;
+	float range;
 
 	vec4 diffuse;
 	vec4 specular;
 };
 
-#define MAX_LIGHTS 32
+#define MAX_GLOBAL_LIGHTS 32
 layout(std140, binding = 1) uniform Lighting
 {
 	vec4 viewPos;
 	vec3 ambient;
 
-	int lightCount;
-	Light lights[MAX_LIGHTS];
+	int globalLightCount;
+	Light globalLights[MAX_GLOBAL_LIGHTS];
+
+	uvec4 clusterGrid;		// Tile count x/y, slice count, clustered light count
+	vec4 clusterDepth;		// Near, far, slice scale, slice bias
+	vec4 clusterTileScale;	// Framebuffer pixels to tiles
 } u_lighting;
 
+layout(std430, binding = 5) readonly buffer Lights
+{
+	Light lights[];
+} u_lights;
+
+struct LightCluster
+{
+	uint offset;
+	uint count;
+};
+
+layout(std430, binding = 6) readonly buffer LightClusters
+{
+	LightCluster clusters[];
+} u_lightClusters;
+
+layout(std430, binding = 7) readonly buffer LightIndices
+{
+	uint indices[];
+} u_lightIndices;
+
+#define SHADOW_CASCADE_COUNT 4
+#define MAX_POINT_SHADOWS 4
+#define POINT_SHADOW_FACE_COUNT 6
+layout(std140, binding = 8) uniform Shadows
+{
+	mat4 cascadeViewProj[SHADOW_CASCADE_COUNT];
+	vec4 cascadeSplits;		// View depth each cascade ends at
+	mat4 pointViewProj[MAX_POINT_SHADOWS * POINT_SHADOW_FACE_COUNT];
+	ivec4 pointShadowLights;	// Clustered light index of each point shadow, -1 if unused
+	ivec4 shadowInfo;		// Global light index of the directional shadow (-1 if none), point shadow count
+} u_shadows;
+
+layout(binding = 8) uniform sampler2DArrayShadow cascadeShadowMap;
+layout(binding = 9) uniform sampler2DArrayShadow pointShadowMap;
+
 layout(std140, binding = 2) uniform Material
 {
 	vec3 diffuse;
 	float shininess;
 } u_material;
 
-layout(binding = 3) uniform sampler2D tex;
+// Packed from every instance's texture, so instances that only differ by texture can be drawn together
+layout(binding = 3) uniform sampler2DArray tex;
 
 vec3 calcLight(Light light, vec3 objectColor, vec3 fragNormal, vec3 fragPos, vec3 viewDir)
 {
@@ -49,23 +92,111 @@ vec3 calcLight(Light light, vec3 objectColor, vec3 fragNormal, vec3 fragPos, vec
 	vec3 reflectDir = reflect(-lightDir, fragNormal);
 	float spec = pow(max(dot(viewDir, reflectDir), 0.0), u_material.shininess);
 	// Combine results
-	vec3 ambient = u_lighting.ambient * objectColor;
 	vec3 diffuse = light.diffuse.xyz * diff * objectColor;
 	vec3 specular = light.specular.xyz * spec;
-	return ambient + diffuse;//  + specular;
+	return diffuse;//  + specular;
+}
+
+float calcAttenuation(Light light, vec3 fragPos)
+{
+	float dist = length(light.position - fragPos);
+	float attenuation = 1.0 / (light.constant + light.linear * dist + light.quadratic * dist * dist);
+	// Fade to zero at the light's range, which is what it was clustered by
+	float fade = clamp(1.0 - pow(dist / light.range, 4.0), 0.0, 1.0);
+	return attenuation * fade * fade;
+}
+
+float getViewDepth()
+{
+	float near = u_lighting.clusterDepth.x;
+	float far = u_lighting.clusterDepth.y;
+	float ndcDepth = gl_FragCoord.z * 2.0 - 1.0;
+	return 2.0 * near * far / (far + near - ndcDepth * (far - near));
+}
+
+float sampleShadow(sampler2DArrayShadow shadowMap, mat4 viewProj, int layer, vec3 fragPos)
+{
+	vec4 clipPos = viewProj * vec4(fragPos, 1.0);
+	vec3 coord = clipPos.xyz / clipPos.w * 0.5 + 0.5;
+	if (coord.z > 1.0)
+		return 1.0;
+	// Depth comparison against the neighbouring texels is filtered by the sampler
+	return texture(shadowMap, vec4(coord.xy, float(layer), coord.z));
+}
+
+float calcCascadeShadow(vec3 fragPos, float viewDepth)
+{
+	for(int cascade = 0; cascade < SHADOW_CASCADE_COUNT; ++cascade)
+	{
+		if (viewDepth <= u_shadows.cascadeSplits[cascade])
+			return sampleShadow(cascadeShadowMap, u_shadows.cascadeViewProj[cascade], cascade, fragPos);
+	}
+	return 1.0;
+}
+
+float calcPointShadow(uint lightIndex, vec3 lightPos, vec3 fragPos)
+{
+	for(int slot = 0; slot < u_shadows.shadowInfo.y; ++slot)
+	{
+		if (u_shadows.pointShadowLights[slot] != int(lightIndex))
+			continue;
+
+		// Faces are ordered +X, -X, +Y, -Y, +Z, -Z
+		vec3 toFrag = fragPos - lightPos;
+		vec3 absDir = abs(toFrag);
+		int face;
+		if (absDir.x >= absDir.y && absDir.x >= absDir.z)
+			face = toFrag.x >= 0.0 ? 0 : 1;
+		else if (absDir.y >= absDir.z)
+			face = toFrag.y >= 0.0 ? 2 : 3;
+		else
+			face = toFrag.z >= 0.0 ? 4 : 5;
+
+		int layer = slot * POINT_SHADOW_FACE_COUNT + face;
+		return sampleShadow(pointShadowMap, u_shadows.pointViewProj[layer], layer, fragPos);
+	}
+	return 1.0;
+}
+
+uint getClusterIndex(float viewDepth)
+{
+	uint slice = uint(max(log(viewDepth) * u_lighting.clusterDepth.z + u_lighting.clusterDepth.w, 0.0));
+	slice = min(slice, u_lighting.clusterGrid.z - 1);
+	uvec2 tile = min(uvec2(gl_FragCoord.xy * u_lighting.clusterTileScale.xy), u_lighting.clusterGrid.xy - 1);
+
+	return (slice * u_lighting.clusterGrid.y + tile.y) * u_lighting.clusterGrid.x + tile.x;
+}
+
+vec3 calcLighting(vec3 objectColor, vec3 fragNormal, vec3 fragPos, vec3 viewDir)
+{
+	vec3 color = u_lighting.ambient * objectColor;
+	float viewDepth = getViewDepth();
+	for(int i = 0; i < u_lighting.globalLightCount; ++i)
+	{
+		float shadow = i == u_shadows.shadowInfo.x ? calcCascadeShadow(fragPos, viewDepth) : 1.0;
+		color += calcLight(u_lighting.globalLights[i], objectColor, fragNormal, fragPos, viewDir) * shadow;
+	}
+
+	// Only the lights reaching this fragment's cluster
+	LightCluster cluster = u_lightClusters.clusters[getClusterIndex(viewDepth)];
+	for(uint i = 0; i < cluster.count; ++i)
+	{
+		uint lightIndex = u_lightIndices.indices[cluster.offset + i];
+		Light light = u_lights.lights[lightIndex];
+		float shadow = calcPointShadow(lightIndex, light.position, fragPos);
+		color += calcLight(light, objectColor, fragNormal, fragPos, viewDir) * calcAttenuation(light, fragPos) * shadow;
+	}
+
+	return color;
 }
 
 void main()
 {
-	vec3 objectColor = texture(tex, in_uv).xyz;
+	vec3 objectColor = texture(tex, vec3(in_uv, in_textureLayer)).xyz;
 	vec3 surfaceNormal = normalize(in_norm);
 	vec3 viewDir = normalize(u_lighting.viewPos.xyz - in_fragPos);
 
-	vec3 color = vec3(0.0);
-	for(int i = 0; i < u_lighting.lightCount; ++i)
-	{
-		color += calcLight(u_lighting.lights[i], objectColor, surfaceNormal, in_fragPos, viewDir);
-	}
+	vec3 color = calcLighting(objectColor, surfaceNormal, in_fragPos, viewDir);
 
 	// out_fragColor = vec4(u_lighting.ambient * objectColor, 1.0);
 	out_fragColor = vec4(color, 1.0);
@@ -1,8 +1,11 @@
-#version 450 core
+#version 460 core
 
 layout (location = 0) in vec3 a_pos;
 layout (location = 1) in vec2 a_uv;
-layout (location = 2) in vec3 a_norm;
+layout (location = 2) in vec3 a_norm;  // Octahedral encoded in xy for quantized meshes
+
+// Keeps depth consistent with the engine's depth-only program
+invariant gl_Position;
 
 layout(location = 0) out vec3 out_fragPos;
 layout(location = 1) out vec3 out_norm;
@@ -14,10 +17,37 @@ layout(std140, binding = 0) uniform Scene
 	mat4 worldMatrix;
 } u_scene;
 
+struct Instance
+{
+	mat4 worldMatrix;
+	vec4 positionScale;  // w is 1 when normals are octahedral encoded
+	vec4 positionOffset;
+};
+
+layout(std430, binding = 4) readonly buffer Instances
+{
+	Instance instances[];
+} u_instances;
+
+vec3 decodeOctahedral(vec2 e)
+{
+	vec3 n = vec3(e, 1.0 - abs(e.x) - abs(e.y));
+	float t = max(-n.z, 0.0);
+	n.xy += vec2(n.x >= 0.0 ? -t : t, n.y >= 0.0 ? -t : t);
+	return normalize(n);
+}
+
 void main()
 {
-	out_fragPos = vec3(u_scene.worldMatrix * vec4(a_pos, 1.0));
-	out_norm = mat3(transpose(inverse(u_scene.worldMatrix))) * a_norm;
+	Instance instance = u_instances.instances[gl_BaseInstance + gl_InstanceID];
+	mat4 worldMatrix = instance.worldMatrix;
+
+	// Quantized positions are normalized over the mesh bounds, full positions have an identity transform
+	vec3 pos = instance.positionOffset.xyz + a_pos * instance.positionScale.xyz;
+	vec3 norm = instance.positionScale.w > 0.5 ? decodeOctahedral(a_norm.xy) : a_norm;
+
+	out_fragPos = vec3(worldMatrix * vec4(pos, 1.0));
+	out_norm = mat3(transpose(inverse(worldMatrix))) * norm;
 
 	gl_Position = u_scene.projMatrix * u_scene.viewMatrix * vec4(out_fragPos, 1.0);
 }
\ No newline at end of file
@@ -16,7 +16,14 @@ project "Sandbox"
     externalincludedirs
     {
         "%{wks.location}/rune/include",
-        "%{wks.location}/rune/lib/spdlog/include"
+        "%{wks.location}/rune/lib/spdlog/include",
+        "%{wks.location}/rune/lib/glm/include"
+    }
+
+    defines
+    {
+        "GLM_FORCE_RADIANS",
+        "GLM_FORCE_LEFT_HANDED"
     }
 
     links
@@ -1,6 +1,9 @@
 // # Copyright  Stuart Millman <stu.millman15@gmail.com>
 
+#include "sort_benchmark.hpp"
+
 #include <rune.hpp>
+#include <rune/core/config.hpp>
 
 class Sandbox : public Rune::Game
 {
@@ -8,9 +11,25 @@ public:
     void init() override
     {
         LOG_TRACE("Game::init()");
+
+        auto* sortKeyCount = Rune::ConfigSystem::getInstance().get("benchmark.sort_keys");
+        if (sortKeyCount && sortKeyCount->getInt() > 0)
+            m_sortBenchmarkKeyCount = sortKeyCount->getInt();
     }
 
-    void update() override {}
+    void update() override
+    {
+        // Start once the scene is submitting draws
+        if (m_sortBenchmarkKeyCount > 0)
+        {
+            m_sortBenchmark.start(m_sortBenchmarkKeyCount);
+            m_sortBenchmarkKeyCount = 0;
+        }
+        else if (m_sortBenchmark.isRunning())
+        {
+            m_sortBenchmark.update();
+        }
+    }
 
     void cleanup() override
     {
@@ -18,6 +37,8 @@ public:
     }
 
 private:
+    SortBenchmark m_sortBenchmark;
+    size m_sortBenchmarkKeyCount = 0;
 };
 
 auto Rune::createGame() -> Game*
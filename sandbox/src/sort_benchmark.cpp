@@ -0,0 +1,139 @@
+// # Copyright  Stuart Millman <stu.millman15@gmail.com>
+
+#include "sort_benchmark.hpp"
+
+#include <rune/graphics/draw_key.hpp>
+#include <rune/maths/random.hpp>
+#include <rune/utility/radix_sort.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <vector>
+
+namespace
+{
+    struct KeyedDraw
+    {
+        u64 key;
+        u32 index;
+    };
+
+    auto countBinds(const std::vector<KeyedDraw>& draws) -> Rune::DrawBindCounts
+    {
+        Rune::DrawBindCounts counts{};
+
+        Rune::DrawKeyFields last{};
+        bool isFirst = true;
+        for (const auto& draw : draws)
+        {
+            const auto fields = Rune::DrawKey::decode(draw.key);
+            if (isFirst || fields.program != last.program)
+                ++counts.programBinds;
+            if (isFirst || fields.materialInst != last.materialInst)
+                ++counts.materialBinds;
+            if (isFirst || fields.mesh != last.mesh)
+                ++counts.meshBinds;
+
+            last = fields;
+            isFirst = false;
+        }
+
+        return counts;
+    }
+
+    void logBindCounts(const char* label, const Rune::DrawBindCounts& before, const Rune::DrawBindCounts& after)
+    {
+        LOG_INFO("[SortBenchmark] {} binds: programs {} -> {}, materials {} -> {}, meshes {} -> {}",
+                 label,
+                 before.programBinds,
+                 after.programBinds,
+                 before.materialBinds,
+                 after.materialBinds,
+                 before.meshBinds,
+                 after.meshBinds);
+    }
+}
+
+void SortBenchmark::start(const size keyCount)
+{
+    sortSyntheticKeys(keyCount);
+
+    // Submit the next frame in insertion order to capture the unsorted bind counts
+    Rune::GraphicsSystem::getInstance().setDrawSortingEnabled(false);
+    m_stage = Stage::eCaptureUnsorted;
+}
+
+void SortBenchmark::update()
+{
+    auto& graphics = Rune::GraphicsSystem::getInstance();
+
+    switch (m_stage)
+    {
+        case Stage::eIdle: break;
+        case Stage::eCaptureUnsorted:
+            m_unsortedCounts = graphics.getLastFrameBindCounts();
+            graphics.setDrawSortingEnabled(true);
+            m_stage = Stage::eCaptureSorted;
+            break;
+        case Stage::eCaptureSorted:
+            logBindCounts("Sandbox scene", m_unsortedCounts, graphics.getLastFrameBindCounts());
+            m_stage = Stage::eIdle;
+            break;
+    }
+}
+
+bool SortBenchmark::isRunning() const
+{
+    return m_stage != Stage::eIdle;
+}
+
+void SortBenchmark::sortSyntheticKeys(const size keyCount)
+{
+    // Roughly models a large scene: a few programs, many material instances and meshes, spread over depth
+    constexpr u32 programCount = 32;
+    constexpr u32 materialInstCount = 2048;
+    constexpr u32 meshCount = 1024;
+    constexpr u32 lodCount = 4;
+
+    std::vector<KeyedDraw> draws(keyCount);
+    for (size i = 0; i < keyCount; ++i)
+    {
+        const auto materialInst = Rune::Random::rangeUnsignedInt(1, materialInstCount);
+        const auto program = 1 + materialInst % programCount;
+        const auto mesh = Rune::Random::rangeUnsignedInt(1, meshCount);
+        const auto lod = Rune::Random::rangeUnsignedInt(0, lodCount - 1);
+        const auto depth = Rune::DrawKey::quantizeDepth(Rune::Random::rangeFloat(0.1f, 1000.0f));
+        const bool isTranslucent = Rune::Random::valueFloat() < 0.1f;
+
+        draws[i].key = Rune::DrawKey::encode(Rune::RenderPass::eGeometry, isTranslucent, program, materialInst, mesh, 0, lod, depth);
+        draws[i].index = static_cast<u32>(i);
+    }
+
+    using Clock = std::chrono::high_resolution_clock;
+
+    auto stdSorted = draws;
+    auto stdStart = Clock::now();
+    std::stable_sort(stdSorted.begin(), stdSorted.end(), [](const auto& a, const auto& b) { return a.key < b.key; });
+    auto stdEnd = Clock::now();
+
+    auto radixSorted = draws;
+    std::vector<KeyedDraw> scratch;
+    auto radixStart = Clock::now();
+    Rune::radixSort(radixSorted, scratch, [](const KeyedDraw& draw) { return draw.key; });
+    auto radixEnd = Clock::now();
+
+    const bool isMatching = std::equal(stdSorted.begin(),
+                                       stdSorted.end(),
+                                       radixSorted.begin(),
+                                       [](const auto& a, const auto& b) { return a.key == b.key && a.index == b.index; });
+
+    const std::chrono::duration<double, std::milli> stdTime = stdEnd - stdStart;
+    const std::chrono::duration<double, std::milli> radixTime = radixEnd - radixStart;
+    LOG_INFO("[SortBenchmark] Sorted {} keys: std::stable_sort {:.3f}ms, radixSort {:.3f}ms ({})",
+             keyCount,
+             stdTime.count(),
+             radixTime.count(),
+             isMatching ? "results match" : "RESULTS DIFFER");
+
+    logBindCounts("Synthetic", countBinds(draws), countBinds(radixSorted));
+}
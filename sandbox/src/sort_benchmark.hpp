@@ -0,0 +1,38 @@
+// # Copyright  Stuart Millman <stu.millman15@gmail.com>
+
+#pragma once
+
+#include <rune.hpp>
+#include <rune/graphics/graphics.hpp>
+
+/**
+ * Benchmarks draw key sorting.
+ * Times sorting a large set of synthetic keys, then measures the bind counts of the sandbox scene
+ * submitted in insertion order against sorted order over the following frames.
+ */
+class SortBenchmark
+{
+public:
+    void start(size keyCount);
+
+    /**
+     * Call once per frame, before the frame is rendered.
+     */
+    void update();
+
+    bool isRunning() const;
+
+private:
+    static void sortSyntheticKeys(size keyCount);
+
+private:
+    enum class Stage : u8
+    {
+        eIdle,
+        eCaptureUnsorted,
+        eCaptureSorted,
+    };
+
+    Stage m_stage = Stage::eIdle;
+    Rune::DrawBindCounts m_unsortedCounts{};
+};
@@ -0,0 +1,7 @@
+@echo off
+pushd %~dp0\..\sandbox\assets\
+for /r %%f in (*.vert *.frag) do (
+    glslangValidator -G -o "%%f.spv" "%%f"
+)
+popd
+PAUSE